@@ -0,0 +1,43 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+
+// the depth pre-pass subset of shader.vert, positions must be computed the very same way for the equal depth test of the color pass
+layout( set = 0, binding = 0 ) uniform UniformBufferObject
+{
+    mat4 view;
+    mat4 proj;
+    vec4 positionScale;
+    vec4 positionOffset;
+} ubo;
+
+struct InstanceData
+{
+    mat4 model;
+    uint materialIndex;
+};
+
+layout( std430, set = 0, binding = 2 ) readonly buffer InstanceBuffer
+{
+    InstanceData records[];
+} instances;
+
+layout( std430, set = 0, binding = 3 ) readonly buffer VisibleInstanceBuffer
+{
+    uint counts[ 4 ];
+    uint indices[];
+} visibleInstances;
+
+// set per pipeline variant, only the compact vertex layout is quantized
+layout( constant_id = 0 ) const bool dequantizePositions = true;
+
+layout( location = 0 ) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main()
+{
+    vec3 position = dequantizePositions ? inPosition * ubo.positionScale.xyz + ubo.positionOffset.xyz : inPosition;
+
+    gl_Position = ubo.proj * ubo.view * instances.records[ visibleInstances.indices[ gl_InstanceIndex ] ].model * vec4( position, 1.0 );
+}
\ No newline at end of file
@@ -4,10 +4,10 @@
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
-#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "thirdparty/stb/stb_image.h"
@@ -26,11 +26,55 @@
 #include <set>
 #include <fstream>
 #include <filesystem>
+#include <span>
+#include <sstream>
+#include <iomanip>
 #include <tuple>
 #include <array>
 #include <cstring>
 #include <chrono>
-#include <unordered_map>
+#include <limits>
+#include <numeric>
+#include <cmath>
+#include <deque>
+#include <thread>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utility>
+#include <future>
+#include <map>
+#include <type_traits>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <cerrno>
+
+extern char **environ;
+#endif
+
+// picked at compile time, /arch:AVX2 (or -mavx2) is needed for the widest one
+#if defined( __AVX2__ )
+#define VULKAN_LEARNING_SIMD_AVX2
+#include <immintrin.h>
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define VULKAN_LEARNING_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define VULKAN_LEARNING_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 struct Vertex
 {
@@ -43,16 +87,32 @@ struct Vertex
     return color == other.color && position == other.position && texturePosition == other.texturePosition;
   }
 
+  // hashes the raw component bits in one pass, adding zero folds -0 into +0 so that equal vertices keep equal hashes
   std::size_t getHash() const noexcept
   {
-    const auto positionHash = std::hash< glm::vec3 >()( position );
-    const auto colorHash = std::hash< glm::vec3 >()( color );
-    const auto texturePositionHash = std::hash< glm::vec2 >()( texturePosition );
+    const float components[]
+    {
+      position.x + 0.0f, position.y + 0.0f, position.z + 0.0f,
+      color.x + 0.0f, color.y + 0.0f, color.z + 0.0f,
+      texturePosition.x + 0.0f, texturePosition.y + 0.0f
+    };
+
+    std::uint64_t hash{ 0xcbf29ce484222325 };
+
+    for( auto &&component : components )
+    {
+      std::uint32_t bits;
+      std::memcpy( &bits, &component, sizeof( bits ) );
+
+      hash = ( hash ^ bits ) * 0x100000001b3;
+    }
 
-    const auto firstHashSet = positionHash ^ ( colorHash << 1 );
-    const auto secondHashSet = texturePositionHash;
+    // final avalanche, low bits are used as is by open addressing tables
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
 
-    return  firstHashSet ^ ( secondHashSet << 1 );
+    return static_cast< std::size_t >( hash );
   }
 
   static VkVertexInputBindingDescription getBindingDescription()
@@ -65,1929 +125,8169 @@ struct Vertex
     };
   }
 
-  static constexpr std::array< VkVertexInputAttributeDescription, 3 > getAttributeDescriptions()
+  // the color is constant white, it only takes part in vertex deduplication and is not fed to the shaders
+  static constexpr std::array< VkVertexInputAttributeDescription, 2 > getAttributeDescriptions()
   {
-    return std::array< VkVertexInputAttributeDescription, 3 >
+    return std::array< VkVertexInputAttributeDescription, 2 >
     {
       {
         {
           .location{ 0 },
-            .binding{ 0 },
-            .format{ VK_FORMAT_R32G32B32_SFLOAT },
-            .offset{ offsetof( Vertex, position ) },
+          .binding{ 0 },
+          .format{ VK_FORMAT_R32G32B32_SFLOAT },
+          .offset{ offsetof( Vertex, position ) },
         },
-          {
-            .location{ 1 },
-            .binding{ 0 },
-            .format{ VK_FORMAT_R32G32B32_SFLOAT },
-            .offset{ offsetof( Vertex, color ) }
-          },
-          {
-            .location{ 2 },
-            .binding{ 0 },
-            .format{ VK_FORMAT_R32G32_SFLOAT },
-            .offset{ offsetof( Vertex, texturePosition ) }
-          }
+        {
+          .location{ 1 },
+          .binding{ 0 },
+          .format{ VK_FORMAT_R32G32_SFLOAT },
+          .offset{ offsetof( Vertex, texturePosition ) }
+        }
       }
     };
   }
 };
 
-namespace std
+// dequantized position = stored position * scale + offset, handed to the vertex shader through the uniform buffer
+struct PositionQuantization
 {
+  glm::vec3 scale{ 1.0f };
+  glm::vec3 offset{ 0.0f };
+};
 
-template<>
-struct hash< Vertex >
+// imported vertices used as is in the vertex buffer, 32 bytes each
+struct FullVertex : Vertex
 {
-  std::size_t operator()( const Vertex &vertex ) const noexcept
+  static PositionQuantization makePositionQuantization( std::span< const Vertex > ) noexcept
   {
-    return vertex.getHash();
+    return {};
   }
-};
-
-}
-
-class VulkanApplication
-{
-public:
-  VulkanApplication( std::filesystem::path path ) : applicationPath_{ path } {}
 
-  void run()
+  static FullVertex pack( const Vertex &vertex, const PositionQuantization & ) noexcept
   {
-    initWindow();
-    initVulkan();
-    mainLoop();
-    cleanup();
+    return FullVertex{ vertex };
   }
 
-private:
-  void initWindow()
+  glm::vec3 getPosition( const PositionQuantization & ) const noexcept
   {
-    if( glfwInit() == GLFW_FALSE )
-      throw std::runtime_error{ "Error when intializing GLFW" };
-
-    glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
-    glfwWindowHint( GLFW_RESIZABLE, GLFW_TRUE );
-
-    window_ = glfwCreateWindow( windowWidth_, windowHeight_, "Vulkan", nullptr, nullptr );
+    return position;
+  }
+};
 
-    if( window_ == nullptr )
-      throw std::runtime_error{ "Error when creating GLFW window" };
+// 12 bytes: positions normalized over the mesh bounds in 16 bits snorm, half float texture coordinates that may still wrap, no color
+struct CompactVertex
+{
+  std::uint16_t position[ 4 ];
+  std::uint16_t texturePosition[ 2 ];
 
-    glfwSetWindowUserPointer( window_, this );
-    glfwSetFramebufferSizeCallback( window_, framebufferResizeCallback );
+  static VkVertexInputBindingDescription getBindingDescription()
+  {
+    return VkVertexInputBindingDescription
+    {
+      .binding{ 0 },
+      .stride{ sizeof( CompactVertex ) },
+      .inputRate{ VK_VERTEX_INPUT_RATE_VERTEX }
+    };
   }
 
-  template< typename T >
-  void mapDataInStagingBuffer( VkDeviceSize bufferSize, const T *bufferData, VkBuffer &stagingBuffer, VkDeviceMemory &stagingBufferMemory )
+  // three components 16 bits formats are seldom supported for vertex buffers, the fourth one is padding
+  static constexpr std::array< VkVertexInputAttributeDescription, 2 > getAttributeDescriptions()
   {
-    createBuffer( bufferSize,
-                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                  stagingBuffer, stagingBufferMemory );
-
-    void *data;
-    vkMapMemory( logicalDevice_, stagingBufferMemory, 0, bufferSize, 0, &data );
-    std::memcpy( data, bufferData, static_cast< size_t >( bufferSize ) );
-    vkUnmapMemory( logicalDevice_, stagingBufferMemory );
+    return std::array< VkVertexInputAttributeDescription, 2 >
+    {
+      {
+        {
+          .location{ 0 },
+          .binding{ 0 },
+          .format{ VK_FORMAT_R16G16B16A16_SNORM },
+          .offset{ offsetof( CompactVertex, position ) },
+        },
+        {
+          .location{ 1 },
+          .binding{ 0 },
+          .format{ VK_FORMAT_R16G16_SFLOAT },
+          .offset{ offsetof( CompactVertex, texturePosition ) }
+        }
+      }
+    };
   }
 
-  void createIndexBuffer()
+  static PositionQuantization makePositionQuantization( std::span< const Vertex > vertices ) noexcept
   {
-    VkDeviceSize bufferSize = sizeof( typename decltype( indices_ )::value_type ) * indices_.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    glm::vec3 minimum{ std::numeric_limits< float >::max() };
+    glm::vec3 maximum{ std::numeric_limits< float >::lowest() };
 
-    mapDataInStagingBuffer( bufferSize, indices_.data(), stagingBuffer, stagingBufferMemory );
+    for( const auto &vertex : vertices )
+    {
+      minimum = glm::min( minimum, vertex.position );
+      maximum = glm::max( maximum, vertex.position );
+    }
 
-    createBuffer( bufferSize,
-                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                  indexBuffer_,
-                  indexBufferMemory_ );
+    if( vertices.empty() )
+      return {};
 
-    copyBuffer( stagingBuffer, indexBuffer_, bufferSize );
+    const auto halfExtent = ( maximum - minimum ) * 0.5f;
 
-    vkDestroyBuffer( logicalDevice_, stagingBuffer, nullptr );
-    vkFreeMemory( logicalDevice_, stagingBufferMemory, nullptr );
+    // flat meshes keep a valid scale on their null axis
+    return PositionQuantization
+    {
+      .scale{ glm::max( halfExtent, glm::vec3{ std::numeric_limits< float >::min() } ) },
+      .offset{ ( minimum + maximum ) * 0.5f }
+    };
   }
 
-  void createDescriptorSetLayout()
+  static CompactVertex pack( const Vertex &vertex, const PositionQuantization &quantization ) noexcept
   {
-    VkDescriptorSetLayoutBinding bindings[]
+    const auto normalizedPosition = ( vertex.position - quantization.offset ) / quantization.scale;
+
+    return CompactVertex
     {
+      .position
       {
-        .binding{ 0 },
-        .descriptorType{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER },
-        .descriptorCount{ 1 },
-        .stageFlags{ VK_SHADER_STAGE_VERTEX_BIT }
+        glm::packSnorm1x16( normalizedPosition.x ),
+        glm::packSnorm1x16( normalizedPosition.y ),
+        glm::packSnorm1x16( normalizedPosition.z ),
+        0
       },
+      .texturePosition
       {
-        .binding{ 1 },
-        .descriptorType{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-        .descriptorCount{ 1 },
-        .stageFlags{ VK_SHADER_STAGE_FRAGMENT_BIT },
-        .pImmutableSamplers{ nullptr }
+        glm::packHalf1x16( vertex.texturePosition.x ),
+        glm::packHalf1x16( vertex.texturePosition.y )
       }
     };
+  }
 
-    VkDescriptorSetLayoutCreateInfo layoutInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO },
-      .bindingCount{ sizeof( bindings ) / sizeof( VkDescriptorSetLayoutBinding ) },
-      .pBindings{ bindings }
-    };
+  glm::vec3 getPosition( const PositionQuantization &quantization ) const noexcept
+  {
+    const glm::vec3 normalizedPosition( glm::unpackSnorm1x16( position[ 0 ] ), glm::unpackSnorm1x16( position[ 1 ] ), glm::unpackSnorm1x16( position[ 2 ] ) );
 
-    if( vkCreateDescriptorSetLayout( logicalDevice_, &layoutInfo, nullptr, &descriptorSetLayout_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create descriptor set layout!" };
+    return normalizedPosition * quantization.scale + quantization.offset;
   }
+};
 
-  void createUniformBuffers()
-  {
-    VkDeviceSize bufferSize = sizeof( UniformBufferObject );
+// layout of the vertex buffer chosen at compile time, FullVertex trades bandwidth for exact positions
+using GpuVertex = CompactVertex;
 
-    uniformBuffers_.resize( swapChainImages_.size() );
-    uniformBuffersMemory_.resize( swapChainImages_.size() );
+// one bit each in the key of a graphic pipeline variant
+enum class PipelineFeature : std::uint32_t
+{
+  // depth pre-pass: positions only, no fragment shader nor color writes
+  depthOnly,
+  // color pass following a depth pre-pass, depth is tested for equality and not written
+  depthEqual,
+  // CompactVertex layout, positions are dequantized in the vertex shader
+  compactVertices,
+  count
+};
 
-    for( std::size_t i = 0; i < swapChainImages_.size(); i++ )
-      createBuffer( bufferSize,
-                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                    uniformBuffers_[ i ],
-                    uniformBuffersMemory_[ i ] );
-  }
+constexpr std::uint32_t makePipelineVariantKey( std::initializer_list< PipelineFeature > features ) noexcept
+{
+  std::uint32_t key{};
 
-  void createDescriptorPool()
-  {
-    VkDescriptorPoolSize poolSizes[]
-    {
-      {
-        .type{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER },
-        .descriptorCount{ static_cast< std::uint32_t >( swapChainImages_.size() ) }
-      },
-      {
-        .type{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-        .descriptorCount{ static_cast< std::uint32_t >( swapChainImages_.size() ) }
-      }
-    };
+  for( auto feature : features )
+    key |= 1u << static_cast< std::uint32_t >( feature );
 
-    VkDescriptorPoolCreateInfo poolInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO },
-      .maxSets{ static_cast< std::uint32_t >( swapChainImages_.size() ) },
-      .poolSizeCount{ sizeof( poolSizes ) / sizeof( VkDescriptorPoolSize ) },
-      .pPoolSizes{ poolSizes }
-    };
+  return key;
+}
 
-    if( vkCreateDescriptorPool( logicalDevice_, &poolInfo, nullptr, &descriptorPool_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create descriptor pool!" };
-  }
+constexpr bool hasPipelineFeature( std::uint32_t key, PipelineFeature feature ) noexcept
+{
+  return ( key & makePipelineVariantKey( { feature } ) ) != 0;
+}
 
-  void repeatUpdateDescriptorSet( const std::size_t layoutCount )
+// Everything a variant changes in the pipeline state derives from its key at compile time: the vertex layout and the shader specialization
+// constants here, the fixed function state in VulkanApplication::createGraphicPipelineVariant
+template< std::uint32_t Key >
+struct PipelineVariant
+{
+  inline static constexpr std::uint32_t key{ Key };
+
+  using VertexLayout = std::conditional_t< hasPipelineFeature( Key, PipelineFeature::compactVertices ), CompactVertex, FullVertex >;
+
+  // in constant_id order, shared by all the stages
+  struct SpecializationConstants
   {
-    if( layoutCount == 0 )
-      return;
+    VkBool32 dequantizePositions;
+  };
 
-    const auto i = layoutCount - 1;
+  inline static constexpr SpecializationConstants specializationConstants
+  {
+    .dequantizePositions{ hasPipelineFeature( Key, PipelineFeature::compactVertices ) ? VK_TRUE : VK_FALSE }
+  };
 
-    VkDescriptorBufferInfo buffersInfo[]
+  inline static constexpr VkSpecializationMapEntry specializationMapEntries[]
+  {
     {
-      {
-        .buffer{ uniformBuffers_[ i ] },
-        .offset{ 0 },
-        .range{ sizeof( UniformBufferObject ) }
-      }
-    };
+      .constantID{ 0 },
+      .offset{ offsetof( SpecializationConstants, dequantizePositions ) },
+      .size{ sizeof( VkBool32 ) }
+    }
+  };
 
-    VkDescriptorImageInfo imagesInfo[]
+  static VkSpecializationInfo getSpecializationInfo() noexcept
+  {
+    return VkSpecializationInfo
     {
-      {
-        .sampler{ textureSampler_ },
-        .imageView{ textureImageView_ },
-        .imageLayout{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
-      }
+      .mapEntryCount{ sizeof( specializationMapEntries ) / sizeof( VkSpecializationMapEntry ) },
+      .pMapEntries{ specializationMapEntries },
+      .dataSize{ sizeof( SpecializationConstants ) },
+      .pData{ &specializationConstants }
     };
+  }
+};
 
-    VkWriteDescriptorSet descriptorWrites[]
-    {
-      {
-        .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
-        .dstSet{ descriptorSets_[ i ] },
-        .dstBinding{ 0 },
-        .dstArrayElement{ 0 },
-        .descriptorCount{ static_cast< std::uint32_t >( sizeof( buffersInfo ) / sizeof( VkDescriptorBufferInfo ) ) },
-        .descriptorType{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER },
-        .pBufferInfo{ buffersInfo }
-      },
-      {
-        .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
-        .dstSet{ descriptorSets_[ i ] },
-        .dstBinding{ 1 },
-        .dstArrayElement{ 0 },
-        .descriptorCount{ static_cast< std::uint32_t >( sizeof( imagesInfo ) / sizeof( VkDescriptorImageInfo ) ) },
-        .descriptorType{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-        .pImageInfo{ imagesInfo }
-      }
-    };
+inline constexpr std::uint32_t gpuVertexPipelineKey{ std::is_same_v< GpuVertex, CompactVertex > ? makePipelineVariantKey( { PipelineFeature::compactVertices } ) : 0 };
 
-    vkUpdateDescriptorSets( logicalDevice_, sizeof( descriptorWrites ) / sizeof( VkWriteDescriptorSet ), descriptorWrites, 0, nullptr );
+// every variant the renderer draws with, all of them built at startup so that none is ever compiled mid-frame
+using GraphicPipelineVariants = std::tuple< PipelineVariant< gpuVertexPipelineKey >,
+                                            PipelineVariant< gpuVertexPipelineKey | makePipelineVariantKey( { PipelineFeature::depthOnly } ) >,
+                                            PipelineVariant< gpuVertexPipelineKey | makePipelineVariantKey( { PipelineFeature::depthEqual } ) > >;
 
-    repeatUpdateDescriptorSet( layoutCount - 1 );
-  }
+// from a key to the index of its variant in Variants, as many as there are variants for the keys that are not built
+template< typename Variants, std::size_t... Indices >
+constexpr auto makePipelineVariantIndices( std::index_sequence< Indices... > ) noexcept
+{
+  std::array< std::size_t, std::size_t{ 1 } << static_cast< std::size_t >( PipelineFeature::count ) > indices{};
+  indices.fill( sizeof...( Indices ) );
 
-  void createDescriptorSets()
-  {
-    const auto layoutCount = swapChainImages_.size();
+  ( ( indices[ std::tuple_element_t< Indices, Variants >::key ] = Indices ), ... );
 
-    std::vector< VkDescriptorSetLayout > layouts{ layoutCount, descriptorSetLayout_ };
-    VkDescriptorSetAllocateInfo allocInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO },
-      .descriptorPool{ descriptorPool_ },
-      .descriptorSetCount{ static_cast< std::uint32_t >( layoutCount ) },
-      .pSetLayouts{ layouts.data() }
-    };
+  return indices;
+}
 
-    descriptorSets_.resize( layoutCount );
-    if( vkAllocateDescriptorSets( logicalDevice_, &allocInfo, descriptorSets_.data() ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to allocate descriptor sets!" };
+inline constexpr auto graphicPipelineVariantIndices{ makePipelineVariantIndices< GraphicPipelineVariants >( std::make_index_sequence< std::tuple_size_v< GraphicPipelineVariants > >{} ) };
+
+// changes whenever the vertex layout does, invalidating precooked mesh files
+template< typename VertexLayout >
+constexpr std::uint64_t getVertexLayoutHash() noexcept
+{
+  std::uint64_t hash{ 0xcbf29ce484222325 };
+
+  hash = ( hash ^ sizeof( VertexLayout ) ) * 0x100000001b3;
 
-    repeatUpdateDescriptorSet( layoutCount );
+  for( auto &&attribute : VertexLayout::getAttributeDescriptions() )
+  {
+    hash = ( hash ^ attribute.location ) * 0x100000001b3;
+    hash = ( hash ^ static_cast< std::uint64_t >( attribute.format ) ) * 0x100000001b3;
+    hash = ( hash ^ attribute.offset ) * 0x100000001b3;
   }
 
-  auto getTexturePixels()
+  return hash;
+}
+
+namespace std
+{
+
+template<>
+struct hash< Vertex >
+{
+  std::size_t operator()( const Vertex &vertex ) const noexcept
   {
-    auto texture = applicationPath_.parent_path() / textureRelativePath_;
+    return vertex.getHash();
+  }
+};
 
-    int width, height, texChannels;
-    stbi_uc *pixels = stbi_load( texture.string().c_str(), &width, &height, &texChannels, STBI_rgb_alpha );
-    VkDeviceSize size = static_cast< VkDeviceSize >( width ) * height * 4;
+}
 
-    if( !pixels )
-      throw std::runtime_error{ "Error failed to load texture image!" };
+// Deduplicates vertices with linear probing over slots holding a hash and a vertex index, a single probe sequence either finds or inserts
+class VertexDeduplicationTable
+{
+public:
+  explicit VertexDeduplicationTable( std::size_t expectedVertexCount )
+  {
+    std::size_t capacity{ 16 };
 
-    return TexturePixelsBuffer
-    {
-      pixels,
-      width,
-      height,
-      size
-    };
+    while( capacity * maxLoadNumerator_ < expectedVertexCount * maxLoadDenominator_ )
+      capacity *= 2;
+
+    slots_.resize( capacity );
   }
 
-  void createImage( std::uint32_t width,
-                    std::uint32_t height,
-                    VkFormat format,
-                    VkImageTiling tiling,
-                    VkImageUsageFlags usage,
-                    VkMemoryPropertyFlags memoryProperties,
-                    VkImage &image,
-                    VkDeviceMemory &imageMemory )
+  // returns the index of the vertex in vertices, appending it there when it is seen for the first time
+  std::uint32_t findOrInsert( const Vertex &vertex, std::vector< Vertex > &vertices )
   {
-    VkImageCreateInfo imageInfo
+    const auto hash = static_cast< std::uint32_t >( vertex.getHash() );
+    const auto mask = slots_.size() - 1;
+
+    for( auto slotIndex = hash & mask;; slotIndex = ( slotIndex + 1 ) & mask )
     {
-      .sType{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO },
-      .imageType{ VK_IMAGE_TYPE_2D },
-      .format{ format },
-      .extent
+      auto &slot = slots_[ slotIndex ];
+
+      if( slot.vertexIndex == emptySlot_ )
       {
-        .width{ width },
-        .height{ height },
-        .depth{ 1 }
-      },
-      .mipLevels{ 1 },
-      .arrayLayers{ 1 },
-      .samples{ VK_SAMPLE_COUNT_1_BIT },
-      .tiling{ tiling },
-      .usage{ usage },
-      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-      .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED }
-    };
+        const auto vertexIndex = static_cast< std::uint32_t >( vertices.size() );
 
-    // todo - it might be good to parameterize concurrent acess for image creation later? Here is just about implicit concurrent access from graphic and tranfert queue families
-    std::uint32_t queueFamilyIndices[]
-    {
-      requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
-      requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value()
-    };
+        slot = Slot{ hash, vertexIndex };
+        vertices.push_back( vertex );
 
-    if( requiredQueueFamilyIndices_.graphicsQueueFamilyIndex != requiredQueueFamilyIndices_.transfertQueueFamilyIndex )
-    {
-      imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
-      imageInfo.queueFamilyIndexCount = 2;
-      imageInfo.pQueueFamilyIndices = queueFamilyIndices;
+        if( ( ++size_ ) * maxLoadDenominator_ > slots_.size() * maxLoadNumerator_ )
+          grow();
+
+        return vertexIndex;
+      }
+
+      if( slot.hash == hash && vertices[ slot.vertexIndex ] == vertex )
+        return slot.vertexIndex;
     }
+  }
 
-    if( vkCreateImage( logicalDevice_, &imageInfo, nullptr, &image ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create image!" };
+private:
+  struct Slot
+  {
+    std::uint32_t hash{};
+    std::uint32_t vertexIndex{ emptySlot_ };
+  };
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements( logicalDevice_, image, &memRequirements );
+  // stored hashes are enough to move slots, vertices are never touched again
+  void grow()
+  {
+    std::vector< Slot > slots( slots_.size() * 2 );
+    const auto mask = slots.size() - 1;
 
-    VkMemoryAllocateInfo allocInfo
+    for( auto &&slot : slots_ )
     {
-      .sType{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO },
-      .allocationSize{ memRequirements.size },
-      .memoryTypeIndex{ findMemoryType( memRequirements.memoryTypeBits, memoryProperties ) }
-    };
+      if( slot.vertexIndex == emptySlot_ )
+        continue;
 
-    if( vkAllocateMemory( logicalDevice_, &allocInfo, nullptr, &imageMemory ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to allocate image memory!" };
+      auto slotIndex = slot.hash & mask;
 
-    vkBindImageMemory( logicalDevice_, image, imageMemory, 0 );
-  }
+      while( slots[ slotIndex ].vertexIndex != emptySlot_ )
+        slotIndex = ( slotIndex + 1 ) & mask;
 
-  void createTextureImage()
-  {
-    auto [texturePixels, width, height, imageSize] = getTexturePixels();
+      slots[ slotIndex ] = slot;
+    }
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer( imageSize,
-                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                  stagingBuffer,
-                  stagingBufferMemory );
+    slots_ = std::move( slots );
+  }
 
-    void *data;
-    vkMapMemory( logicalDevice_, stagingBufferMemory, 0, imageSize, 0, &data );
-    memcpy( data, texturePixels, imageSize );
-    vkUnmapMemory( logicalDevice_, stagingBufferMemory );
+  inline static constexpr std::uint32_t emptySlot_{ std::numeric_limits< std::uint32_t >::max() };
+  inline static constexpr std::size_t maxLoadNumerator_{ 3 };
+  inline static constexpr std::size_t maxLoadDenominator_{ 4 };
 
-    stbi_image_free( texturePixels );
+  std::vector< Slot > slots_;
+  std::size_t size_{};
+};
 
-    createImage( width,
-                 height,
-                 VK_FORMAT_R8G8B8A8_SRGB,
-                 VK_IMAGE_TILING_OPTIMAL,
-                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                 textureImage_, textureImageMemory_ );
-
-    transitionImageLayout( textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
-    copyBufferToImage( stagingBuffer, textureImage_, static_cast< std::uint32_t >( width ), static_cast< std::uint32_t >( height ) );
-    transitionImageLayout( textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+// Tom Forsyth's linear speed vertex cache optimisation: greedily emits the triangle whose vertices score best in a simulated LRU cache,
+// favouring recently used vertices and those with few triangles left so that no vertex is left stranded
+inline void optimizeVertexCache( std::span< std::uint32_t > indices, std::size_t vertexCount )
+{
+  constexpr int cacheSize{ 32 };
+  constexpr std::uint32_t noTriangle{ std::numeric_limits< std::uint32_t >::max() };
 
-    vkDestroyBuffer( logicalDevice_, stagingBuffer, nullptr );
-    vkFreeMemory( logicalDevice_, stagingBufferMemory, nullptr );
-  }
+  const auto triangleCount = indices.size() / 3;
 
-  void createTextureImageView()
+  const auto computeVertexScore = []( int cachePosition, std::uint32_t remainingTriangleCount )
   {
-    createImageView( textureImage_, &textureImageView_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT );
-  }
+    if( remainingTriangleCount == 0 )
+      return -1.0f;
 
-  void createTextureSampler()
-  {
-    VkSamplerCreateInfo samplerInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO },
-      .magFilter{ VK_FILTER_LINEAR },
-      .minFilter{ VK_FILTER_LINEAR },
-      .mipmapMode{ VK_SAMPLER_MIPMAP_MODE_LINEAR },
-      .addressModeU{ VK_SAMPLER_ADDRESS_MODE_REPEAT },
-      .addressModeV{ VK_SAMPLER_ADDRESS_MODE_REPEAT },
-      .addressModeW{ VK_SAMPLER_ADDRESS_MODE_REPEAT },
-      .mipLodBias{ 0 },
-      .anisotropyEnable{ VK_TRUE },
-      .maxAnisotropy{ 16 },
-      .compareEnable{ VK_FALSE },
-      .compareOp{ VK_COMPARE_OP_ALWAYS },
-      .minLod{ 0 },
-      .maxLod{ 0 },
-      .borderColor{ VK_BORDER_COLOR_INT_OPAQUE_BLACK },
-      .unnormalizedCoordinates{ VK_FALSE }
-    };
+    float score{};
 
-    if( vkCreateSampler( logicalDevice_, &samplerInfo, nullptr, &textureSampler_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create texture sampler!" };
-  }
+    // the triangle just emitted gets a fixed score whatever the order of its vertices
+    if( cachePosition >= 0 && cachePosition < 3 )
+      score = 0.75f;
+    else if( cachePosition >= 3 )
+      score = std::pow( 1.0f - static_cast< float >( cachePosition - 3 ) / ( cacheSize - 3 ), 1.5f );
 
-  VkFormat findSupportedFormat( std::initializer_list< VkFormat > &&candidates, VkImageTiling tiling, VkFormatFeatureFlags features )
-  {
-    for( VkFormat format : candidates )
-    {
-      VkFormatProperties props;
-      vkGetPhysicalDeviceFormatProperties( physicalDevice_, format, &props );
+    return score + 2.0f * std::pow( static_cast< float >( remainingTriangleCount ), -0.5f );
+  };
 
-      if( tiling == VK_IMAGE_TILING_LINEAR && ( props.linearTilingFeatures & features ) == features )
-        return format;
-      else if( tiling == VK_IMAGE_TILING_OPTIMAL && ( props.optimalTilingFeatures & features ) == features )
-        return format;
+  // vertex to remaining triangles adjacency, in compressed rows
+  std::vector< std::uint32_t > remainingTriangleCounts( vertexCount );
+
+  for( auto index : indices )
+    ++remainingTriangleCounts[ index ];
+
+  std::vector< std::uint32_t > adjacencyOffsets( vertexCount + 1 );
+
+  for( std::size_t i = 0; i < vertexCount; ++i )
+    adjacencyOffsets[ i + 1 ] = adjacencyOffsets[ i ] + remainingTriangleCounts[ i ];
+
+  std::vector< std::uint32_t > adjacentTriangles( indices.size() );
+  std::vector< std::uint32_t > fillCounts( vertexCount );
+
+  for( std::uint32_t triangle = 0; triangle < triangleCount; ++triangle )
+    for( int corner = 0; corner < 3; ++corner )
+    {
+      const auto vertex = indices[ 3 * triangle + corner ];
+      adjacentTriangles[ adjacencyOffsets[ vertex ] + fillCounts[ vertex ]++ ] = triangle;
     }
 
-    throw std::runtime_error{ "Error failed to find supported format!" };
-  }
+  std::vector< int > cachePositions( vertexCount, -1 );
+  std::vector< float > vertexScores( vertexCount );
 
-  constexpr static bool hasStencilComponent( VkFormat format ) noexcept
-  {
-    return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
-  }
+  for( std::size_t i = 0; i < vertexCount; ++i )
+    vertexScores[ i ] = computeVertexScore( -1, remainingTriangleCounts[ i ] );
 
-  VkFormat findDepthFormat()
-  {
-    return findSupportedFormat( { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
-                                VK_IMAGE_TILING_OPTIMAL,
-                                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT );
-  }
+  std::vector< float > triangleScores( triangleCount );
+  std::vector< bool > isTriangleEmitted( triangleCount );
 
-  void createDepthResources()
-  {
-    auto depthFormat = findDepthFormat();
+  for( std::size_t triangle = 0; triangle < triangleCount; ++triangle )
+    triangleScores[ triangle ] = vertexScores[ indices[ 3 * triangle ] ] + vertexScores[ indices[ 3 * triangle + 1 ] ] + vertexScores[ indices[ 3 * triangle + 2 ] ];
 
-    createImage( swapChainExtent_.width,
-                 swapChainExtent_.height,
-                 depthFormat,
-                 VK_IMAGE_TILING_OPTIMAL,
-                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                 depthImage_,
-                 depthImageMemory_ );
+  std::vector< std::uint32_t > optimizedIndices;
+  optimizedIndices.reserve( indices.size() );
 
-    createImageView( depthImage_, &depthImageView_, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT );
+  std::vector< std::uint32_t > cache;
+  std::vector< std::uint32_t > nextCache;
+  cache.reserve( cacheSize + 3 );
+  nextCache.reserve( cacheSize + 3 );
 
-    transitionImageLayout( depthImage_, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
-  }
+  std::uint32_t bestTriangle = triangleCount > 0 ? 0 : noTriangle;
+  std::uint32_t fallbackCursor{};
 
-  void loadShape( const tinyobj::shape_t &shape, const tinyobj::attrib_t &attrib )
+  while( bestTriangle != noTriangle )
   {
-    std::unordered_map< Vertex, std::uint32_t > uniqueVertices;
+    isTriangleEmitted[ bestTriangle ] = true;
+    nextCache.clear();
+
+    for( int corner = 0; corner < 3; ++corner )
+    {
+      const auto vertex = indices[ 3 * bestTriangle + corner ];
+      optimizedIndices.push_back( vertex );
+      nextCache.push_back( vertex );
+
+      // swap-removes the emitted triangle from the vertex adjacency
+      const auto begin = adjacentTriangles.begin() + adjacencyOffsets[ vertex ];
+      const auto end = begin + remainingTriangleCounts[ vertex ];
+      std::iter_swap( std::find( begin, end, bestTriangle ), end - 1 );
+      --remainingTriangleCounts[ vertex ];
+    }
 
-    for( const auto &index : shape.mesh.indices )
+    for( auto vertex : cache )
+      if( std::find( nextCache.begin(), nextCache.end(), vertex ) == nextCache.end() )
+        nextCache.push_back( vertex );
+
+    // vertices beyond the cache size are evicted, their score still has to be refreshed
+    for( std::size_t i = 0; i < nextCache.size(); ++i )
     {
-      const std::size_t vertexPositionBase = std::size_t{ 3 } *index.vertex_index;
-      const std::size_t textureCoordinateBase = std::size_t{ 2 }  *index.texcoord_index;
+      const auto vertex = nextCache[ i ];
+      cachePositions[ vertex ] = i < cacheSize ? static_cast< int >( i ) : -1;
+      vertexScores[ vertex ] = computeVertexScore( cachePositions[ vertex ], remainingTriangleCounts[ vertex ] );
+    }
 
-      const Vertex vertex
+    bestTriangle = noTriangle;
+    float bestScore{ -1.0f };
+
+    for( auto vertex : nextCache )
+      for( auto i = adjacencyOffsets[ vertex ]; i < adjacencyOffsets[ vertex ] + remainingTriangleCounts[ vertex ]; ++i )
       {
-        .color{ 1, 1, 1 },
-        .position
-        {
-          attrib.vertices[ vertexPositionBase + 0 ],
-          attrib.vertices[ vertexPositionBase + 1 ],
-          attrib.vertices[ vertexPositionBase + 2 ]
-        },
-        .texturePosition
+        const auto triangle = adjacentTriangles[ i ];
+        const auto score = vertexScores[ indices[ 3 * triangle ] ] + vertexScores[ indices[ 3 * triangle + 1 ] ] + vertexScores[ indices[ 3 * triangle + 2 ] ];
+
+        triangleScores[ triangle ] = score;
+
+        if( score > bestScore )
         {
-          attrib.texcoords[ textureCoordinateBase + 0 ],
-          1 - attrib.texcoords[ textureCoordinateBase + 1 ] // vulkan top-bottom coord
+          bestScore = score;
+          bestTriangle = triangle;
         }
-      };
-
-      if( uniqueVertices.count( vertex ) == 0 )
-      {
-        uniqueVertices.emplace( vertex, vertices_.size() );
-        vertices_.emplace_back( vertex );
       }
 
-      indices_.push_back( uniqueVertices[ vertex ] );
+    nextCache.resize( std::min< std::size_t >( nextCache.size(), cacheSize ) );
+    std::swap( cache, nextCache );
+
+    // nothing left around the cache, resumes with the first triangle not emitted yet rather than scanning them all
+    if( bestTriangle == noTriangle )
+    {
+      while( fallbackCursor < triangleCount && isTriangleEmitted[ fallbackCursor ] )
+        ++fallbackCursor;
+
+      if( fallbackCursor < triangleCount )
+        bestTriangle = fallbackCursor;
     }
   }
 
-  void loadModel()
-  {
-    tinyobj::attrib_t attrib;
-    std::vector< tinyobj::shape_t > shapes;
-    std::vector< tinyobj::material_t > materials;
-    std::string warn, err;
-    auto objPath = applicationPath_.parent_path() / objRelativePath_;
-
-    if( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, objPath.string().c_str() ) )
-      throw std::runtime_error{ "Error when loading obj file: " + warn + err };
+  std::copy( optimizedIndices.begin(), optimizedIndices.end(), indices.begin() );
+}
 
-    for( const auto &shape : shapes )
-      loadShape( shape, attrib );
-  }
+// Sorts fixed size clusters of triangles so that those facing away from the mesh center come first, they are the most likely to occlude
+// the others whatever the view point. Clusters are large enough to keep most of the vertex cache locality
+inline void optimizeOverdraw( std::span< std::uint32_t > indices, std::span< const Vertex > vertices, std::size_t trianglesPerCluster )
+{
+  const auto triangleCount = indices.size() / 3;
+  const auto clusterCount = ( triangleCount + trianglesPerCluster - 1 ) / trianglesPerCluster;
 
-  void initVulkan()
-  {
-    checkValidationSupport();
-    createInstance();
-    setupDebugMessenger();
-    createSurface();
-    pickFirstSuitablePhysicalDevice();
-    createLogicalDevice();
-    createSwapChain();
-    createImageViews();
-    createRenderPass();
-    createDescriptorSetLayout();
-    createGraphicPipeline();
-    createCommandPools();
-    createDepthResources();
-    createFramebuffers();
-    createTextureImage();
-    createTextureImageView();
-    createTextureSampler();
-    loadModel();
-    createVertexBuffer();
-    createIndexBuffer();
-    createUniformBuffers();
-    createDescriptorPool();
-    createDescriptorSets();
-    createDrawCommandBuffers();
-    createSynchronizationObjects();
-  }
+  glm::vec3 meshCenter{ 0.0f };
 
-  std::uint32_t findMemoryType( std::uint32_t typeFilter, VkMemoryPropertyFlags properties )
-  {
-    VkPhysicalDeviceMemoryProperties memoryProperties;
-    vkGetPhysicalDeviceMemoryProperties( physicalDevice_, &memoryProperties );
+  for( const auto &vertex : vertices )
+    meshCenter += vertex.position;
 
-    for( std::uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++ )
-      if( ( typeFilter & ( 1 << i ) ) && ( memoryProperties.memoryTypes[ i ].propertyFlags & properties ) == properties )
-        return i;
+  meshCenter /= std::max< float >( 1.0f, static_cast< float >( vertices.size() ) );
 
-    throw std::runtime_error{ "Error failed to find suitable memory type!" };
-  }
+  std::vector< float > clusterScores( clusterCount );
 
-  void allocateAndBindBuffer( VkBuffer &buffer, VkMemoryPropertyFlags properties, VkDeviceMemory &bufferMemory )
+  for( std::size_t cluster = 0; cluster < clusterCount; ++cluster )
   {
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements( logicalDevice_, buffer, &memoryRequirements );
+    glm::vec3 areaWeightedNormal{ 0.0f };
+    glm::vec3 areaWeightedCenter{ 0.0f };
+    float area{};
 
-    VkMemoryAllocateInfo allocInfo
+    for( auto triangle = cluster * trianglesPerCluster; triangle < std::min( ( cluster + 1 ) * trianglesPerCluster, triangleCount ); ++triangle )
     {
-      .sType{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO },
-      .allocationSize{ memoryRequirements.size },
-      .memoryTypeIndex{ findMemoryType( memoryRequirements.memoryTypeBits, properties ) }
-    };
+      const auto &a = vertices[ indices[ 3 * triangle ] ].position;
+      const auto &b = vertices[ indices[ 3 * triangle + 1 ] ].position;
+      const auto &c = vertices[ indices[ 3 * triangle + 2 ] ].position;
+
+      // twice the triangle area in length
+      const auto normal = glm::cross( b - a, c - a );
+      const auto triangleArea = glm::length( normal );
+
+      areaWeightedNormal += normal;
+      areaWeightedCenter += ( a + b + c ) * ( triangleArea / 3.0f );
+      area += triangleArea;
+    }
 
-    if( vkAllocateMemory( logicalDevice_, &allocInfo, nullptr, &bufferMemory ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to allocate vertex buffer memory!" };
+    const auto normalLength = glm::length( areaWeightedNormal );
 
-    vkBindBufferMemory( logicalDevice_, buffer, bufferMemory, 0 );
+    if( area > 0.0f && normalLength > 0.0f )
+      clusterScores[ cluster ] = glm::dot( areaWeightedCenter / area - meshCenter, areaWeightedNormal / normalLength );
   }
 
-  void createBuffer( VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory )
-  {
-    VkBufferCreateInfo bufferInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO },
-      .size{ size },
-      .usage{ usage },
-      .sharingMode{ VK_SHARING_MODE_EXCLUSIVE }
-    };
+  std::vector< std::size_t > clusterOrder( clusterCount );
+  std::iota( clusterOrder.begin(), clusterOrder.end(), 0 );
+  std::stable_sort( clusterOrder.begin(), clusterOrder.end(), [ &clusterScores ]( std::size_t lhs, std::size_t rhs ) { return clusterScores[ lhs ] > clusterScores[ rhs ]; } );
 
-    // todo - it might be good to parameterize concurrent acess for buffer creation later? Here is just about implicit concurrent access from graphic and tranfert queue families
-    std::uint32_t queueFamilyIndices[]
-    {
-      requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
-      requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value()
-    };
+  std::vector< std::uint32_t > sortedIndices;
+  sortedIndices.reserve( indices.size() );
 
-    if( requiredQueueFamilyIndices_.graphicsQueueFamilyIndex != requiredQueueFamilyIndices_.transfertQueueFamilyIndex )
-    {
-      bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
-      bufferInfo.queueFamilyIndexCount = 2;
-      bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
-    }
+  for( auto cluster : clusterOrder )
+    sortedIndices.insert( sortedIndices.end(),
+                          indices.begin() + 3 * cluster * trianglesPerCluster,
+                          indices.begin() + 3 * std::min( ( cluster + 1 ) * trianglesPerCluster, triangleCount ) );
 
-    if( vkCreateBuffer( logicalDevice_, &bufferInfo, nullptr, &buffer ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create a buffer!" };
+  std::copy( sortedIndices.begin(), sortedIndices.end(), indices.begin() );
+}
 
-    allocateAndBindBuffer( buffer, properties, bufferMemory );
-  }
+// Renumbers vertices in order of first use, vertex fetches then walk the vertex buffer forward
+inline void optimizeVertexFetch( std::span< std::uint32_t > indices, std::vector< Vertex > &vertices )
+{
+  constexpr std::uint32_t unused{ std::numeric_limits< std::uint32_t >::max() };
 
-  void allocateCommandBuffers( VkCommandPool pool, std::uint32_t bufferCount, VkCommandBuffer *commandBuffers )
+  std::vector< std::uint32_t > remap( vertices.size(), unused );
+  std::vector< Vertex > orderedVertices;
+  orderedVertices.reserve( vertices.size() );
+
+  for( auto &&index : indices )
   {
-    VkCommandBufferAllocateInfo allocInfo
+    if( remap[ index ] == unused )
     {
-      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO },
-      .commandPool{ pool },
-      .level{ VK_COMMAND_BUFFER_LEVEL_PRIMARY },
-      .commandBufferCount{ bufferCount }
-    };
+      remap[ index ] = static_cast< std::uint32_t >( orderedVertices.size() );
+      orderedVertices.push_back( vertices[ index ] );
+    }
 
-    if( vkAllocateCommandBuffers( logicalDevice_, &allocInfo, commandBuffers ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to allocate command buffers" };
+    index = remap[ index ];
   }
 
-  auto beginSingleTimeCommands()
-  {
-    VkCommandBuffer commandBuffer;
+  vertices.swap( orderedVertices );
+}
 
-    allocateCommandBuffers( transfertCommandPool_, 1, &commandBuffer );
+// average count of vertex shader invocations per triangle with a FIFO post transform cache, 0.5 at best, 3 at worst
+inline float computeAverageCacheMissRatio( std::span< const std::uint32_t > indices, std::size_t vertexCount, std::size_t cacheSize )
+{
+  std::vector< std::size_t > insertionTimes( vertexCount, 0 );
+  std::size_t time{ cacheSize + 1 };
+  std::size_t missCount{};
 
-    VkCommandBufferBeginInfo beginInfo
+  for( auto index : indices )
+    if( time - insertionTimes[ index ] > cacheSize )
     {
-      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO },
-      .flags{ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT }
-    };
+      insertionTimes[ index ] = time++;
+      ++missCount;
+    }
 
-    vkBeginCommandBuffer( commandBuffer, &beginInfo );
+  return indices.empty() ? 0.0f : static_cast< float >( missCount ) / ( indices.size() / 3 );
+}
 
-    return commandBuffer;
-  }
+// error quadric of a set of planes, weighted by the area of the triangles they come from
+struct Quadric
+{
+  double a00, a01, a02, a11, a12, a22;
+  double b0, b1, b2;
+  double c;
+  double weight;
 
-  void endSingleTimeCommands( VkCommandBuffer &commandBuffer )
+  static Quadric fromPlane( const glm::vec3 &normal, double distance, double weight ) noexcept
   {
-    vkEndCommandBuffer( commandBuffer );
-
-    VkSubmitInfo submitInfo
+    return Quadric
     {
-      .sType{ VK_STRUCTURE_TYPE_SUBMIT_INFO },
-      .commandBufferCount{ 1 },
-      .pCommandBuffers{ &commandBuffer }
+      .a00{ weight * normal.x * normal.x },
+      .a01{ weight * normal.x * normal.y },
+      .a02{ weight * normal.x * normal.z },
+      .a11{ weight * normal.y * normal.y },
+      .a12{ weight * normal.y * normal.z },
+      .a22{ weight * normal.z * normal.z },
+      .b0{ weight * normal.x * distance },
+      .b1{ weight * normal.y * distance },
+      .b2{ weight * normal.z * distance },
+      .c{ weight * distance * distance },
+      .weight{ weight }
     };
+  }
 
-    vkQueueSubmit( transfertQueue_, 1, &submitInfo, VK_NULL_HANDLE );
-    vkQueueWaitIdle( transfertQueue_ );
+  Quadric &operator +=( const Quadric &other ) noexcept
+  {
+    a00 += other.a00; a01 += other.a01; a02 += other.a02; a11 += other.a11; a12 += other.a12; a22 += other.a22;
+    b0 += other.b0; b1 += other.b1; b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
 
-    vkFreeCommandBuffers( logicalDevice_, transfertCommandPool_, 1, &commandBuffer );
+    return *this;
   }
 
-  void copyBufferToImage( VkBuffer buffer, VkImage image, std::uint32_t width, std::uint32_t height )
+  // mean squared distance of the point to the planes
+  double evaluate( const glm::vec3 &point ) const noexcept
   {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-    VkBufferImageCopy regions[]
-    {
-      {
-        .bufferOffset{ 0 },
-        .bufferRowLength{ 0 },
-        .bufferImageHeight{ 0 },
-        .imageSubresource
-        {
-          .aspectMask{ VK_IMAGE_ASPECT_COLOR_BIT },
-          .mipLevel{ 0 },
-          .baseArrayLayer{ 0 },
-          .layerCount{ 1 },
-        },
-        .imageOffset{ 0, 0, 0 },
-        .imageExtent
-        {
-            .width{ width },
-            .height{ height },
-            .depth{ 1 }
-        }
-      }
-    };
+    const double p[]{ point.x, point.y, point.z };
 
-    vkCmdCopyBufferToImage( commandBuffer,
-                            buffer,
-                            image,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            1,
-                            regions
-    );
+    const auto squaredDistanceSum = a00 * p[ 0 ] * p[ 0 ] + a11 * p[ 1 ] * p[ 1 ] + a22 * p[ 2 ] * p[ 2 ]
+      + 2.0 * ( a01 * p[ 0 ] * p[ 1 ] + a02 * p[ 0 ] * p[ 2 ] + a12 * p[ 1 ] * p[ 2 ] )
+      + 2.0 * ( b0 * p[ 0 ] + b1 * p[ 1 ] + b2 * p[ 2 ] )
+      + c;
 
-    endSingleTimeCommands( commandBuffer );
+    return weight > 0.0 ? std::max( 0.0, squaredDistanceSum ) / weight : 0.0;
   }
+};
 
-  constexpr std::pair< VkAccessFlags, VkAccessFlags > getPipelineStageFlagsFromTransitionLayouts( std::pair< VkImageLayout, VkImageLayout > &&transitionLayouts )
-  {
-    auto [oldLayout, newLayout] = transitionLayouts;
-
-    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
-      return { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+struct SimplifiedMesh
+{
+  std::vector< std::uint32_t > indices;
+  // root mean squared distance to the source surface, in model units
+  float error;
+};
 
-    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
-      return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+// Garland and Heckbert's quadric error metric driving half edge collapses: vertices merge into one of their neighbours so that the vertex
+// buffer is shared by every level. Collapses are done by passes of independent edges sorted by cost, vertices on borders and texture seams are
+// locked to keep the silhouette and avoid cracks. targetIndexCounts are decreasing, one simplified mesh is snapshot each time one of them is
+// reached, fewer are returned if the mesh cannot be simplified that far
+inline std::vector< SimplifiedMesh > simplifyMesh( std::span< const std::uint32_t > indices,
+                                                   std::span< const Vertex > vertices,
+                                                   std::span< const std::size_t > targetIndexCounts )
+{
+  const auto vertexCount = vertices.size();
 
-    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
-      return { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT };
+  const auto getPosition = [ &vertices ]( std::uint32_t vertex ) -> const glm::vec3 & { return vertices[ vertex ].position; };
 
-    throw std::invalid_argument{ "Error unsupported layout transition!" };
-  }
+  std::vector< Quadric > quadrics( vertexCount, Quadric{} );
 
-  constexpr std::tuple< VkAccessFlags, VkAccessFlags, VkImageAspectFlags > getPipelineMasksFromTransitionLayouts( std::tuple< VkImageLayout, VkImageLayout, VkFormat > &&transitionLayoutInfo )
+  for( std::size_t i = 0; i < indices.size(); i += 3 )
   {
-    auto [oldLayout, newLayout, format] = transitionLayoutInfo;
+    const auto &a = getPosition( indices[ i ] );
+    const auto normal = glm::cross( getPosition( indices[ i + 1 ] ) - a, getPosition( indices[ i + 2 ] ) - a );
+    const auto doubleArea = glm::length( normal );
 
-    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
-      return { 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
-
-    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
-      return { VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+    if( doubleArea <= 0.0f )
+      continue;
 
-    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
-      return { 0,
-               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-               hasStencilComponent( format ) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT };
+    const auto unitNormal = normal / doubleArea;
+    const auto quadric = Quadric::fromPlane( unitNormal, -glm::dot( unitNormal, a ), doubleArea * 0.5f );
 
-    throw std::invalid_argument{ "Error unsupported layout transition!" };
+    for( int corner = 0; corner < 3; ++corner )
+      quadrics[ indices[ i + corner ] ] += quadric;
   }
 
-  void transitionImageLayout( VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout )
+  const auto makeEdges = []( std::span< const std::uint32_t > triangles )
   {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-    auto [srcAccessMask, dstAccessMask, aspectMask] = getPipelineMasksFromTransitionLayouts( { oldLayout, newLayout, format } );
+    std::vector< std::pair< std::uint32_t, std::uint32_t > > edges;
+    edges.reserve( triangles.size() );
 
-    VkImageMemoryBarrier barrier
-    {
-      .sType{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER },
-      .srcAccessMask{ srcAccessMask },
-      .dstAccessMask{ dstAccessMask },
-      .oldLayout{ oldLayout },
-      .newLayout{ newLayout },
-      .srcQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED },
-      .dstQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED },
-      .image{ image },
-      .subresourceRange
+    for( std::size_t i = 0; i < triangles.size(); i += 3 )
+      for( int corner = 0; corner < 3; ++corner )
       {
-        .aspectMask{ aspectMask },
-        .baseMipLevel{ 0 },
-        .levelCount{ 1 },
-        .baseArrayLayer{ 0 },
-        .layerCount{ 1 },
+        const auto a = triangles[ i + corner ];
+        const auto b = triangles[ i + ( corner + 1 ) % 3 ];
+        edges.emplace_back( std::min( a, b ), std::max( a, b ) );
       }
-    };
 
-    auto [srcStageFlags, dstStageFlags] = getPipelineStageFlagsFromTransitionLayouts( { oldLayout,newLayout } );
+    std::sort( edges.begin(), edges.end() );
 
-    vkCmdPipelineBarrier( commandBuffer,
-                          srcStageFlags,
-                          dstStageFlags,
-                          0,
-                          0,
-                          nullptr,
-                          0,
-                          nullptr,
-                          1,
-                          &barrier );
+    return edges;
+  };
 
-    endSingleTimeCommands( commandBuffer );
-  }
+  // seams split vertices sharing a position, they show up as borders of the indexed topology as well
+  std::vector< bool > isLocked( vertexCount );
 
-  void copyBuffer( VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size )
   {
-    auto commandBuffer = beginSingleTimeCommands();
+    const auto edges = makeEdges( indices );
 
-    VkBufferCopy copyRegion
+    for( std::size_t i = 0; i < edges.size(); )
     {
-      .size{ size }
-    };
+      auto end = i + 1;
 
-    vkCmdCopyBuffer( commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion );
+      while( end < edges.size() && edges[ end ] == edges[ i ] )
+        ++end;
 
-    endSingleTimeCommands( commandBuffer );
+      if( end - i != 2 )
+        isLocked[ edges[ i ].first ] = isLocked[ edges[ i ].second ] = true;
+
+      i = end;
+    }
   }
 
-  void createVertexBuffer()
+  std::vector< std::uint32_t > remap( vertexCount );
+  std::iota( remap.begin(), remap.end(), 0 );
+
+  std::vector< std::uint32_t > triangles( indices.begin(), indices.end() );
+  std::vector< SimplifiedMesh > simplifiedMeshes;
+  double maxCost{};
+
+  struct Collapse
   {
-    VkDeviceSize bufferSize = sizeof( typename decltype( vertices_ )::value_type ) * vertices_.size();
+    std::uint32_t from;
+    std::uint32_t to;
+    double cost;
+  };
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+  std::vector< Collapse > collapses;
+  std::vector< bool > isTouched( vertexCount );
+  std::vector< std::uint32_t > adjacencyOffsets( vertexCount + 1 );
+  std::vector< std::uint32_t > adjacentTriangles;
 
-    mapDataInStagingBuffer( bufferSize, vertices_.data(), stagingBuffer, stagingBufferMemory );
+  for( auto targetIndexCount : targetIndexCounts )
+  {
+    while( triangles.size() > targetIndexCount )
+    {
+      // vertex to triangles adjacency of this pass, in compressed rows
+      std::fill( adjacencyOffsets.begin(), adjacencyOffsets.end(), 0 );
 
-    createBuffer( bufferSize,
-                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                  vertexBuffer_,
-                  vertexBufferMemory_ );
+      for( auto vertex : triangles )
+        ++adjacencyOffsets[ vertex + 1 ];
 
-    copyBuffer( stagingBuffer, vertexBuffer_, bufferSize );
+      std::partial_sum( adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin() );
+      adjacentTriangles.resize( triangles.size() );
 
-    vkDestroyBuffer( logicalDevice_, stagingBuffer, nullptr );
-    vkFreeMemory( logicalDevice_, stagingBufferMemory, nullptr );
-  }
+      {
+        auto fillOffsets = adjacencyOffsets;
 
-  void recreateSwapChain()
-  {
-    handleMinimizedWindow();
+        for( std::uint32_t i = 0; i < triangles.size(); ++i )
+          adjacentTriangles[ fillOffsets[ triangles[ i ] ]++ ] = i / 3;
+      }
 
-    vkDeviceWaitIdle( logicalDevice_ );
+      const auto edges = makeEdges( triangles );
 
-    cleanupSwapChain();
+      collapses.clear();
 
-    setupSwapChainSupportForPhysicalDevice( physicalDevice_ );
-    createSwapChain();
-    createImageViews();
-    createRenderPass();
-    createGraphicPipeline();
-    createDepthResources();
-    createFramebuffers();
-    createUniformBuffers();
-    createDescriptorPool();
-    createDescriptorSets();
-    createDrawCommandBuffers();
-  }
+      for( std::size_t i = 0; i < edges.size(); ++i )
+      {
+        if( i > 0 && edges[ i ] == edges[ i - 1 ] )
+          continue;
 
-  void handleMinimizedWindow()
-  {
-    int width{}, height{};
+        const auto [ a, b ] = edges[ i ];
+        auto merged = quadrics[ a ];
+        merged += quadrics[ b ];
 
-    glfwGetFramebufferSize( window_, &width, &height );
+        const Collapse candidates[]
+        {
+          { a, b, isLocked[ a ] ? std::numeric_limits< double >::infinity() : merged.evaluate( getPosition( b ) ) },
+          { b, a, isLocked[ b ] ? std::numeric_limits< double >::infinity() : merged.evaluate( getPosition( a ) ) }
+        };
 
-    while( width == 0 || height == 0 ) {
-      glfwGetFramebufferSize( window_, &width, &height );
-      glfwWaitEvents();
-    }
-  }
+        const auto &candidate = candidates[ 0 ].cost <= candidates[ 1 ].cost ? candidates[ 0 ] : candidates[ 1 ];
 
-  void createSynchronizationObjects()
-  {
-    VkSemaphoreCreateInfo semaphoreInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO }
-    };
+        if( std::isfinite( candidate.cost ) )
+          collapses.push_back( candidate );
+      }
 
-    VkFenceCreateInfo fenceInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO },
-      .flags{ VK_FENCE_CREATE_SIGNALED_BIT }
-    };
+      std::sort( collapses.begin(), collapses.end(), []( const Collapse &lhs, const Collapse &rhs ) { return lhs.cost < rhs.cost; } );
+      std::fill( isTouched.begin(), isTouched.end(), false );
 
-    imageAvailableSemaphore_.resize( maxFrameInFlight_ );
-    renderFinishedSemaphore_.resize( maxFrameInFlight_ );
-    inFlightFences_.resize( maxFrameInFlight_ );
-    inFlightImageFences_.resize( swapChainImages_.size(), VK_NULL_HANDLE );
+      auto triangleCount = triangles.size() / 3;
+      const auto targetTriangleCount = targetIndexCount / 3;
+      std::size_t collapseCount{};
 
-    for( std::uint8_t i = 0; i < maxFrameInFlight_; ++i )
-      if( vkCreateSemaphore( logicalDevice_, &semaphoreInfo, nullptr, &imageAvailableSemaphore_[ i ] ) != VK_SUCCESS ||
-          vkCreateSemaphore( logicalDevice_, &semaphoreInfo, nullptr, &renderFinishedSemaphore_[ i ] ) != VK_SUCCESS ||
-          vkCreateFence( logicalDevice_, &fenceInfo, nullptr, &inFlightFences_[ i ] ) != VK_SUCCESS )
-        throw std::runtime_error{ "Error failed to create synchronization objects!" };
-  }
+      for( const auto &collapse : collapses )
+      {
+        if( triangleCount <= targetTriangleCount )
+          break;
 
-  void createDrawCommandBuffer( VkFramebuffer targetFrameBuffer, VkCommandBuffer targetCommandBuffer, const VkDescriptorSet *targetDescriptorSet )
-  {
-    VkCommandBufferBeginInfo beginInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO },
-      .flags{ 0 }, // Optional
-      .pInheritanceInfo{ nullptr } // Optional
-    };
+        if( isTouched[ collapse.from ] || isTouched[ collapse.to ] )
+          continue;
 
-    if( vkBeginCommandBuffer( targetCommandBuffer, &beginInfo ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to begin recording command buffer!" };
+        // the triangles around the collapsed vertex must not flip nor fold over, those shared with the kept one vanish
+        bool isFlipping{};
+        std::size_t removedTriangleCount{};
 
-    VkClearValue clearColors[]
-    {
-      { 0, 0, 0, 1 },
-      { 1, 0 }
-    };
+        for( auto i = adjacencyOffsets[ collapse.from ]; i < adjacencyOffsets[ collapse.from + 1 ] && !isFlipping; ++i )
+        {
+          const auto triangle = adjacentTriangles[ i ];
+          std::uint32_t corners[ 3 ];
 
-    VkRenderPassBeginInfo renderPassInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO },
-      .renderPass{ renderPass_},
-      .framebuffer{ targetFrameBuffer },
-      .renderArea
+          for( int corner = 0; corner < 3; ++corner )
+          {
+            corners[ corner ] = triangles[ 3 * triangle + corner ];
+
+            while( remap[ corners[ corner ] ] != corners[ corner ] )
+              corners[ corner ] = remap[ corners[ corner ] ];
+          }
+
+          if( corners[ 0 ] == corners[ 1 ] || corners[ 1 ] == corners[ 2 ] || corners[ 0 ] == corners[ 2 ] )
+            continue;
+
+          if( corners[ 0 ] == collapse.to || corners[ 1 ] == collapse.to || corners[ 2 ] == collapse.to )
+          {
+            ++removedTriangleCount;
+            continue;
+          }
+
+          glm::vec3 positions[ 3 ];
+
+          for( int corner = 0; corner < 3; ++corner )
+            positions[ corner ] = getPosition( corners[ corner ] );
+
+          const auto normal = glm::cross( positions[ 1 ] - positions[ 0 ], positions[ 2 ] - positions[ 0 ] );
+
+          for( int corner = 0; corner < 3; ++corner )
+            if( corners[ corner ] == collapse.from )
+              positions[ corner ] = getPosition( collapse.to );
+
+          const auto collapsedNormal = glm::cross( positions[ 1 ] - positions[ 0 ], positions[ 2 ] - positions[ 0 ] );
+
+          isFlipping = glm::dot( normal, collapsedNormal ) <= 0.25f * glm::length( normal ) * glm::length( collapsedNormal );
+        }
+
+        if( isFlipping )
+          continue;
+
+        remap[ collapse.from ] = collapse.to;
+        quadrics[ collapse.to ] += quadrics[ collapse.from ];
+        isTouched[ collapse.from ] = isTouched[ collapse.to ] = true;
+        maxCost = std::max( maxCost, collapse.cost );
+        triangleCount -= std::min( removedTriangleCount, triangleCount );
+        ++collapseCount;
+      }
+
+      if( collapseCount == 0 )
+        break;
+
+      for( auto &&vertex : remap )
+        while( remap[ vertex ] != vertex )
+          vertex = remap[ vertex ];
+
+      std::size_t keptIndexCount{};
+
+      for( std::size_t i = 0; i < triangles.size(); i += 3 )
       {
-        .offset{ 0, 0 },
-        .extent{ swapChainExtent_ }
-      },
-      .clearValueCount{ sizeof( clearColors ) / sizeof( VkClearValue ) },
-      .pClearValues{ clearColors }
-    };
+        const auto a = remap[ triangles[ i ] ], b = remap[ triangles[ i + 1 ] ], c = remap[ triangles[ i + 2 ] ];
 
-    vkCmdBeginRenderPass( targetCommandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
-    vkCmdBindPipeline( targetCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicPipelines_.front() );
+        if( a == b || b == c || a == c )
+          continue;
 
-    VkBuffer vertexBuffers[] = { vertexBuffer_ };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers( targetCommandBuffer, 0, 1, vertexBuffers, offsets );
-    vkCmdBindIndexBuffer( targetCommandBuffer, indexBuffer_, 0, VK_INDEX_TYPE_UINT32 );
-    vkCmdBindDescriptorSets( targetCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, targetDescriptorSet, 0, nullptr );
+        triangles[ keptIndexCount++ ] = a;
+        triangles[ keptIndexCount++ ] = b;
+        triangles[ keptIndexCount++ ] = c;
+      }
 
-    vkCmdDrawIndexed( targetCommandBuffer, static_cast< uint32_t >( indices_.size() ), 1, 0, 0, 0 );
-    vkCmdEndRenderPass( targetCommandBuffer );
+      triangles.resize( keptIndexCount );
+    }
 
-    if( vkEndCommandBuffer( targetCommandBuffer ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to record command buffer!" };
-  }
+    const auto previousIndexCount = simplifiedMeshes.empty() ? indices.size() : simplifiedMeshes.back().indices.size();
 
-  void createDrawCommandBuffers()
-  {
-    commandBuffers_.resize( swapChainFramebuffers_.size() );
+    if( triangles.size() >= previousIndexCount )
+      break;
 
-    allocateCommandBuffers( graphicCommandPool_, static_cast< std::uint32_t >( commandBuffers_.size() ), commandBuffers_.data() );
+    simplifiedMeshes.push_back( SimplifiedMesh{ .indices{ triangles }, .error{ static_cast< float >( std::sqrt( maxCost ) ) } } );
 
-    for( std::size_t i = 0; i < commandBuffers_.size(); i++ )
-      createDrawCommandBuffer( swapChainFramebuffers_[ i ], commandBuffers_[ i ], &descriptorSets_[ i ] );
+    if( triangles.size() > targetIndexCount )
+      break;
   }
 
-  void createCommandPool( VkCommandPoolCreateFlags flags, std::uint32_t queueFamilyIndex, VkCommandPool *commandPool, const char *const exceptionMessage )
+  return simplifiedMeshes;
+}
+
+// Runs function( taskIndex ) for each task on its own thread, the calling thread taking the first one, and rethrows the first failure once all are done
+template< typename Function >
+void parallelFor( std::size_t taskCount, Function &&function )
+{
+  std::vector< std::exception_ptr > errors( taskCount );
+  std::vector< std::thread > workers;
+
+  const auto runTask = [ & ]( std::size_t taskIndex )
   {
-    VkCommandPoolCreateInfo poolInfo
+    try
     {
-      .sType{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO },
-      .flags{ flags },
-      .queueFamilyIndex{ queueFamilyIndex }
-    };
+      function( taskIndex );
+    }
+    catch( ... )
+    {
+      errors[ taskIndex ] = std::current_exception();
+    }
+  };
 
-    if( vkCreateCommandPool( logicalDevice_, &poolInfo, nullptr, commandPool ) != VK_SUCCESS )
-      throw std::runtime_error{ exceptionMessage };
-  }
+  workers.reserve( taskCount );
 
-  void createGraphicPool()
+  for( std::size_t i = 1; i < taskCount; ++i )
+    workers.emplace_back( runTask, i );
+
+  if( taskCount > 0 )
+    runTask( 0 );
+
+  for( auto &&worker : workers )
+    worker.join();
+
+  for( auto &&error : errors )
+    if( error )
+      std::rethrow_exception( error );
+}
+
+// Persistent worker threads sharing out the tasks of one run() at a time, the calling thread being worker 0. A task is told which worker
+// executes it so that it can use per worker resources (i.e. command pools) without any locking
+class JobSystem
+{
+public:
+  explicit JobSystem( std::size_t workerCount = std::max( 1u, std::thread::hardware_concurrency() ) )
   {
-    createCommandPool( 0,
-                       requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
-                       &graphicCommandPool_,
-                       "Error failed to create the graphic command pool!" );
+    workers_.reserve( workerCount - 1 );
+
+    for( std::size_t i = 1; i < workerCount; ++i )
+      workers_.emplace_back( &JobSystem::workerLoop, this, i );
   }
 
-  void createTransfertPool()
+  JobSystem( const JobSystem & ) = delete;
+  JobSystem &operator=( const JobSystem & ) = delete;
+
+  ~JobSystem()
   {
-    createCommandPool( VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
-                       requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value(),
-                       &transfertCommandPool_,
-                       "Error failed to create the transfert command pool!" );
+    {
+      std::lock_guard lock{ mutex_ };
+      isStopping_ = true;
+    }
+
+    wakeCondition_.notify_all();
+
+    for( auto &&worker : workers_ )
+      worker.join();
   }
 
-  void createCommandPools()
+  std::size_t getWorkerCount() const noexcept
   {
-    createGraphicPool();
-    createTransfertPool();
+    return workers_.size() + 1;
   }
 
-  void createFramebuffer( VkImageView imageView, VkImageView depthImageView, VkFramebuffer *targetFramebuffer )
+  // runs function( workerIndex, taskIndex ) for each task and returns once all are done, rethrowing the first failure
+  template< typename Function >
+  void run( std::size_t taskCount, Function &&function )
   {
-    VkImageView attachments[]
     {
-      imageView,
-      depthImageView
-    };
+      std::lock_guard lock{ mutex_ };
+      task_ = std::forward< Function >( function );
+      taskCount_ = taskCount;
+      nextTaskIndex_ = 0;
+      busyWorkerCount_ = workers_.size();
+      ++generation_;
+    }
 
-    VkFramebufferCreateInfo framebufferInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO },
-      .renderPass{ renderPass_ },
-      .attachmentCount{ sizeof( attachments ) / sizeof( VkImageView ) },
-      .pAttachments{ attachments },
-      .width{ swapChainExtent_.width },
-      .height{ swapChainExtent_.height },
-      .layers{ 1 }
-    };
+    wakeCondition_.notify_all();
 
-    if( vkCreateFramebuffer( logicalDevice_, &framebufferInfo, nullptr, targetFramebuffer ) != VK_SUCCESS )
-      throw std::runtime_error{ "failed to create framebuffer!" };
-  }
+    executeTasks( 0 );
 
-  void createFramebuffers()
-  {
-    swapChainFramebuffers_.resize( swapChainImageViews_.size() );
+    std::unique_lock lock{ mutex_ };
+    doneCondition_.wait( lock, [ this ] { return busyWorkerCount_ == 0; } );
 
-    for( std::size_t i = 0; i < swapChainImageViews_.size(); i++ )
-      createFramebuffer( swapChainImageViews_[ i ], depthImageView_, &swapChainFramebuffers_[ i ] );
+    task_ = nullptr;
+
+    if( error_ )
+      std::rethrow_exception( std::exchange( error_, nullptr ) );
   }
 
-  void createRenderPass()
+private:
+  void workerLoop( std::size_t workerIndex )
   {
-    VkAttachmentDescription attachmentDescriptions[]
+    std::uint64_t executedGeneration{};
+
+    for( ;; )
     {
       {
-        .format{ swapChainSurfaceFormat_.format },
-        .samples{ VK_SAMPLE_COUNT_1_BIT },
-        .loadOp{ VK_ATTACHMENT_LOAD_OP_CLEAR },
-        .storeOp{ VK_ATTACHMENT_STORE_OP_STORE },
-        .stencilLoadOp{ VK_ATTACHMENT_LOAD_OP_DONT_CARE },
-        .stencilStoreOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
-        .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED },
-        .finalLayout{ VK_IMAGE_LAYOUT_PRESENT_SRC_KHR },
-      },
-      {
-        .format{ findDepthFormat() },
-        .samples{ VK_SAMPLE_COUNT_1_BIT },
-        .loadOp{ VK_ATTACHMENT_LOAD_OP_CLEAR },
-        .storeOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
-        .stencilLoadOp{ VK_ATTACHMENT_LOAD_OP_DONT_CARE },
-        .stencilStoreOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
-        .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED },
-        .finalLayout{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+        std::unique_lock lock{ mutex_ };
+        wakeCondition_.wait( lock, [ & ] { return isStopping_ || generation_ != executedGeneration; } );
+
+        if( isStopping_ )
+          return;
+
+        executedGeneration = generation_;
       }
-    };
 
-    VkAttachmentReference colorAttachmentReferences[]
-    {
+      executeTasks( workerIndex );
+
       {
-        .attachment{ 0 },
-        .layout{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }
+        std::lock_guard lock{ mutex_ };
+        --busyWorkerCount_;
       }
-    };
 
-    VkAttachmentReference depthStencilAttachmentReference
-    {
-      .attachment{ 1 },
-      .layout{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL }
-    };
+      doneCondition_.notify_one();
+    }
+  }
 
-    VkSubpassDescription subPasses[]
-    {
+  void executeTasks( std::size_t workerIndex )
+  {
+    for( auto taskIndex = nextTaskIndex_++; taskIndex < taskCount_; taskIndex = nextTaskIndex_++ )
+      try
       {
-        .pipelineBindPoint{ VK_PIPELINE_BIND_POINT_GRAPHICS },
-        .colorAttachmentCount{ sizeof( colorAttachmentReferences ) / sizeof( VkAttachmentReference ) },
-        .pColorAttachments{ colorAttachmentReferences },
-        .pDepthStencilAttachment{ &depthStencilAttachmentReference }
+        task_( workerIndex, taskIndex );
       }
-    };
-
-    VkSubpassDependency dependencies[]
-    {
+      catch( ... )
       {
-        .srcSubpass{ VK_SUBPASS_EXTERNAL },
-        .dstSubpass{ 0 },
-        .srcStageMask{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
-        .dstStageMask{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
-        .srcAccessMask{ 0 },
-        .dstAccessMask{ VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT }
+        std::lock_guard lock{ mutex_ };
+
+        if( !error_ )
+          error_ = std::current_exception();
       }
-    };
+  }
 
-    VkRenderPassCreateInfo renderPassInfo
+private:
+  std::vector< std::thread > workers_;
+  std::mutex mutex_;
+  std::condition_variable wakeCondition_;
+  std::condition_variable doneCondition_;
+  // only written under the lock while no worker is executing tasks
+  std::function< void( std::size_t, std::size_t ) > task_;
+  std::size_t taskCount_{};
+  std::atomic< std::size_t > nextTaskIndex_{};
+  std::size_t busyWorkerCount_{};
+  std::uint64_t generation_{};
+  bool isStopping_{};
+  std::exception_ptr error_;
+};
+
+// Bounded ring between exactly one producer and one consumer thread. Each end only moves its own index and reads the other one, a full
+// ring blocks push() and an empty one blocks pop() on the other index changing. cancel() wakes both ends for good, i.e. when a stage fails
+template< typename T, std::size_t Capacity >
+class SpscQueue
+{
+public:
+  bool push( T value )
+  {
+    const auto head = head_.load( std::memory_order_relaxed );
+
+    for( ;; )
     {
-      .sType{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO },
-      .attachmentCount{ sizeof( attachmentDescriptions ) / sizeof( VkAttachmentDescription ) },
-      .pAttachments{ attachmentDescriptions },
-      .subpassCount{ sizeof( subPasses ) / sizeof( VkSubpassDescription ) },
-      .pSubpasses{ subPasses },
-      .dependencyCount{ sizeof( dependencies ) / sizeof( VkSubpassDependency ) },
-      .pDependencies{ dependencies }
-    };
+      const auto tail = tail_.load( std::memory_order_acquire );
 
-    if( vkCreateRenderPass( logicalDevice_, &renderPassInfo, nullptr, &renderPass_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create render pass!" };
-  }
+      if( isCancelled( tail ) )
+        return false;
 
-  auto getShaderModules()
-  {
-    auto shadersDirectory = applicationPath_.parent_path() / "shaders";
+      if( head - tail < Capacity )
+        break;
 
-    auto vertexShaderCode = loadShaderModule( shadersDirectory / "vert.spv" );
-    auto fragmentShaderCode = loadShaderModule( shadersDirectory / "frag.spv" );
+      tail_.wait( tail, std::memory_order_acquire );
+    }
 
-    return std::make_tuple( createShaderModule( std::move( vertexShaderCode ) ),
-                            createShaderModule( std::move( fragmentShaderCode ) ) );
+    return publish( head, value );
   }
 
-  void createGraphicPipelineLayout()
+  std::optional< T > pop()
   {
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo
+    auto tail = tail_.load( std::memory_order_acquire );
+
+    for( ;; )
     {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO },
-      .setLayoutCount{ 1 },
-      .pSetLayouts{ &descriptorSetLayout_ },
-      .pushConstantRangeCount{ 0 }, // Optional
-      .pPushConstantRanges{ nullptr }, // Optional
-    };
+      const auto head = head_.load( std::memory_order_acquire );
 
-    if( vkCreatePipelineLayout( logicalDevice_, &pipelineLayoutInfo, nullptr, &pipelineLayout_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create pipeline layout!" };
-  }
+      if( isCancelled( head ) )
+        return std::nullopt;
+
+      if( head != tail )
+        break;
+
+      head_.wait( head, std::memory_order_acquire );
+    }
+
+    auto value = std::move( slots_[ tail % Capacity ] );
+
+    // fails once cancelled only
+    if( !tail_.compare_exchange_strong( tail, tail + 1, std::memory_order_release, std::memory_order_relaxed ) )
+      return std::nullopt;
+
+    tail_.notify_one();
+
+    return value;
+  }
+
+  bool isCancelled() const noexcept
+  {
+    return isCancelled( head_.load( std::memory_order_acquire ) );
+  }
+
+  // producer side only, the consumer may free a slot meanwhile but never take one
+  bool isFull() const noexcept
+  {
+    return head_.load( std::memory_order_relaxed ) - tail_.load( std::memory_order_acquire ) >= Capacity;
+  }
+
+  // flagged in both indices, so that a waiter sees the one it waits on change
+  void cancel() noexcept
+  {
+    head_.fetch_or( cancelledBit_, std::memory_order_acq_rel );
+    tail_.fetch_or( cancelledBit_, std::memory_order_acq_rel );
+    head_.notify_all();
+    tail_.notify_all();
+  }
+
+private:
+  static constexpr bool isCancelled( std::uint64_t index ) noexcept
+  {
+    return index & cancelledBit_;
+  }
+
+  bool publish( std::uint64_t head, T &value )
+  {
+    slots_[ head % Capacity ] = std::move( value );
+
+    if( !head_.compare_exchange_strong( head, head + 1, std::memory_order_release, std::memory_order_relaxed ) )
+      return false;
+
+    head_.notify_one();
+
+    return true;
+  }
+
+  inline static constexpr std::uint64_t cancelledBit_{ std::uint64_t{ 1 } << 63 };
+
+  std::array< T, Capacity > slots_{};
+  // apart, the producer and the consumer do not keep stealing each other cache line
+  alignas( 64 ) std::atomic< std::uint64_t > head_{};
+  alignas( 64 ) std::atomic< std::uint64_t > tail_{};
+};
+
+// One float per instance: the tail of a batch, and the whole batch when no vector instruction set is available
+struct ScalarFloat
+{
+  float value;
+
+  inline static constexpr std::size_t width{ 1 };
+  inline static constexpr const char *name{ "scalar" };
+
+  static ScalarFloat load( const float *data ) noexcept
+  {
+    return ScalarFloat{ *data };
+  }
+
+  static ScalarFloat broadcast( float value ) noexcept
+  {
+    return ScalarFloat{ value };
+  }
+
+  friend ScalarFloat operator+( ScalarFloat a, ScalarFloat b ) noexcept
+  {
+    return ScalarFloat{ a.value + b.value };
+  }
+
+  friend ScalarFloat operator-( ScalarFloat a, ScalarFloat b ) noexcept
+  {
+    return ScalarFloat{ a.value - b.value };
+  }
+
+  friend ScalarFloat operator*( ScalarFloat a, ScalarFloat b ) noexcept
+  {
+    return ScalarFloat{ a.value * b.value };
+  }
+
+  // the x, y, z and w components of one lane are written contiguously at destinations[ lane ]
+  static void storeTransposed( ScalarFloat x, ScalarFloat y, ScalarFloat z, ScalarFloat w, float *const *destinations ) noexcept
+  {
+    destinations[ 0 ][ 0 ] = x.value;
+    destinations[ 0 ][ 1 ] = y.value;
+    destinations[ 0 ][ 2 ] = z.value;
+    destinations[ 0 ][ 3 ] = w.value;
+  }
+};
+
+#if defined( VULKAN_LEARNING_SIMD_AVX2 )
+struct Avx2Float
+{
+  __m256 value;
+
+  inline static constexpr std::size_t width{ 8 };
+  inline static constexpr const char *name{ "AVX2" };
+
+  static Avx2Float load( const float *data ) noexcept
+  {
+    return Avx2Float{ _mm256_loadu_ps( data ) };
+  }
+
+  static Avx2Float broadcast( float value ) noexcept
+  {
+    return Avx2Float{ _mm256_set1_ps( value ) };
+  }
+
+  friend Avx2Float operator+( Avx2Float a, Avx2Float b ) noexcept
+  {
+    return Avx2Float{ _mm256_add_ps( a.value, b.value ) };
+  }
+
+  friend Avx2Float operator-( Avx2Float a, Avx2Float b ) noexcept
+  {
+    return Avx2Float{ _mm256_sub_ps( a.value, b.value ) };
+  }
+
+  friend Avx2Float operator*( Avx2Float a, Avx2Float b ) noexcept
+  {
+    return Avx2Float{ _mm256_mul_ps( a.value, b.value ) };
+  }
+
+  // transposed 4x4 within each 128 bits half, the low halves hold lanes 0 to 3 and the high ones lanes 4 to 7
+  static void storeTransposed( Avx2Float x, Avx2Float y, Avx2Float z, Avx2Float w, float *const *destinations ) noexcept
+  {
+    const auto xy0 = _mm256_unpacklo_ps( x.value, y.value );
+    const auto xy1 = _mm256_unpackhi_ps( x.value, y.value );
+    const auto zw0 = _mm256_unpacklo_ps( z.value, w.value );
+    const auto zw1 = _mm256_unpackhi_ps( z.value, w.value );
+
+    const __m256 lanes[]
+    {
+      _mm256_shuffle_ps( xy0, zw0, _MM_SHUFFLE( 1, 0, 1, 0 ) ),
+      _mm256_shuffle_ps( xy0, zw0, _MM_SHUFFLE( 3, 2, 3, 2 ) ),
+      _mm256_shuffle_ps( xy1, zw1, _MM_SHUFFLE( 1, 0, 1, 0 ) ),
+      _mm256_shuffle_ps( xy1, zw1, _MM_SHUFFLE( 3, 2, 3, 2 ) )
+    };
+
+    for( std::size_t i = 0; i < 4; ++i )
+    {
+      _mm_storeu_ps( destinations[ i ], _mm256_castps256_ps128( lanes[ i ] ) );
+      _mm_storeu_ps( destinations[ i + 4 ], _mm256_extractf128_ps( lanes[ i ], 1 ) );
+    }
+  }
+};
+
+using SimdFloat = Avx2Float;
+#elif defined( VULKAN_LEARNING_SIMD_SSE2 )
+struct Sse2Float
+{
+  __m128 value;
+
+  inline static constexpr std::size_t width{ 4 };
+  inline static constexpr const char *name{ "SSE2" };
+
+  static Sse2Float load( const float *data ) noexcept
+  {
+    return Sse2Float{ _mm_loadu_ps( data ) };
+  }
+
+  static Sse2Float broadcast( float value ) noexcept
+  {
+    return Sse2Float{ _mm_set1_ps( value ) };
+  }
+
+  friend Sse2Float operator+( Sse2Float a, Sse2Float b ) noexcept
+  {
+    return Sse2Float{ _mm_add_ps( a.value, b.value ) };
+  }
+
+  friend Sse2Float operator-( Sse2Float a, Sse2Float b ) noexcept
+  {
+    return Sse2Float{ _mm_sub_ps( a.value, b.value ) };
+  }
+
+  friend Sse2Float operator*( Sse2Float a, Sse2Float b ) noexcept
+  {
+    return Sse2Float{ _mm_mul_ps( a.value, b.value ) };
+  }
+
+  static void storeTransposed( Sse2Float x, Sse2Float y, Sse2Float z, Sse2Float w, float *const *destinations ) noexcept
+  {
+    const auto xy0 = _mm_unpacklo_ps( x.value, y.value );
+    const auto xy1 = _mm_unpackhi_ps( x.value, y.value );
+    const auto zw0 = _mm_unpacklo_ps( z.value, w.value );
+    const auto zw1 = _mm_unpackhi_ps( z.value, w.value );
+
+    _mm_storeu_ps( destinations[ 0 ], _mm_movelh_ps( xy0, zw0 ) );
+    _mm_storeu_ps( destinations[ 1 ], _mm_movehl_ps( zw0, xy0 ) );
+    _mm_storeu_ps( destinations[ 2 ], _mm_movelh_ps( xy1, zw1 ) );
+    _mm_storeu_ps( destinations[ 3 ], _mm_movehl_ps( zw1, xy1 ) );
+  }
+};
+
+using SimdFloat = Sse2Float;
+#elif defined( VULKAN_LEARNING_SIMD_NEON )
+struct NeonFloat
+{
+  float32x4_t value;
+
+  inline static constexpr std::size_t width{ 4 };
+  inline static constexpr const char *name{ "NEON" };
+
+  static NeonFloat load( const float *data ) noexcept
+  {
+    return NeonFloat{ vld1q_f32( data ) };
+  }
+
+  static NeonFloat broadcast( float value ) noexcept
+  {
+    return NeonFloat{ vdupq_n_f32( value ) };
+  }
+
+  friend NeonFloat operator+( NeonFloat a, NeonFloat b ) noexcept
+  {
+    return NeonFloat{ vaddq_f32( a.value, b.value ) };
+  }
+
+  friend NeonFloat operator-( NeonFloat a, NeonFloat b ) noexcept
+  {
+    return NeonFloat{ vsubq_f32( a.value, b.value ) };
+  }
+
+  friend NeonFloat operator*( NeonFloat a, NeonFloat b ) noexcept
+  {
+    return NeonFloat{ vmulq_f32( a.value, b.value ) };
+  }
+
+  static void storeTransposed( NeonFloat x, NeonFloat y, NeonFloat z, NeonFloat w, float *const *destinations ) noexcept
+  {
+    const auto xz = vzipq_f32( x.value, z.value );
+    const auto yw = vzipq_f32( y.value, w.value );
+    const auto lanes01 = vzipq_f32( xz.val[ 0 ], yw.val[ 0 ] );
+    const auto lanes23 = vzipq_f32( xz.val[ 1 ], yw.val[ 1 ] );
+
+    vst1q_f32( destinations[ 0 ], lanes01.val[ 0 ] );
+    vst1q_f32( destinations[ 1 ], lanes01.val[ 1 ] );
+    vst1q_f32( destinations[ 2 ], lanes23.val[ 0 ] );
+    vst1q_f32( destinations[ 3 ], lanes23.val[ 1 ] );
+  }
+};
+
+using SimdFloat = NeonFloat;
+#else
+using SimdFloat = ScalarFloat;
+#endif
+
+// Translation, rotation as a unit quaternion and scale of each instance, in structure of arrays form so that a whole batch of instances
+// loads into one register per component
+struct InstanceTransforms
+{
+  std::vector< float > positionX;
+  std::vector< float > positionY;
+  std::vector< float > positionZ;
+  std::vector< float > rotationX;
+  std::vector< float > rotationY;
+  std::vector< float > rotationZ;
+  std::vector< float > rotationW;
+  std::vector< float > scaleX;
+  std::vector< float > scaleY;
+  std::vector< float > scaleZ;
+
+  void resize( std::size_t count )
+  {
+    for( auto component : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ } )
+      component->resize( count );
+  }
+
+  std::size_t size() const noexcept
+  {
+    return positionX.size();
+  }
+};
+
+// Composes the column major translation * rotation * scale matrices of the Float::width instances from first on, every rotation being
+// turned by spin first. matrices[ lane ] points to the matrix of the instance first + lane
+template< typename Float >
+void composeInstanceMatrices( const InstanceTransforms &transforms, std::size_t first, const glm::quat &spin, float *const *matrices ) noexcept
+{
+  const auto spinX = Float::broadcast( spin.x );
+  const auto spinY = Float::broadcast( spin.y );
+  const auto spinZ = Float::broadcast( spin.z );
+  const auto spinW = Float::broadcast( spin.w );
+
+  const auto rotationX = Float::load( transforms.rotationX.data() + first );
+  const auto rotationY = Float::load( transforms.rotationY.data() + first );
+  const auto rotationZ = Float::load( transforms.rotationZ.data() + first );
+  const auto rotationW = Float::load( transforms.rotationW.data() + first );
+
+  const auto x = spinW * rotationX + spinX * rotationW + spinY * rotationZ - spinZ * rotationY;
+  const auto y = spinW * rotationY + spinY * rotationW + spinZ * rotationX - spinX * rotationZ;
+  const auto z = spinW * rotationZ + spinZ * rotationW + spinX * rotationY - spinY * rotationX;
+  const auto w = spinW * rotationW - spinX * rotationX - spinY * rotationY - spinZ * rotationZ;
+
+  const auto zero = Float::broadcast( 0.0f );
+  const auto one = Float::broadcast( 1.0f );
+  const auto two = Float::broadcast( 2.0f );
+
+  const auto xx = x * x, yy = y * y, zz = z * z;
+  const auto xy = x * y, xz = x * z, yz = y * z;
+  const auto wx = w * x, wy = w * y, wz = w * z;
+
+  const auto scaleX = Float::load( transforms.scaleX.data() + first );
+  const auto scaleY = Float::load( transforms.scaleY.data() + first );
+  const auto scaleZ = Float::load( transforms.scaleZ.data() + first );
+
+  float *columns[ Float::width ];
+
+  const auto storeColumn = [ & ]( std::size_t column, Float columnX, Float columnY, Float columnZ, Float columnW )
+  {
+    for( std::size_t lane = 0; lane < Float::width; ++lane )
+      columns[ lane ] = matrices[ lane ] + 4 * column;
+
+    Float::storeTransposed( columnX, columnY, columnZ, columnW, columns );
+  };
+
+  storeColumn( 0, ( one - two * ( yy + zz ) ) * scaleX, two * ( xy + wz ) * scaleX, two * ( xz - wy ) * scaleX, zero );
+  storeColumn( 1, two * ( xy - wz ) * scaleY, ( one - two * ( xx + zz ) ) * scaleY, two * ( yz + wx ) * scaleY, zero );
+  storeColumn( 2, two * ( xz + wy ) * scaleZ, two * ( yz - wx ) * scaleZ, ( one - two * ( xx + yy ) ) * scaleZ, zero );
+  storeColumn( 3,
+               Float::load( transforms.positionX.data() + first ),
+               Float::load( transforms.positionY.data() + first ),
+               Float::load( transforms.positionZ.data() + first ),
+               one );
+}
+
+// FNV-1a, stable across runs so that it can key files on disk
+constexpr std::uint64_t hashBytes( const void *data, std::size_t size, std::uint64_t seed = 0xcbf29ce484222325 ) noexcept
+{
+  auto hash = seed;
+
+  for( std::size_t i = 0; i < size; ++i )
+    hash = ( hash ^ static_cast< const unsigned char * >( data )[ i ] ) * 0x100000001b3;
+
+  return hash;
+}
+
+// Read only view of a whole file mapped in memory, pages are brought in as they are touched instead of being read up front
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  MappedFile( const MappedFile & ) = delete;
+  MappedFile &operator=( const MappedFile & ) = delete;
+
+  ~MappedFile()
+  {
+    close();
+  }
+
+  bool open( const std::filesystem::path &path ) noexcept
+  {
+    close();
+
+#ifdef _WIN32
+    file_ = CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+
+    if( file_ == INVALID_HANDLE_VALUE )
+      return false;
+
+    LARGE_INTEGER fileSize;
+
+    if( !GetFileSizeEx( file_, &fileSize ) || fileSize.QuadPart == 0 )
+    {
+      close();
+      return false;
+    }
+
+    mapping_ = CreateFileMappingW( file_, nullptr, PAGE_READONLY, 0, 0, nullptr );
+
+    if( mapping_ == nullptr )
+    {
+      close();
+      return false;
+    }
+
+    data_ = static_cast< const std::byte * >( MapViewOfFile( mapping_, FILE_MAP_READ, 0, 0, 0 ) );
+    size_ = static_cast< std::size_t >( fileSize.QuadPart );
+#else
+    file_ = ::open( path.c_str(), O_RDONLY );
+
+    if( file_ == -1 )
+      return false;
+
+    struct stat fileStatus;
+
+    if( fstat( file_, &fileStatus ) != 0 || fileStatus.st_size == 0 )
+    {
+      close();
+      return false;
+    }
+
+    auto data = mmap( nullptr, static_cast< std::size_t >( fileStatus.st_size ), PROT_READ, MAP_PRIVATE, file_, 0 );
+
+    if( data != MAP_FAILED )
+    {
+      madvise( data, static_cast< std::size_t >( fileStatus.st_size ), MADV_SEQUENTIAL );
+
+      data_ = static_cast< const std::byte * >( data );
+      size_ = static_cast< std::size_t >( fileStatus.st_size );
+    }
+#endif
+
+    if( data_ == nullptr )
+    {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  void close() noexcept
+  {
+#ifdef _WIN32
+    if( data_ != nullptr )
+      UnmapViewOfFile( data_ );
+
+    if( mapping_ != nullptr )
+      CloseHandle( mapping_ );
+
+    if( file_ != INVALID_HANDLE_VALUE )
+      CloseHandle( file_ );
+
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+#else
+    if( data_ != nullptr )
+      munmap( const_cast< std::byte * >( data_ ), size_ );
+
+    if( file_ != -1 )
+      ::close( file_ );
+
+    file_ = -1;
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  const std::byte *getData() const noexcept
+  {
+    return data_;
+  }
+
+  std::size_t getSize() const noexcept
+  {
+    return size_;
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE file_{ INVALID_HANDLE_VALUE };
+  HANDLE mapping_{};
+#else
+  int file_{ -1 };
+#endif
+  const std::byte *data_{};
+  std::size_t size_{};
+};
+
+// Writes pieces one after another through a temporary file so that a partially written file is never picked up, cached files being
+// only shortcuts failures are reported but not thrown
+inline bool writeCacheFile( const std::filesystem::path &path, std::initializer_list< std::span< const std::byte > > pieces )
+{
+  std::error_code error;
+  std::filesystem::create_directories( path.parent_path(), error );
+
+  auto temporaryPath = path;
+  temporaryPath += ".tmp";
+
+  {
+    std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+
+    for( auto &&piece : pieces )
+      file.write( reinterpret_cast< const char * >( piece.data() ), static_cast< std::streamsize >( piece.size() ) );
+
+    if( !file )
+    {
+      file.close();
+      std::filesystem::remove( temporaryPath, error );
+      return false;
+    }
+  }
+
+  std::filesystem::rename( temporaryPath, path, error );
+
+  return !error;
+}
+
+// Runs the program arguments[ 0 ], looked up in PATH, and waits for its exit. Arguments reach it as they are, no shell ever interprets them
+inline bool runProcess( const std::vector< std::filesystem::path > &arguments )
+{
+#ifdef _WIN32
+  std::wstring commandLine;
+
+  // quoted the way CommandLineToArgvW splits them back: backslashes are doubled only before a quote, that is escaped
+  for( auto &&argument : arguments )
+  {
+    if( !commandLine.empty() )
+      commandLine += L' ';
+
+    commandLine += L'"';
+
+    std::size_t backslashCount{};
+
+    for( auto character : argument.native() )
+    {
+      if( character == L'\\' )
+      {
+        ++backslashCount;
+        continue;
+      }
+
+      commandLine.append( character == L'"' ? 2 * backslashCount + 1 : backslashCount, L'\\' );
+      commandLine += character;
+      backslashCount = 0;
+    }
+
+    commandLine.append( 2 * backslashCount, L'\\' );
+    commandLine += L'"';
+  }
+
+  STARTUPINFOW startupInfo{ .cb{ sizeof( STARTUPINFOW ) } };
+  PROCESS_INFORMATION processInformation{};
+
+  if( !CreateProcessW( nullptr, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInformation ) )
+    return false;
+
+  WaitForSingleObject( processInformation.hProcess, INFINITE );
+
+  DWORD exitCode{};
+  const auto isExitCodeKnown = GetExitCodeProcess( processInformation.hProcess, &exitCode );
+
+  CloseHandle( processInformation.hThread );
+  CloseHandle( processInformation.hProcess );
+
+  return isExitCodeKnown && exitCode == 0;
+#else
+  std::vector< char * > argumentPointers;
+
+  for( auto &&argument : arguments )
+    argumentPointers.push_back( const_cast< char * >( argument.c_str() ) );
+
+  argumentPointers.push_back( nullptr );
+
+  pid_t processId;
+
+  if( posix_spawnp( &processId, argumentPointers.front(), nullptr, nullptr, argumentPointers.data(), environ ) != 0 )
+    return false;
+
+  int status{};
+
+  while( waitpid( processId, &status, 0 ) == -1 )
+    if( errno != EINTR )
+      return false;
+
+  return WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+#endif
+}
+
+constexpr VkDeviceSize alignUp( VkDeviceSize value, VkDeviceSize alignment ) noexcept
+{
+  return ( value + alignment - 1 ) / alignment * alignment;
+}
+
+// what a resource is used for, only kept to tell where the device memory goes
+enum class MemoryCategory : std::uint8_t
+{
+  Vertex,
+  Index,
+  Uniform,
+  Storage,
+  Staging,
+  Texture,
+  Depth,
+  Color,
+  Count
+};
+
+constexpr const char *getMemoryCategoryName( MemoryCategory category ) noexcept
+{
+  constexpr const char *names[]{ "vertex", "index", "uniform", "storage", "staging", "texture", "depth", "color" };
+
+  return names[ static_cast< std::size_t >( category ) ];
+}
+
+struct DeviceMemoryAllocation
+{
+  VkDeviceMemory memory{};
+  VkDeviceSize offset{};
+  VkDeviceSize size{};
+  void *mappedData{};
+  std::uint32_t memoryTypeIndex{};
+  std::uint32_t blockIndex{ dedicatedBlockIndex };
+  MemoryCategory category{};
+
+  inline static constexpr std::uint32_t dedicatedBlockIndex{ std::numeric_limits< std::uint32_t >::max() };
+};
+
+// Sub-allocates device memory out of large blocks kept per memory type, as the driver may only grant a few thousand vkAllocateMemory calls
+class DeviceMemoryAllocator
+{
+public:
+  // buffers and linear images never share a block with optimal images, so that bufferImageGranularity never has to be honoured inside a block
+  enum class ResourceKind : std::uint8_t
+  {
+    Linear,
+    Optimal
+  };
+
+  // bytes and count of either the VkDeviceMemory obtained from the driver or the sub-allocations handed out of them
+  struct MemoryUsage
+  {
+    VkDeviceSize size{};
+    std::uint32_t count{};
+  };
+
+  struct HeapStatistics
+  {
+    MemoryUsage deviceMemory;
+    MemoryUsage allocations;
+    // usage of the whole process (or an estimation of it) and what the driver lets it use before things start to fail or to be paged out
+    VkDeviceSize usage{};
+    VkDeviceSize budget{};
+  };
+
+  void initialize( VkPhysicalDevice physicalDevice, VkDevice logicalDevice, bool isBudgetQueryable )
+  {
+    physicalDevice_ = physicalDevice;
+    logicalDevice_ = logicalDevice;
+    isBudgetQueryable_ = isBudgetQueryable;
+
+    vkGetPhysicalDeviceMemoryProperties( physicalDevice, &memoryProperties_ );
+
+    updateBudget();
+  }
+
+  void destroy()
+  {
+    for( auto &&block : blocks_ )
+      if( block.memory != VK_NULL_HANDLE )
+        vkFreeMemory( logicalDevice_, block.memory, nullptr );
+
+    blocks_.clear();
+    deviceMemorySize_ = 0;
+  }
+
+  bool isBudgetQueryable() const noexcept
+  {
+    return isBudgetQueryable_;
+  }
+
+  // cheap enough to be called every frame, the driver only refreshes its values at its own pace anyway
+  void updateBudget()
+  {
+    if( !isBudgetQueryable_ )
+    {
+      // without VK_EXT_memory_budget only what this allocator obtained is known, other processes and the driver itself are not accounted
+      for( std::uint32_t i = 0; i < memoryProperties_.memoryHeapCount; ++i )
+      {
+        heapUsages_[ i ] = getHeapDeviceMemory( i ).size;
+        heapBudgets_[ i ] = memoryProperties_.memoryHeaps[ i ].size / 10 * estimatedBudgetPercentage_ / 10;
+      }
+
+      return;
+    }
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{ .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT } };
+    VkPhysicalDeviceMemoryProperties2 memoryProperties
+    {
+      .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2 },
+      .pNext{ &budgetProperties }
+    };
+
+    vkGetPhysicalDeviceMemoryProperties2( physicalDevice_, &memoryProperties );
+
+    for( std::uint32_t i = 0; i < memoryProperties_.memoryHeapCount; ++i )
+    {
+      heapUsages_[ i ] = budgetProperties.heapUsage[ i ];
+      heapBudgets_[ i ] = budgetProperties.heapBudget[ i ];
+    }
+  }
+
+  HeapStatistics getHeapStatistics( std::uint32_t heapIndex ) const noexcept
+  {
+    HeapStatistics statistics
+    {
+      .deviceMemory{ getHeapDeviceMemory( heapIndex ) },
+      .usage{ heapUsages_[ heapIndex ] },
+      .budget{ heapBudgets_[ heapIndex ] }
+    };
+
+    for( std::uint32_t i = 0; i < memoryProperties_.memoryTypeCount; ++i )
+      if( memoryProperties_.memoryTypes[ i ].heapIndex == heapIndex )
+      {
+        statistics.allocations.size += memoryTypeAllocations_[ i ].size;
+        statistics.allocations.count += memoryTypeAllocations_[ i ].count;
+      }
+
+    return statistics;
+  }
+
+  const MemoryUsage &getMemoryTypeDeviceMemory( std::uint32_t memoryTypeIndex ) const noexcept
+  {
+    return memoryTypeDeviceMemories_[ memoryTypeIndex ];
+  }
+
+  const MemoryUsage &getMemoryTypeAllocations( std::uint32_t memoryTypeIndex ) const noexcept
+  {
+    return memoryTypeAllocations_[ memoryTypeIndex ];
+  }
+
+  const MemoryUsage &getCategoryAllocations( MemoryCategory category ) const noexcept
+  {
+    return categoryAllocations_[ static_cast< std::size_t >( category ) ];
+  }
+
+  // what may still be allocated out of the heap backing these properties until the budget is reached, as of the last updateBudget()
+  VkDeviceSize getBudgetHeadroom( VkMemoryPropertyFlags properties ) const
+  {
+    const auto heapIndex = memoryProperties_.memoryTypes[ findMemoryType( ~0u, properties ) ].heapIndex;
+
+    return heapBudgets_[ heapIndex ] > heapUsages_[ heapIndex ] ? heapBudgets_[ heapIndex ] - heapUsages_[ heapIndex ] : 0;
+  }
+
+  const VkPhysicalDeviceMemoryProperties &getMemoryProperties() const noexcept
+  {
+    return memoryProperties_;
+  }
+
+  // counts what has been obtained from the driver, blocks included as a whole however full they are
+  VkDeviceSize getPeakDeviceMemorySize() const noexcept
+  {
+    return peakDeviceMemorySize_;
+  }
+
+  std::uint32_t findMemoryType( std::uint32_t typeFilter, VkMemoryPropertyFlags properties ) const
+  {
+    for( std::uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++ )
+      if( ( typeFilter & ( 1 << i ) ) && ( memoryProperties_.memoryTypes[ i ].propertyFlags & properties ) == properties )
+        return i;
+
+    throw std::runtime_error{ "Error failed to find suitable memory type!" };
+  }
+
+  bool isMemoryTypeAvailable( std::uint32_t typeFilter, VkMemoryPropertyFlags properties ) const noexcept
+  {
+    for( std::uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++ )
+      if( ( typeFilter & ( 1 << i ) ) && ( memoryProperties_.memoryTypes[ i ].propertyFlags & properties ) == properties )
+        return true;
+
+    return false;
+  }
+
+  DeviceMemoryAllocation allocate( const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, ResourceKind kind, MemoryCategory category )
+  {
+    auto allocation = allocateRange( requirements, properties, kind );
+    allocation.category = category;
+
+    addUsage( memoryTypeAllocations_[ allocation.memoryTypeIndex ], allocation.size );
+    addUsage( categoryAllocations_[ static_cast< std::size_t >( category ) ], allocation.size );
+
+    return allocation;
+  }
+
+  void free( DeviceMemoryAllocation &allocation )
+  {
+    if( allocation.memory == VK_NULL_HANDLE )
+      return;
+
+    removeUsage( memoryTypeAllocations_[ allocation.memoryTypeIndex ], allocation.size );
+    removeUsage( categoryAllocations_[ static_cast< std::size_t >( allocation.category ) ], allocation.size );
+
+    if( allocation.blockIndex == DeviceMemoryAllocation::dedicatedBlockIndex )
+    {
+      vkFreeMemory( logicalDevice_, allocation.memory, nullptr );
+      deviceMemorySize_ -= allocation.size;
+      removeUsage( memoryTypeDeviceMemories_[ allocation.memoryTypeIndex ], allocation.size );
+    }
+    else
+      blocks_[ allocation.blockIndex ].freeRange( allocation.offset, allocation.size );
+
+    allocation = {};
+  }
+
+private:
+  struct FreeRange
+  {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+
+  struct MemoryBlock
+  {
+    VkDeviceMemory memory{};
+    VkDeviceSize size{};
+    void *mappedData{};
+    std::uint32_t memoryTypeIndex{};
+    ResourceKind kind{};
+    // kept sorted by offset so that neighbours can be coalesced on free
+    std::vector< FreeRange > freeRanges;
+
+    std::optional< VkDeviceSize > allocateRange( VkDeviceSize requestedSize, VkDeviceSize alignment )
+    {
+      for( auto it = freeRanges.begin(); it != freeRanges.end(); ++it )
+      {
+        const auto alignedOffset = alignUp( it->offset, alignment );
+        const auto rangeEnd = it->offset + it->size;
+
+        if( alignedOffset + requestedSize > rangeEnd )
+          continue;
+
+        const auto padding = alignedOffset - it->offset;
+        const auto remainder = rangeEnd - alignedOffset - requestedSize;
+
+        // the alignment padding stays in the free list and is merged back as soon as its neighbour is freed
+        if( padding > 0 && remainder > 0 )
+        {
+          it->size = padding;
+          freeRanges.insert( std::next( it ), FreeRange{ alignedOffset + requestedSize, remainder } );
+        }
+        else if( padding > 0 )
+          it->size = padding;
+        else if( remainder > 0 )
+          *it = FreeRange{ alignedOffset + requestedSize, remainder };
+        else
+          freeRanges.erase( it );
+
+        return alignedOffset;
+      }
+
+      return std::nullopt;
+    }
+
+    void freeRange( VkDeviceSize offset, VkDeviceSize rangeSize )
+    {
+      auto next = std::lower_bound( freeRanges.begin(),
+                                    freeRanges.end(),
+                                    offset,
+                                    []( const FreeRange &range, VkDeviceSize value ) { return range.offset < value; } );
+
+      auto current = freeRanges.insert( next, FreeRange{ offset, rangeSize } );
+
+      if( std::next( current ) != freeRanges.end() && current->offset + current->size == std::next( current )->offset )
+      {
+        current->size += std::next( current )->size;
+        freeRanges.erase( std::next( current ) );
+      }
+
+      if( current != freeRanges.begin() && std::prev( current )->offset + std::prev( current )->size == current->offset )
+      {
+        std::prev( current )->size += current->size;
+        freeRanges.erase( current );
+      }
+    }
+  };
+
+  static void addUsage( MemoryUsage &usage, VkDeviceSize size ) noexcept
+  {
+    usage.size += size;
+    ++usage.count;
+  }
+
+  static void removeUsage( MemoryUsage &usage, VkDeviceSize size ) noexcept
+  {
+    usage.size -= size;
+    --usage.count;
+  }
+
+  MemoryUsage getHeapDeviceMemory( std::uint32_t heapIndex ) const noexcept
+  {
+    MemoryUsage usage;
+
+    for( std::uint32_t i = 0; i < memoryProperties_.memoryTypeCount; ++i )
+      if( memoryProperties_.memoryTypes[ i ].heapIndex == heapIndex )
+      {
+        usage.size += memoryTypeDeviceMemories_[ i ].size;
+        usage.count += memoryTypeDeviceMemories_[ i ].count;
+      }
+
+    return usage;
+  }
+
+  DeviceMemoryAllocation allocateRange( const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, ResourceKind kind )
+  {
+    const auto memoryTypeIndex = findMemoryType( requirements.memoryTypeBits, properties );
+
+    // lazily allocated memory is only backed as far as the tiles need it, a shared block would be backed as a whole
+    if( requirements.size > getBlockSize( memoryTypeIndex ) / 2 || ( properties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT ) )
+      return allocateDedicated( requirements.size, memoryTypeIndex );
+
+    for( std::uint32_t i = 0; i < blocks_.size(); ++i )
+    {
+      auto &block = blocks_[ i ];
+
+      if( block.memory == VK_NULL_HANDLE || block.memoryTypeIndex != memoryTypeIndex || block.kind != kind )
+        continue;
+
+      if( auto offset = block.allocateRange( requirements.size, requirements.alignment ) )
+        return makeAllocation( block, i, offset.value(), requirements.size );
+    }
+
+    const auto blockIndex = createBlock( memoryTypeIndex, kind );
+    auto &block = blocks_[ blockIndex ];
+
+    return makeAllocation( block, blockIndex, block.allocateRange( requirements.size, requirements.alignment ).value(), requirements.size );
+  }
+
+  VkDeviceSize getBlockSize( std::uint32_t memoryTypeIndex ) const noexcept
+  {
+    const auto heapSize = memoryProperties_.memoryHeaps[ memoryProperties_.memoryTypes[ memoryTypeIndex ].heapIndex ].size;
+
+    // small heaps (i.e. 256MiB host visible device local window) must not be eaten by a couple of blocks
+    return std::min( preferredBlockSize_, heapSize / 8 );
+  }
+
+  bool isHostVisible( std::uint32_t memoryTypeIndex ) const noexcept
+  {
+    return memoryProperties_.memoryTypes[ memoryTypeIndex ].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  }
+
+  VkDeviceMemory allocateDeviceMemory( VkDeviceSize allocationSize, std::uint32_t memoryTypeIndex, void **mappedData )
+  {
+    VkMemoryAllocateInfo allocInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO },
+      .allocationSize{ allocationSize },
+      .memoryTypeIndex{ memoryTypeIndex }
+    };
+
+    VkDeviceMemory memory;
+    if( vkAllocateMemory( logicalDevice_, &allocInfo, nullptr, &memory ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to allocate device memory!" };
+
+    // host visible memory is mapped once for its whole lifetime, mapping is not free and only one mapping per VkDeviceMemory is allowed
+    if( isHostVisible( memoryTypeIndex ) && vkMapMemory( logicalDevice_, memory, 0, VK_WHOLE_SIZE, 0, mappedData ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to map device memory!" };
+
+    deviceMemorySize_ += allocationSize;
+    peakDeviceMemorySize_ = std::max( peakDeviceMemorySize_, deviceMemorySize_ );
+    addUsage( memoryTypeDeviceMemories_[ memoryTypeIndex ], allocationSize );
+
+    return memory;
+  }
+
+  DeviceMemoryAllocation allocateDedicated( VkDeviceSize allocationSize, std::uint32_t memoryTypeIndex )
+  {
+    DeviceMemoryAllocation allocation
+    {
+      .size{ allocationSize },
+      .memoryTypeIndex{ memoryTypeIndex }
+    };
+
+    allocation.memory = allocateDeviceMemory( allocationSize, memoryTypeIndex, &allocation.mappedData );
+
+    return allocation;
+  }
+
+  std::uint32_t createBlock( std::uint32_t memoryTypeIndex, ResourceKind kind )
+  {
+    MemoryBlock block
+    {
+      .size{ getBlockSize( memoryTypeIndex ) },
+      .memoryTypeIndex{ memoryTypeIndex },
+      .kind{ kind }
+    };
+
+    block.memory = allocateDeviceMemory( block.size, memoryTypeIndex, &block.mappedData );
+    block.freeRanges.push_back( FreeRange{ 0, block.size } );
+
+    blocks_.push_back( std::move( block ) );
+
+    return static_cast< std::uint32_t >( blocks_.size() - 1 );
+  }
+
+  static DeviceMemoryAllocation makeAllocation( const MemoryBlock &block, std::uint32_t blockIndex, VkDeviceSize offset, VkDeviceSize allocationSize )
+  {
+    return DeviceMemoryAllocation
+    {
+      .memory{ block.memory },
+      .offset{ offset },
+      .size{ allocationSize },
+      .mappedData{ block.mappedData ? static_cast< std::byte * >( block.mappedData ) + offset : nullptr },
+      .memoryTypeIndex{ block.memoryTypeIndex },
+      .blockIndex{ blockIndex }
+    };
+  }
+
+private:
+  VkPhysicalDevice physicalDevice_{};
+  VkDevice logicalDevice_{};
+  VkPhysicalDeviceMemoryProperties memoryProperties_{};
+  bool isBudgetQueryable_{};
+  // blocks are never released before destroy(), swap chain recreation keeps reusing them without hitting the driver
+  std::vector< MemoryBlock > blocks_;
+  VkDeviceSize deviceMemorySize_{};
+  VkDeviceSize peakDeviceMemorySize_{};
+  std::array< MemoryUsage, VK_MAX_MEMORY_TYPES > memoryTypeDeviceMemories_{};
+  std::array< MemoryUsage, VK_MAX_MEMORY_TYPES > memoryTypeAllocations_{};
+  std::array< MemoryUsage, static_cast< std::size_t >( MemoryCategory::Count ) > categoryAllocations_{};
+  std::array< VkDeviceSize, VK_MAX_MEMORY_HEAPS > heapUsages_{};
+  std::array< VkDeviceSize, VK_MAX_MEMORY_HEAPS > heapBudgets_{};
+
+  inline static constexpr VkDeviceSize preferredBlockSize_{ 64 * 1024 * 1024 };
+  // a common rule of thumb for what an application may take out of a heap when the driver does not tell
+  inline static constexpr VkDeviceSize estimatedBudgetPercentage_{ 80 };
+};
+
+// Hands out regions of one persistently mapped staging buffer in a circular fashion, regions are given back in submission order once the
+// upload timeline semaphore reaches the value they were committed with
+class StagingRing
+{
+public:
+  struct Region
+  {
+    VkDeviceSize offset;
+    void *mappedData;
+  };
+
+  void initialize( VkBuffer buffer, const DeviceMemoryAllocation &allocation ) noexcept
+  {
+    buffer_ = buffer;
+    allocation_ = allocation;
+    head_ = tail_ = usedSize_ = 0;
+    inFlightRegions_.clear();
+  }
+
+  VkBuffer getBuffer() const noexcept
+  {
+    return buffer_;
+  }
+
+  DeviceMemoryAllocation &getAllocation() noexcept
+  {
+    return allocation_;
+  }
+
+  VkDeviceSize getCapacity() const noexcept
+  {
+    return allocation_.size;
+  }
+
+  bool hasUncommittedRegions() const noexcept
+  {
+    return !inFlightRegions_.empty() && inFlightRegions_.back().completionValue == uncommittedValue;
+  }
+
+  std::optional< std::uint64_t > getOldestCommittedValue() const noexcept
+  {
+    if( inFlightRegions_.empty() || inFlightRegions_.front().completionValue == uncommittedValue )
+      return std::nullopt;
+
+    return inFlightRegions_.front().completionValue;
+  }
+
+  std::optional< Region > allocate( VkDeviceSize size, VkDeviceSize alignment )
+  {
+    const auto capacity = getCapacity();
+
+    if( usedSize_ == 0 )
+      head_ = tail_ = 0;
+    else if( head_ == tail_ )
+      return std::nullopt;
+
+    auto offset = alignUp( head_, alignment );
+
+    // free space is [head, capacity) then [0, tail) when the ring is not wrapped, [head, tail) otherwise
+    if( head_ >= tail_ && offset + size > capacity )
+    {
+      if( size > tail_ && usedSize_ != 0 )
+        return std::nullopt;
+
+      offset = 0;
+    }
+    else if( head_ < tail_ && offset + size > tail_ )
+      return std::nullopt;
+
+    const auto end = offset + size;
+    const auto consumedSize = offset >= head_ ? end - head_ : capacity - head_ + end;
+
+    if( usedSize_ + consumedSize > capacity )
+      return std::nullopt;
+
+    inFlightRegions_.push_back( InFlightRegion{ end, consumedSize, uncommittedValue } );
+    usedSize_ += consumedSize;
+    head_ = end == capacity ? 0 : end;
+
+    return Region{ offset, static_cast< std::byte * >( allocation_.mappedData ) + offset };
+  }
+
+  void commit( std::uint64_t completionValue ) noexcept
+  {
+    for( auto it = inFlightRegions_.rbegin(); it != inFlightRegions_.rend() && it->completionValue == uncommittedValue; ++it )
+      it->completionValue = completionValue;
+  }
+
+  void retire( std::uint64_t completedValue ) noexcept
+  {
+    while( !inFlightRegions_.empty() && inFlightRegions_.front().completionValue <= completedValue )
+    {
+      const auto &region = inFlightRegions_.front();
+
+      tail_ = region.end == getCapacity() ? 0 : region.end;
+      usedSize_ -= region.consumedSize;
+      inFlightRegions_.pop_front();
+    }
+  }
+
+private:
+  struct InFlightRegion
+  {
+    VkDeviceSize end;
+    // includes the alignment padding and the unused tail of the ring when the region wrapped
+    VkDeviceSize consumedSize;
+    std::uint64_t completionValue;
+  };
+
+  inline static constexpr std::uint64_t uncommittedValue{ std::numeric_limits< std::uint64_t >::max() };
+
+  VkBuffer buffer_{};
+  DeviceMemoryAllocation allocation_{};
+  VkDeviceSize head_{};
+  VkDeviceSize tail_{};
+  VkDeviceSize usedSize_{};
+  std::deque< InFlightRegion > inFlightRegions_;
+};
+
+// Keeps a rolling window of frame times for percentiles, and when capturing, every frame and CPU scope for export
+class Profiler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct FrameTimePercentiles
+  {
+    double p50;
+    double p95;
+    double p99;
+  };
+
+  void enableCapture() noexcept
+  {
+    isCapturing_ = true;
+  }
+
+  bool isCapturing() const noexcept
+  {
+    return isCapturing_;
+  }
+
+  // a frame lasts until the next one begins
+  void beginFrame()
+  {
+    std::lock_guard lock{ mutex_ };
+
+    const auto now = Clock::now();
+
+    if( frameIndex_ > 0 )
+    {
+      const auto frameTime = getMilliseconds( frameBegin_, now );
+
+      frameTimes_[ ( frameIndex_ - 1 ) % frameTimeWindowSize_ ] = frameTime;
+
+      if( isCapturing_ && !capturedFrames_.empty() )
+        capturedFrames_.back().cpuMilliseconds = frameTime;
+    }
+
+    frameBegin_ = now;
+    ++frameIndex_;
+
+    if( isCapturing_ )
+      capturedFrames_.push_back( CapturedFrame{ .frameIndex{ frameIndex_ }, .begin{ now } } );
+  }
+
+  std::uint64_t getFrameIndex() const
+  {
+    std::lock_guard lock{ mutex_ };
+
+    return frameIndex_;
+  }
+
+  void recordCpuScope( const char *name, Clock::time_point begin, Clock::time_point end )
+  {
+    std::lock_guard lock{ mutex_ };
+
+    if( isCapturing_ && !capturedFrames_.empty() )
+      capturedScopes_.push_back( CapturedScope{ name, frameIndex_, begin, end } );
+  }
+
+  // sampled once per frame under a name that must outlive the profiler, kept in MiB
+  void recordMemoryCounter( const char *name, VkDeviceSize size )
+  {
+    std::lock_guard lock{ mutex_ };
+
+    if( isCapturing_ && !capturedFrames_.empty() )
+      capturedCounters_.push_back( CapturedCounter{ name, frameIndex_, Clock::now(), static_cast< double >( size ) / bytesPerMebibyte_ } );
+  }
+
+  // GPU times are only known once the frame has been executed, several frames after it began
+  void recordGpuFrameTime( std::uint64_t frameIndex, double milliseconds )
+  {
+    std::lock_guard lock{ mutex_ };
+
+    lastGpuFrameTime_ = milliseconds;
+
+    if( !isCapturing_ || capturedFrames_.empty() || frameIndex < capturedFrames_.front().frameIndex )
+      return;
+
+    const auto capturedFrameIndex = frameIndex - capturedFrames_.front().frameIndex;
+
+    if( capturedFrameIndex < capturedFrames_.size() )
+      capturedFrames_[ capturedFrameIndex ].gpuMilliseconds = milliseconds;
+  }
+
+  double getLastGpuFrameTime() const
+  {
+    std::lock_guard lock{ mutex_ };
+
+    return lastGpuFrameTime_;
+  }
+
+  FrameTimePercentiles getFrameTimePercentiles() const
+  {
+    std::lock_guard lock{ mutex_ };
+
+    const auto sampleCount = static_cast< std::size_t >( std::min< std::uint64_t >( frameIndex_ > 0 ? frameIndex_ - 1 : 0, frameTimeWindowSize_ ) );
+
+    if( sampleCount == 0 )
+      return {};
+
+    std::vector< double > samples( frameTimes_.begin(), frameTimes_.begin() + sampleCount );
+
+    const auto percentile = [ &samples ]( double rank )
+    {
+      const auto nth = samples.begin() + static_cast< std::ptrdiff_t >( rank * ( samples.size() - 1 ) );
+      std::nth_element( samples.begin(), nth, samples.end() );
+
+      return *nth;
+    };
+
+    return FrameTimePercentiles{ percentile( 0.50 ), percentile( 0.95 ), percentile( 0.99 ) };
+  }
+
+  // one row per frame, GPU time left empty when it could not be measured, then one column per scope name summing its occurrences and one
+  // column per memory counter holding its last sample of the frame
+  void exportCsv( const std::filesystem::path &path ) const
+  {
+    std::ofstream file{ path, std::ios::trunc };
+
+    if( !file )
+      throw std::runtime_error{ "Error failed to write profile capture " + path.string() + "!" };
+
+    const auto scopeNames = getCapturedNames( capturedScopes_ );
+    const auto counterNames = getCapturedNames( capturedCounters_ );
+
+    file << "frame,cpu_ms,gpu_ms";
+
+    for( auto &&name : scopeNames )
+      file << ',' << name << "_ms";
+
+    for( auto &&name : counterNames )
+      file << ',' << name << "_mib";
+
+    file << '\n';
+
+    auto scope = capturedScopes_.begin();
+    auto counter = capturedCounters_.begin();
+
+    for( auto &&frame : capturedFrames_ )
+    {
+      std::vector< double > scopeTimes( scopeNames.size() );
+
+      for( ; scope != capturedScopes_.end() && scope->frameIndex == frame.frameIndex; ++scope )
+      {
+        const auto nameIndex = std::find( scopeNames.begin(), scopeNames.end(), scope->name ) - scopeNames.begin();
+        scopeTimes[ nameIndex ] += getMilliseconds( scope->begin, scope->end );
+      }
+
+      file << frame.frameIndex << ',' << frame.cpuMilliseconds << ',';
+
+      if( frame.gpuMilliseconds.has_value() )
+        file << frame.gpuMilliseconds.value();
+
+      std::vector< std::optional< double > > counterValues( counterNames.size() );
+
+      for( ; counter != capturedCounters_.end() && counter->frameIndex == frame.frameIndex; ++counter )
+        counterValues[ std::find( counterNames.begin(), counterNames.end(), counter->name ) - counterNames.begin() ] = counter->value;
+
+      for( auto &&scopeTime : scopeTimes )
+        file << ',' << scopeTime;
+
+      for( auto &&counterValue : counterValues )
+      {
+        file << ',';
+
+        if( counterValue.has_value() )
+          file << counterValue.value();
+      }
+
+      file << '\n';
+    }
+  }
+
+  // loadable in chrome://tracing or Perfetto, GPU frames have no common clock with the CPU and are drawn from the frame beginning
+  void exportChromeTrace( const std::filesystem::path &path ) const
+  {
+    std::ofstream file{ path, std::ios::trunc };
+
+    if( !file )
+      throw std::runtime_error{ "Error failed to write profile trace " + path.string() + "!" };
+
+    const auto origin = capturedFrames_.empty() ? Clock::time_point{} : capturedFrames_.front().begin;
+    const auto toMicroseconds = [ origin ]( Clock::time_point time )
+    {
+      return std::chrono::duration< double, std::micro >( time - origin ).count();
+    };
+
+    file << std::fixed << std::setprecision( 3 );
+    file << "[\n"
+         << R"({"name":"thread_name","ph":"M","pid":0,"tid":0,"args":{"name":"CPU"}},)" << '\n'
+         << R"({"name":"thread_name","ph":"M","pid":0,"tid":1,"args":{"name":"GPU"}})";
+
+    for( auto &&frame : capturedFrames_ )
+    {
+      const auto begin = toMicroseconds( frame.begin );
+
+      file << ",\n" << R"({"name":"frame )" << frame.frameIndex << R"(","ph":"X","pid":0,"tid":0,"ts":)" << begin
+           << R"(,"dur":)" << frame.cpuMilliseconds * 1000.0 << '}';
+
+      if( frame.gpuMilliseconds.has_value() )
+        file << ",\n" << R"({"name":"render pass","ph":"X","pid":0,"tid":1,"ts":)" << begin
+             << R"(,"dur":)" << frame.gpuMilliseconds.value() * 1000.0 << '}';
+    }
+
+    for( auto &&scope : capturedScopes_ )
+      file << ",\n" << R"({"name":")" << scope.name << R"(","ph":"X","pid":0,"tid":0,"ts":)" << toMicroseconds( scope.begin )
+           << R"(,"dur":)" << std::chrono::duration< double, std::micro >( scope.end - scope.begin ).count() << '}';
+
+    for( auto &&counter : capturedCounters_ )
+      file << ",\n" << R"({"name":")" << counter.name << R"(","ph":"C","pid":0,"ts":)" << toMicroseconds( counter.time )
+           << R"(,"args":{"MiB":)" << counter.value << "}}";
+
+    file << "\n]\n";
+
+    if( !file )
+      throw std::runtime_error{ "Error failed to write profile trace " + path.string() + "!" };
+  }
+
+private:
+  struct CapturedFrame
+  {
+    std::uint64_t frameIndex;
+    Clock::time_point begin;
+    double cpuMilliseconds{};
+    std::optional< double > gpuMilliseconds;
+  };
+
+  struct CapturedScope
+  {
+    const char *name;
+    std::uint64_t frameIndex;
+    Clock::time_point begin;
+    Clock::time_point end;
+  };
+
+  struct CapturedCounter
+  {
+    const char *name;
+    std::uint64_t frameIndex;
+    Clock::time_point time;
+    double value;
+  };
+
+  static double getMilliseconds( Clock::time_point begin, Clock::time_point end ) noexcept
+  {
+    return std::chrono::duration< double, std::milli >( end - begin ).count();
+  }
+
+  template< typename CapturedSample >
+  static std::vector< std::string > getCapturedNames( const std::vector< CapturedSample > &samples )
+  {
+    std::vector< std::string > names;
+
+    for( auto &&sample : samples )
+      if( std::find( names.begin(), names.end(), sample.name ) == names.end() )
+        names.emplace_back( sample.name );
+
+    return names;
+  }
+
+  inline static constexpr std::size_t frameTimeWindowSize_{ 1024 };
+  inline static constexpr double bytesPerMebibyte_{ 1024.0 * 1024.0 };
+
+  // the frame stages record while the simulation reads the frame times, exports only happen once they are all stopped
+  mutable std::mutex mutex_;
+  std::array< double, frameTimeWindowSize_ > frameTimes_{};
+  std::uint64_t frameIndex_{};
+  Clock::time_point frameBegin_;
+  double lastGpuFrameTime_{};
+  bool isCapturing_{};
+  std::vector< CapturedFrame > capturedFrames_;
+  std::vector< CapturedScope > capturedScopes_;
+  std::vector< CapturedCounter > capturedCounters_;
+};
+
+// Records the CPU time spent in its scope under a name that must outlive the profiler, typically a literal
+class ScopedTimer
+{
+public:
+  ScopedTimer( Profiler &profiler, const char *name ) : profiler_{ profiler }, name_{ name }, begin_{ Profiler::Clock::now() } {}
+  ScopedTimer( const ScopedTimer & ) = delete;
+  ScopedTimer &operator=( const ScopedTimer & ) = delete;
+
+  ~ScopedTimer()
+  {
+    profiler_.recordCpuScope( name_, begin_, Profiler::Clock::now() );
+  }
+
+private:
+  Profiler &profiler_;
+  const char *name_;
+  Profiler::Clock::time_point begin_;
+};
+
+// Owns the shader modules, that outlive the pipelines built upon them. Shaders with a watched source are compiled from it into a cache keyed
+// by the hash of its content, again in the background whenever it changes, the others come precompiled with the application
+class ShaderManager
+{
+public:
+  ShaderManager() = default;
+  ShaderManager( const ShaderManager & ) = delete;
+  ShaderManager &operator=( const ShaderManager & ) = delete;
+
+  // without a source directory, only the precompiled modules of binaryDirectory are used
+  void initialize( VkDevice logicalDevice, std::filesystem::path binaryDirectory, std::optional< std::filesystem::path > sourceDirectory )
+  {
+    logicalDevice_ = logicalDevice;
+    binaryDirectory_ = std::move( binaryDirectory );
+    sourceDirectory_ = std::move( sourceDirectory );
+  }
+
+  void destroy()
+  {
+    // the compilation is not cancellable, its results are simply dropped
+    if( pendingCompilation_.valid() )
+      pendingCompilation_.wait();
+
+    for( auto &&[name, module] : modules_ )
+      vkDestroyShaderModule( logicalDevice_, module, nullptr );
+
+    modules_.clear();
+  }
+
+  // the stage is deduced from the extension of the source file
+  void watchSource( std::string name, const std::filesystem::path &sourceFileName )
+  {
+    if( !sourceDirectory_.has_value() )
+      return;
+
+    auto path = sourceDirectory_.value() / sourceFileName;
+    const auto writeTime = getWriteTime( path );
+
+    sources_.push_back( { std::move( name ), std::move( path ), writeTime } );
+  }
+
+  // the module named after name.spv, falling back on the precompiled one should its source fail to compile
+  VkShaderModule getModule( const std::string &name )
+  {
+    if( auto module = modules_.find( name ); module != modules_.end() )
+      return module->second;
+
+    std::optional< std::vector< char > > code;
+
+    if( auto source = std::find_if( sources_.begin(), sources_.end(), [ & ]( auto &&source ) { return source.name == name; } ); source != sources_.end() )
+      code = compile( source->path );
+
+    if( !code.has_value() )
+      code = readFile( binaryDirectory_ / ( name + ".spv" ) );
+
+    if( !code.has_value() )
+      throw std::runtime_error{ "Error while loading shader module" };
+
+    return modules_[ name ] = createModule( code.value() );
+  }
+
+  // Once per frame. Compiles the sources changed since the last check in the background and returns true once their modules have been
+  // replaced, the pipelines using the previous ones are then to be created again
+  bool updateModules()
+  {
+    if( pendingCompilation_.valid() )
+    {
+      if( pendingCompilation_.wait_for( std::chrono::seconds{ 0 } ) != std::future_status::ready )
+        return false;
+
+      return replaceModules( pendingCompilation_.get() );
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if( sources_.empty() || now - lastWatchTime_ < watchPeriod_ )
+      return false;
+
+    lastWatchTime_ = now;
+
+    std::vector< Source > changedSources;
+
+    for( auto &&source : sources_ )
+    {
+      const auto writeTime = getWriteTime( source.path );
+
+      if( writeTime == source.writeTime )
+        continue;
+
+      source.writeTime = writeTime;
+      changedSources.push_back( source );
+    }
+
+    if( !changedSources.empty() )
+      pendingCompilation_ = std::async( std::launch::async, [ this, changedSources = std::move( changedSources ) ]
+      {
+        std::vector< CompiledShader > compiledShaders;
+
+        for( auto &&source : changedSources )
+          compiledShaders.push_back( { source.name, compile( source.path ) } );
+
+        return compiledShaders;
+      } );
+
+    return false;
+  }
+
+private:
+  struct Source
+  {
+    std::string name;
+    std::filesystem::path path;
+    std::filesystem::file_time_type writeTime;
+  };
+
+  struct CompiledShader
+  {
+    std::string name;
+    std::optional< std::vector< char > > code;
+  };
+
+  static std::filesystem::file_time_type getWriteTime( const std::filesystem::path &path ) noexcept
+  {
+    std::error_code error;
+    const auto writeTime = std::filesystem::last_write_time( path, error );
+
+    return error ? std::filesystem::file_time_type{} : writeTime;
+  }
+
+  static std::optional< std::vector< char > > readFile( const std::filesystem::path &path )
+  {
+    std::ifstream file{ path, std::ios::ate | std::ios::binary };
+
+    if( !file.is_open() )
+      return std::nullopt;
+
+    std::vector< char > content( static_cast< std::size_t >( file.tellg() ) );
+
+    file.seekg( 0 );
+    file.read( content.data(), static_cast< std::streamsize >( content.size() ) );
+
+    if( !file )
+      return std::nullopt;
+
+    return content;
+  }
+
+  // an unchanged source is never compiled twice, whatever the number of runs in between
+  std::optional< std::vector< char > > compile( const std::filesystem::path &sourcePath ) const
+  {
+    std::filesystem::path cachedPath;
+
+    {
+      MappedFile source;
+
+      if( !source.open( sourcePath ) )
+        return std::nullopt;
+
+      std::ostringstream fileName;
+      fileName << sourcePath.filename().string() << '.' << std::hex << std::setw( 16 ) << std::setfill( '0' )
+               << hashBytes( source.getData(), source.getSize() ) << ".spv";
+
+      cachedPath = binaryDirectory_ / "cache" / fileName.str();
+    }
+
+    if( auto code = readFile( cachedPath ) )
+      return code;
+
+    if( !runCompiler( sourcePath, cachedPath ) )
+    {
+      std::cerr << "Error failed to compile " << sourcePath.string() << ", keeping the previous module" << std::endl;
+      return std::nullopt;
+    }
+
+    return readFile( cachedPath );
+  }
+
+  // through a temporary file, a failed or partial compilation never lands in the cache
+  static bool runCompiler( const std::filesystem::path &sourcePath, const std::filesystem::path &outputPath )
+  {
+    std::error_code error;
+    std::filesystem::create_directories( outputPath.parent_path(), error );
+
+    auto temporaryPath = outputPath;
+    temporaryPath += ".tmp";
+
+    // source names come from the user, they are never handed over to a shell
+    if( !runProcess( { compilerCommand_, sourcePath, "-o", temporaryPath } ) )
+    {
+      std::filesystem::remove( temporaryPath, error );
+      return false;
+    }
+
+    std::filesystem::rename( temporaryPath, outputPath, error );
+
+    return !error;
+  }
+
+  VkShaderModule createModule( const std::vector< char > &code ) const
+  {
+    VkShaderModuleCreateInfo createInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO },
+      .codeSize{ code.size() },
+      .pCode{ reinterpret_cast< const uint32_t * >( code.data() ) }
+    };
+
+    VkShaderModule shaderModule;
+    if( vkCreateShaderModule( logicalDevice_, &createInfo, nullptr, &shaderModule ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create shader module!" };
+
+    return shaderModule;
+  }
+
+  // pipelines keep working without the modules they were created from, the previous ones are destroyed right away
+  bool replaceModules( std::vector< CompiledShader > compiledShaders )
+  {
+    bool isAnyModuleReplaced{};
+
+    for( auto &&compiledShader : compiledShaders )
+    {
+      if( !compiledShader.code.has_value() )
+        continue;
+
+      auto &module = modules_[ compiledShader.name ];
+
+      if( module != VK_NULL_HANDLE )
+        vkDestroyShaderModule( logicalDevice_, module, nullptr );
+
+      module = createModule( compiledShader.code.value() );
+      isAnyModuleReplaced = true;
+    }
+
+    return isAnyModuleReplaced;
+  }
+
+  // glslc of the Vulkan SDK, its installer puts it on the path
+  inline static constexpr std::string_view compilerCommand_{ "glslc" };
+  inline static constexpr std::chrono::milliseconds watchPeriod_{ 500 };
+
+  VkDevice logicalDevice_{};
+  std::filesystem::path binaryDirectory_;
+  std::optional< std::filesystem::path > sourceDirectory_;
+  std::vector< Source > sources_;
+  std::map< std::string, VkShaderModule > modules_;
+  std::future< std::vector< CompiledShader > > pendingCompilation_;
+  std::chrono::steady_clock::time_point lastWatchTime_;
+};
+
+// trades input to display latency against frame rate stability and power draw
+enum class LatencyPolicy
+{
+  // mailbox presentation when available, FIFO otherwise, two frames in flight
+  lowLatency,
+  // immediate presentation when available, tearing included, then as lowLatency. Opt-in only
+  uncapped,
+  // FIFO presentation, three frames in flight
+  throughput,
+  // FIFO presentation with as few images as possible, one frame in flight
+  powerSave
+};
+
+struct ApplicationOptions
+{
+  std::optional< std::filesystem::path > profileCsvPath;
+  std::optional< std::filesystem::path > profileTracePath;
+  // renders that many frames offscreen, without window nor swap chain, then reports
+  std::optional< std::uint32_t > benchmarkFrameCount;
+  // records draw command buffers once per swap chain image instead of once per frame
+  bool prebakedCommandBuffers{};
+  // copies of the model laid out on a grid, all drawn at once
+  std::uint32_t instanceCount{ 1 };
+  LatencyPolicy latencyPolicy{ LatencyPolicy::lowLatency };
+  // samples per pixel asked for, lowered to what the device supports
+  std::uint32_t msaaSampleCount{ 1 };
+  // lays depth down before shading, toggled at runtime with the Z key
+  bool depthPrePass{};
+  // compiles the shaders from there instead of using the precompiled ones, and reloads them as they change
+  std::optional< std::filesystem::path > shaderSourceDirectory;
+  // an index in the enumeration order or a part of the device name, overriding the ranking of the physical devices
+  std::optional< std::string > physicalDeviceSelector;
+  // times the instance transforms of instanceCount instances, glm against the batched kernel, then exits without any window nor device
+  bool transformBenchmark{};
+};
+
+inline std::optional< std::string > getEnvironmentVariable( const char *name )
+{
+#ifdef _WIN32
+  char *value{};
+  std::size_t size{};
+
+  if( _dupenv_s( &value, &size, name ) != 0 || value == nullptr )
+    return std::nullopt;
+
+  std::string result{ value };
+  std::free( value );
+
+  return result;
+#else
+  if( const auto value = std::getenv( name ) )
+    return std::string{ value };
+
+  return std::nullopt;
+#endif // _WIN32
+}
+
+inline std::uint32_t parsePositiveCount( std::string_view argument, const char *value )
+{
+  const auto count = std::stoul( value );
+
+  if( count == 0 || count > std::numeric_limits< std::uint32_t >::max() )
+    throw std::invalid_argument{ "Error invalid count for " + std::string{ argument } + ": " + value };
+
+  return static_cast< std::uint32_t >( count );
+}
+
+inline std::uint32_t parseSampleCount( std::string_view argument, const char *value )
+{
+  const auto count = parsePositiveCount( argument, value );
+
+  if( count > VK_SAMPLE_COUNT_64_BIT || ( count & ( count - 1 ) ) != 0 )
+    throw std::invalid_argument{ "Error invalid sample count for " + std::string{ argument } + ": " + value };
+
+  return count;
+}
+
+inline LatencyPolicy parseLatencyPolicy( std::string_view argument, std::string_view value )
+{
+  if( value == "low-latency" )
+    return LatencyPolicy::lowLatency;
+  else if( value == "uncapped" )
+    return LatencyPolicy::uncapped;
+  else if( value == "throughput" )
+    return LatencyPolicy::throughput;
+  else if( value == "power-save" )
+    return LatencyPolicy::powerSave;
+
+  throw std::invalid_argument{ "Error invalid latency policy for " + std::string{ argument } + ": " + std::string{ value } };
+}
+
+inline ApplicationOptions parseApplicationOptions( int argc, char *argv[] )
+{
+  ApplicationOptions options;
+
+  // the command line takes precedence over the environment
+  options.physicalDeviceSelector = getEnvironmentVariable( "VULKAN_LEARNING_GPU" );
+
+  for( int i = 1; i < argc; ++i )
+  {
+    const std::string_view argument{ argv[ i ] };
+    const bool hasValue = i + 1 < argc;
+
+    if( argument == "--profile-csv" && hasValue )
+      options.profileCsvPath = argv[ ++i ];
+    else if( argument == "--profile-trace" && hasValue )
+      options.profileTracePath = argv[ ++i ];
+    else if( argument == "--prebaked-commands" )
+      options.prebakedCommandBuffers = true;
+    else if( argument == "--benchmark" && hasValue )
+      options.benchmarkFrameCount = parsePositiveCount( argument, argv[ ++i ] );
+    else if( argument == "--instances" && hasValue )
+      options.instanceCount = parsePositiveCount( argument, argv[ ++i ] );
+    else if( argument == "--latency" && hasValue )
+      options.latencyPolicy = parseLatencyPolicy( argument, argv[ ++i ] );
+    else if( argument == "--shader-sources" && hasValue )
+      options.shaderSourceDirectory = argv[ ++i ];
+    else if( argument == "--depth-prepass" )
+      options.depthPrePass = true;
+    else if( argument == "--msaa" && hasValue )
+      options.msaaSampleCount = parseSampleCount( argument, argv[ ++i ] );
+    else if( argument == "--gpu" && hasValue )
+      options.physicalDeviceSelector = argv[ ++i ];
+    else if( argument == "--transform-benchmark" )
+      options.transformBenchmark = true;
+    else
+      throw std::invalid_argument{ "Error unknown or incomplete command line argument: " + std::string{ argument } };
+  }
+
+  return options;
+}
+
+class VulkanApplication
+{
+public:
+  VulkanApplication( std::filesystem::path path, ApplicationOptions options ) : applicationPath_{ path }, options_{ std::move( options ) }
+  {
+    if( options_.profileCsvPath.has_value() || options_.profileTracePath.has_value() )
+      profiler_.enableCapture();
+
+    maxFrameInFlight_ = getFramesInFlight();
+    depthPrePassEnabled_ = options_.depthPrePass;
+    requestedDepthPrePass_ = options_.depthPrePass;
+
+    createInstanceTransforms();
+  }
+
+  void run()
+  {
+    if( options_.transformBenchmark )
+    {
+      runTransformBenchmark();
+      return;
+    }
+
+    if( !isHeadless() )
+      initWindow();
+
+    initVulkan();
+    mainLoop();
+    cleanup();
+  }
+
+private:
+  struct GraphicShaderModules
+  {
+    VkShaderModule vertex;
+    VkShaderModule fragment;
+    // depth pre-pass only
+    VkShaderModule depthVertex;
+  };
+
+  // one level of detail, all of them share the vertex buffer and follow each other in the index buffer from the finest to the coarsest
+  struct MeshLod
+  {
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+    // in model units, projected on screen to select the level
+    float error;
+    // draw ranges of the level, filled by createDrawList
+    std::uint32_t firstDraw;
+    std::uint32_t drawCount;
+  };
+
+  // levels of detail a frame may select, from all the instances
+  struct LodSelection
+  {
+    std::uint32_t finestLod;
+    std::uint32_t coarsestLod;
+  };
+
+  // bound to the vector sizes of the culling parameters
+  inline static constexpr std::size_t maxMeshLodCount_{ 4 };
+
+  // precooked mesh file layout: this header, the vertices, then 16 or 32 bits indices
+  struct MeshCacheHeader
+  {
+    char magic[ 4 ];
+    std::uint32_t version;
+    std::uint64_t vertexLayoutHash;
+    std::uint64_t sourcePathHash;
+    std::int64_t sourceWriteTime;
+    std::uint64_t vertexCount;
+    std::uint64_t indexCount;
+    std::uint32_t indexSize;
+    std::uint32_t reserved;
+    PositionQuantization positionQuantization;
+    std::uint32_t lodCount;
+    MeshLod lods[ maxMeshLodCount_ ];
+  };
+
+  // geometry ready for upload in the vertex buffer layout, either pointing in the packed vertices and indices of a mesh asset, or in its
+  // mapped cache file
+  struct MeshView
+  {
+    const void *vertexData;
+    std::size_t vertexCount;
+    const void *indexData;
+    std::size_t indexCount;
+    VkIndexType indexType;
+  };
+
+  // built by a streaming worker from the cache or the obj file, the render thread only reads it to upload the geometry
+  struct MeshAsset
+  {
+    std::vector< Vertex > vertices;
+    std::vector< std::uint32_t > indices;
+    std::vector< GpuVertex > gpuVertices;
+    std::vector< std::uint16_t > compactIndices;
+    PositionQuantization positionQuantization{};
+    MappedFile cacheFile;
+    MeshView view{};
+    std::vector< MeshLod > lods;
+    glm::vec4 boundingSphere{};
+  };
+
+  // uploaded in buffers of its own, the resident mesh is drawn until the upload is complete
+  struct PendingMesh
+  {
+    std::uint64_t uploadValue{};
+    VkBuffer vertexBuffer{};
+    DeviceMemoryAllocation vertexBufferAllocation{};
+    VkBuffer indexBuffer{};
+    DeviceMemoryAllocation indexBufferAllocation{};
+    VkIndexType indexType{};
+    PositionQuantization positionQuantization{};
+    std::vector< MeshLod > lods;
+    glm::vec4 boundingSphere{};
+  };
+
+  struct DrawRange
+  {
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+  };
+
+  // swap chain resources left behind by a recreation, destroyed once the frame timeline reaches completionValue. Pipelines and per image
+  // resources are only there when they had to be created again as well
+  struct RetiredSwapChain
+  {
+    std::uint64_t completionValue{};
+    VkSwapchainKHR swapChain{};
+    std::vector< VkImageView > imageViews;
+    std::vector< VkFramebuffer > framebuffers;
+    VkImage depthImage{};
+    VkImageView depthImageView{};
+    DeviceMemoryAllocation depthImageAllocation{};
+    VkImage colorImage{};
+    VkImageView colorImageView{};
+    DeviceMemoryAllocation colorImageAllocation{};
+    std::vector< VkCommandBuffer > commandBuffers;
+    // per recording context, in the order of recordingContexts_
+    std::vector< std::vector< VkCommandBuffer > > secondaryCommandBuffers;
+    VkRenderPass renderPass{};
+    VkPipelineLayout pipelineLayout{};
+    std::vector< VkPipeline > graphicPipelines;
+    std::vector< std::pair< VkBuffer, DeviceMemoryAllocation > > buffers;
+    VkDescriptorPool descriptorPool{};
+    VkQueryPool timestampQueryPool{};
+  };
+
+  // per worker, secondary command buffers are kept to be reused or freed in the pool they come from
+  struct RecordingContext
+  {
+    VkCommandPool commandPool{};
+    std::vector< VkCommandBuffer > commandBuffers;
+    std::size_t usedCommandBufferCount{};
+  };
+
+  // per frame in flight, all its pools are reset at once when its fence signals and its command buffers are recorded again
+  struct FrameContext
+  {
+    VkCommandPool commandPool{};
+    VkCommandBuffer commandBuffer{};
+    std::vector< RecordingContext > recordingContexts;
+    std::vector< VkCommandBuffer > secondaryCommandBuffers;
+  };
+
+  // asynchronous culling only, one per frame in flight, recorded again every frame
+  struct CullingContext
+  {
+    VkCommandPool commandPool{};
+    VkCommandBuffer commandBuffer{};
+    // the draws of the frame wait on it
+    VkSemaphore semaphore{};
+  };
+
+  struct StagingMemory
+  {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    std::byte *mappedData;
+  };
+
+  struct ImageLevelData
+  {
+    const void *data;
+    VkDeviceSize size;
+  };
+
+  // KTX2 file layout, https://github.khronos.org/KTX-Specification/
+  struct Ktx2Header
+  {
+    std::uint8_t identifier[ 12 ];
+    std::uint32_t vkFormat;
+    std::uint32_t typeSize;
+    std::uint32_t pixelWidth;
+    std::uint32_t pixelHeight;
+    std::uint32_t pixelDepth;
+    std::uint32_t layerCount;
+    std::uint32_t faceCount;
+    std::uint32_t levelCount;
+    std::uint32_t supercompressionScheme;
+    std::uint32_t dfdByteOffset;
+    std::uint32_t dfdByteLength;
+    std::uint32_t kvdByteOffset;
+    std::uint32_t kvdByteLength;
+    std::uint64_t sgdByteOffset;
+    std::uint64_t sgdByteLength;
+  };
+
+  struct Ktx2LevelIndex
+  {
+    std::uint64_t byteOffset;
+    std::uint64_t byteLength;
+    std::uint64_t uncompressedByteLength;
+  };
+
+  struct CompressedTexture
+  {
+    VkFormat format;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::vector< ImageLevelData > levels;
+  };
+
+  // decoded by a streaming worker, the levels point either in the mapped KTX2 file or in the pixels loaded by stb
+  struct DecodedTexture
+  {
+    MappedFile file;
+    stbi_uc *pixels{};
+    VkFormat format{};
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::uint32_t mipLevels{};
+    std::vector< ImageLevelData > levels;
+    // decoded pixels filtered down to fit in the memory budget
+    std::vector< stbi_uc > resizedPixels;
+
+    ~DecodedTexture()
+    {
+      stbi_image_free( pixels );
+    }
+  };
+
+  struct MeshImportChunk
+  {
+    std::size_t beginIndex;
+    std::size_t endIndex;
+    std::vector< Vertex > vertices;
+    // indices in the chunk vertices, remapped into the merged vertices once every chunk is done
+    std::vector< std::uint32_t > indices;
+    std::vector< std::uint32_t > remap;
+  };
+
+  struct StagingBuffer
+  {
+    VkBuffer buffer;
+    DeviceMemoryAllocation allocation;
+  };
+
+  struct UploadBatch
+  {
+    VkCommandBuffer transfertCommandBuffer;
+    VkCommandBuffer graphicCommandBuffer;
+    // uploads too large for the staging ring get their own staging buffer, released with the batch
+    std::vector< StagingBuffer > stagingBuffers;
+    std::uint64_t completionValue{};
+  };
+
+  // std430 element of the instance storage buffer
+  struct InstanceData
+  {
+    alignas( 16 ) glm::mat4 model;
+    std::uint32_t materialIndex;
+  };
+
+  // what the simulation hands over to the frame stages, nothing in it depends on the device
+  struct SimulatedFrame
+  {
+    float animationTime{};
+    glm::vec3 cameraPosition{};
+    glm::mat4 view{};
+    bool isDepthPrePassEnabled{};
+    bool isLast{};
+  };
+
+  // recorded into the resources of currentFrame_, that only the submission stage moves while the recording one is idle
+  struct FrameRecording
+  {
+    SimulatedFrame simulation;
+    std::uint32_t imageIndex{};
+  };
+
+  // the frame slot submitted last, currentFrame_ has moved on to the next one already
+  struct PendingPresentation
+  {
+    std::uint32_t imageIndex;
+    std::uint8_t frameSlot;
+  };
+
+  bool isHeadless() const noexcept
+  {
+    return options_.benchmarkFrameCount.has_value();
+  }
+
+  // offscreen rendering needs no device extension at all
+  std::span< const char *const > getRequiredDeviceExtensions() const noexcept
+  {
+    if( isHeadless() )
+      return {};
+
+    return vulkanProductionExtensions_;
+  }
+
+  void initWindow()
+  {
+    if( glfwInit() == GLFW_FALSE )
+      throw std::runtime_error{ "Error when intializing GLFW" };
+
+    glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+    glfwWindowHint( GLFW_RESIZABLE, GLFW_TRUE );
+
+    window_ = glfwCreateWindow( windowWidth_, windowHeight_, "Vulkan", nullptr, nullptr );
+
+    if( window_ == nullptr )
+      throw std::runtime_error{ "Error when creating GLFW window" };
+
+    glfwSetWindowUserPointer( window_, this );
+    glfwSetFramebufferSizeCallback( window_, framebufferResizeCallback );
+    glfwSetKeyCallback( window_, keyCallback );
+
+    publishFramebufferExtent();
+  }
+
+  // the window belongs to the simulation thread, the submission one only ever sees the extent it publishes
+  void publishFramebufferExtent()
+  {
+    int width{}, height{};
+    glfwGetFramebufferSize( window_, &width, &height );
+
+    const auto extent = std::uint64_t{ static_cast< std::uint32_t >( width ) } << 32 | static_cast< std::uint32_t >( height );
+
+    if( framebufferExtent_.exchange( extent, std::memory_order_acq_rel ) != extent )
+      framebufferExtent_.notify_all();
+  }
+
+  void publishWindowClosed()
+  {
+    framebufferExtent_.store( closedWindowExtent_, std::memory_order_release );
+    framebufferExtent_.notify_all();
+  }
+
+  static VkExtent2D unpackFramebufferExtent( std::uint64_t extent ) noexcept
+  {
+    return VkExtent2D{ static_cast< std::uint32_t >( extent >> 32 ), static_cast< std::uint32_t >( extent ) };
+  }
+
+  void createIndexBuffer( const MeshView &meshView, VkBuffer &indexBuffer, DeviceMemoryAllocation &indexBufferAllocation )
+  {
+    VkDeviceSize bufferSize = ( meshView.indexType == VK_INDEX_TYPE_UINT16 ? sizeof( std::uint16_t ) : sizeof( std::uint32_t ) ) * meshView.indexCount;
+
+    createBuffer( bufferSize,
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  indexBuffer,
+                  indexBufferAllocation );
+
+    recordBufferUpload( indexBuffer, meshView.indexData, bufferSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT );
+  }
+
+  void createDescriptorSetLayout()
+  {
+    VkDescriptorSetLayoutBinding bindings[]
+    {
+      {
+        .binding{ 0 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
+        .descriptorCount{ 1 },
+        .stageFlags{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT }
+      },
+      {
+        .binding{ 2 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .descriptorCount{ 1 },
+        .stageFlags{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT }
+      },
+      {
+        .binding{ 3 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .descriptorCount{ 1 },
+        .stageFlags{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT }
+      },
+      {
+        .binding{ 4 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .descriptorCount{ 1 },
+        .stageFlags{ VK_SHADER_STAGE_COMPUTE_BIT }
+      }
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO },
+      .bindingCount{ sizeof( bindings ) / sizeof( VkDescriptorSetLayoutBinding ) },
+      .pBindings{ bindings }
+    };
+
+    if( vkCreateDescriptorSetLayout( logicalDevice_, &layoutInfo, nullptr, &descriptorSetLayout_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create descriptor set layout!" };
+  }
+
+  // the texture array is bound update after bind, those bindings have limits of their own
+  std::uint32_t getBindlessTextureCapacity() const noexcept
+  {
+    return std::min( { maxBindlessTextureCount_,
+                       physicalDeviceVulkan12Properties_.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                       physicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSampledImages } );
+  }
+
+  // Resources that outlive the frames, the materials and every texture they index. Bound once per command buffer alongside the per frame set,
+  // it cannot hold the dynamic buffers as those are not allowed in an update after bind layout
+  void createBindlessDescriptorSetLayout()
+  {
+    VkDescriptorSetLayoutBinding bindings[]
+    {
+      {
+        .binding{ 0 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+        .descriptorCount{ 1 },
+        .stageFlags{ VK_SHADER_STAGE_FRAGMENT_BIT }
+      },
+      {
+        .binding{ 1 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_SAMPLER },
+        .descriptorCount{ 1 },
+        .stageFlags{ VK_SHADER_STAGE_FRAGMENT_BIT },
+        .pImmutableSamplers{ nullptr }
+      },
+      {
+        .binding{ 2 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE },
+        .descriptorCount{ getBindlessTextureCapacity() },
+        .stageFlags{ VK_SHADER_STAGE_FRAGMENT_BIT }
+      }
+    };
+
+    // textures are written as they are registered, even while frames are in flight, the array is sized at allocation and only the resident
+    // ones are ever indexed
+    const VkDescriptorBindingFlags bindingFlags[]
+    {
+      0,
+      0,
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+      | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+      | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+      | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO },
+      .bindingCount{ sizeof( bindingFlags ) / sizeof( VkDescriptorBindingFlags ) },
+      .pBindingFlags{ bindingFlags }
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO },
+      .pNext{ &bindingFlagsInfo },
+      .flags{ VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT },
+      .bindingCount{ sizeof( bindings ) / sizeof( VkDescriptorSetLayoutBinding ) },
+      .pBindings{ bindings }
+    };
+
+    if( vkCreateDescriptorSetLayout( logicalDevice_, &layoutInfo, nullptr, &bindlessDescriptorSetLayout_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create bindless descriptor set layout!" };
+  }
+
+  void createUniformBuffers()
+  {
+    const auto alignment = physicalDeviceProperties_.limits.minUniformBufferOffsetAlignment;
+
+    // one slot per recorded command buffer, each of them selecting its own through a dynamic offset
+    uniformBufferSlotSize_ = ( sizeof( UniformBufferObject ) + alignment - 1 ) / alignment * alignment;
+
+    createBuffer( uniformBufferSlotSize_ * swapChainImages_.size(),
+                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  uniformBuffer_,
+                  uniformBufferAllocation_,
+                  true );
+  }
+
+  // model matrices of all the instances, sliced the same way as the uniform buffer
+  void createInstanceBuffers()
+  {
+    const auto alignment = physicalDeviceProperties_.limits.minStorageBufferOffsetAlignment;
+
+    instanceBufferSlotSize_ = alignUp( sizeof( InstanceData ) * options_.instanceCount, alignment );
+
+    if( instanceBufferSlotSize_ > physicalDeviceProperties_.limits.maxStorageBufferRange )
+      throw std::runtime_error{ "Error too many instances for a storage buffer!" };
+
+    createBuffer( instanceBufferSlotSize_ * swapChainImages_.size(),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  instanceBuffer_,
+                  instanceBufferAllocation_,
+                  true );
+  }
+
+  VkDeviceSize getVisibleInstanceBufferRange() const noexcept
+  {
+    // the visible instance counts of every level come first, then as many instance indices per level as there are instances
+    return sizeof( std::uint32_t ) * ( maxMeshLodCount_ + meshLods_.size() * options_.instanceCount );
+  }
+
+  VkDeviceSize getIndirectCommandBufferRange() const noexcept
+  {
+    return sizeof( VkDrawIndexedIndirectCommand ) * drawList_.size();
+  }
+
+  // written by the culling pass only, sliced the same way as the uniform buffer
+  void createCullingBuffers()
+  {
+    const auto alignment = physicalDeviceProperties_.limits.minStorageBufferOffsetAlignment;
+
+    visibleInstanceBufferSlotSize_ = alignUp( getVisibleInstanceBufferRange(), alignment );
+    indirectCommandBufferSlotSize_ = alignUp( getIndirectCommandBufferRange(), alignment );
+
+    createBuffer( visibleInstanceBufferSlotSize_ * swapChainImages_.size(),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  visibleInstanceBuffer_,
+                  visibleInstanceBufferAllocation_,
+                  true );
+
+    createBuffer( indirectCommandBufferSlotSize_ * swapChainImages_.size(),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  indirectCommandBuffer_,
+                  indirectCommandBufferAllocation_,
+                  true );
+  }
+
+  // in binding order, all the dynamic buffers are sliced per swap chain image
+  std::array< std::uint32_t, 4 > getDynamicOffsets( std::uint32_t slot ) const noexcept
+  {
+    return
+    {
+      static_cast< std::uint32_t >( slot * uniformBufferSlotSize_ ),
+      static_cast< std::uint32_t >( slot * instanceBufferSlotSize_ ),
+      static_cast< std::uint32_t >( slot * visibleInstanceBufferSlotSize_ ),
+      static_cast< std::uint32_t >( slot * indirectCommandBufferSlotSize_ )
+    };
+  }
+
+  void createDescriptorPool()
+  {
+    VkDescriptorPoolSize poolSizes[]
+    {
+      {
+        .type{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
+        .descriptorCount{ 1 }
+      },
+      {
+        .type{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .descriptorCount{ 3 }
+      }
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO },
+      .maxSets{ 1 },
+      .poolSizeCount{ sizeof( poolSizes ) / sizeof( VkDescriptorPoolSize ) },
+      .pPoolSizes{ poolSizes }
+    };
+
+    if( vkCreateDescriptorPool( logicalDevice_, &poolInfo, nullptr, &descriptorPool_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create descriptor pool!" };
+  }
+
+  void updateDescriptorSet()
+  {
+    VkDescriptorBufferInfo buffersInfo[]
+    {
+      {
+        .buffer{ uniformBuffer_ },
+        .offset{ 0 },
+        .range{ sizeof( UniformBufferObject ) }
+      }
+    };
+
+    // instances, visible instances then indirect commands, one per binding from 2 to 4
+    VkDescriptorBufferInfo storageBuffersInfo[]
+    {
+      {
+        .buffer{ instanceBuffer_ },
+        .offset{ 0 },
+        .range{ sizeof( InstanceData ) * options_.instanceCount }
+      },
+      {
+        .buffer{ visibleInstanceBuffer_ },
+        .offset{ 0 },
+        .range{ getVisibleInstanceBufferRange() }
+      },
+      {
+        .buffer{ indirectCommandBuffer_ },
+        .offset{ 0 },
+        .range{ getIndirectCommandBufferRange() }
+      }
+    };
+
+    VkWriteDescriptorSet descriptorWrites[]
+    {
+      {
+        .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+        .dstSet{ descriptorSet_ },
+        .dstBinding{ 0 },
+        .dstArrayElement{ 0 },
+        .descriptorCount{ static_cast< std::uint32_t >( sizeof( buffersInfo ) / sizeof( VkDescriptorBufferInfo ) ) },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
+        .pBufferInfo{ buffersInfo }
+      },
+      {
+        .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+        .dstSet{ descriptorSet_ },
+        .dstBinding{ 2 },
+        .dstArrayElement{ 0 },
+        .descriptorCount{ 1 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .pBufferInfo{ &storageBuffersInfo[ 0 ] }
+      },
+      {
+        .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+        .dstSet{ descriptorSet_ },
+        .dstBinding{ 3 },
+        .dstArrayElement{ 0 },
+        .descriptorCount{ 1 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .pBufferInfo{ &storageBuffersInfo[ 1 ] }
+      },
+      {
+        .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+        .dstSet{ descriptorSet_ },
+        .dstBinding{ 4 },
+        .dstArrayElement{ 0 },
+        .descriptorCount{ 1 },
+        .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC },
+        .pBufferInfo{ &storageBuffersInfo[ 2 ] }
+      }
+    };
+
+    vkUpdateDescriptorSets( logicalDevice_, sizeof( descriptorWrites ) / sizeof( VkWriteDescriptorSet ), descriptorWrites, 0, nullptr );
+  }
+
+  void createDescriptorSets()
+  {
+    VkDescriptorSetAllocateInfo allocInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO },
+      .descriptorPool{ descriptorPool_ },
+      .descriptorSetCount{ 1 },
+      .pSetLayouts{ &descriptorSetLayout_ }
+    };
+
+    if( vkAllocateDescriptorSets( logicalDevice_, &allocInfo, &descriptorSet_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to allocate descriptor sets!" };
+
+    updateDescriptorSet();
+  }
+
+  // allocated once, textures are added to it while command buffers using it may be pending
+  void createBindlessDescriptorSet()
+  {
+    const auto textureCapacity = getBindlessTextureCapacity();
+
+    VkDescriptorPoolSize poolSizes[]
+    {
+      {
+        .type{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+        .descriptorCount{ 1 }
+      },
+      {
+        .type{ VK_DESCRIPTOR_TYPE_SAMPLER },
+        .descriptorCount{ 1 }
+      },
+      {
+        .type{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE },
+        .descriptorCount{ textureCapacity }
+      }
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO },
+      .flags{ VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT },
+      .maxSets{ 1 },
+      .poolSizeCount{ sizeof( poolSizes ) / sizeof( VkDescriptorPoolSize ) },
+      .pPoolSizes{ poolSizes }
+    };
+
+    if( vkCreateDescriptorPool( logicalDevice_, &poolInfo, nullptr, &bindlessDescriptorPool_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create bindless descriptor pool!" };
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO },
+      .descriptorSetCount{ 1 },
+      .pDescriptorCounts{ &textureCapacity }
+    };
+
+    VkDescriptorSetAllocateInfo allocInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO },
+      .pNext{ &variableCountInfo },
+      .descriptorPool{ bindlessDescriptorPool_ },
+      .descriptorSetCount{ 1 },
+      .pSetLayouts{ &bindlessDescriptorSetLayout_ }
+    };
+
+    if( vkAllocateDescriptorSets( logicalDevice_, &allocInfo, &bindlessDescriptorSet_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to allocate bindless descriptor set!" };
+
+    VkDescriptorImageInfo samplerInfo
+    {
+      .sampler{ textureSampler_ }
+    };
+
+    VkWriteDescriptorSet descriptorWrite
+    {
+      .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+      .dstSet{ bindlessDescriptorSet_ },
+      .dstBinding{ 1 },
+      .dstArrayElement{ 0 },
+      .descriptorCount{ 1 },
+      .descriptorType{ VK_DESCRIPTOR_TYPE_SAMPLER },
+      .pImageInfo{ &samplerInfo }
+    };
+
+    vkUpdateDescriptorSets( logicalDevice_, 1, &descriptorWrite, 0, nullptr );
+  }
+
+  // returns the index materials refer to the texture with, its descriptor is written once the texture is resident
+  std::uint32_t reserveBindlessTexture()
+  {
+    if( bindlessTextureCount_ == getBindlessTextureCapacity() )
+      throw std::runtime_error{ "Error too many textures for the bindless descriptor set!" };
+
+    return bindlessTextureCount_++;
+  }
+
+  void writeBindlessTexture( std::uint32_t textureIndex, VkImageView imageView )
+  {
+    VkDescriptorImageInfo imageInfo
+    {
+      .imageView{ imageView },
+      .imageLayout{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+    };
+
+    VkWriteDescriptorSet descriptorWrite
+    {
+      .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+      .dstSet{ bindlessDescriptorSet_ },
+      .dstBinding{ 2 },
+      .dstArrayElement{ textureIndex },
+      .descriptorCount{ 1 },
+      .descriptorType{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE },
+      .pImageInfo{ &imageInfo }
+    };
+
+    vkUpdateDescriptorSets( logicalDevice_, 1, &descriptorWrite, 0, nullptr );
+  }
+
+  std::uint32_t registerBindlessTexture( VkImageView imageView )
+  {
+    const auto textureIndex = reserveBindlessTexture();
+
+    writeBindlessTexture( textureIndex, imageView );
+
+    return textureIndex;
+  }
+
+  // an opaque white texel registered first, sampled in place of the textures still streaming in
+  void createPlaceholderTexture()
+  {
+    const std::uint8_t texel[]{ 255, 255, 255, 255 };
+    const ImageLevelData levels[]{ { texel, sizeof( texel ) } };
+
+    createImage( 1,
+                 1,
+                 1,
+                 VK_FORMAT_R8G8B8A8_SRGB,
+                 VK_IMAGE_TILING_OPTIMAL,
+                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 placeholderTextureImage_, placeholderTextureImageAllocation_ );
+
+    recordImageUpload( placeholderTextureImage_, VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 1, levels );
+    createImageView( placeholderTextureImage_, &placeholderTextureImageView_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 1 );
+    registerBindlessTexture( placeholderTextureImageView_ );
+
+    // materials refer to the streamed texture from the start, the shader falls back to the placeholder until it is resident
+    streamedTextureIndex_ = reserveBindlessTexture();
+    residentTextureCount_ = streamedTextureIndex_;
+  }
+
+  // a palette over the registered textures, instances pick theirs in turn so that a single draw spans all the materials
+  void createMaterialBuffer()
+  {
+    const auto textureIndex = streamedTextureIndex_;
+
+    std::vector< MaterialData > materials;
+    materials.reserve( materialCount_ );
+
+    for( auto &&tint : materialTints_ )
+      materials.push_back( { .tint{ tint }, .textureIndex{ textureIndex } } );
+
+    const VkDeviceSize bufferSize = sizeof( MaterialData ) * materials.size();
+
+    createBuffer( bufferSize,
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  materialBuffer_,
+                  materialBufferAllocation_ );
+
+    recordBufferUpload( materialBuffer_, materials.data(), bufferSize, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT );
+
+    VkDescriptorBufferInfo bufferInfo
+    {
+      .buffer{ materialBuffer_ },
+      .offset{ 0 },
+      .range{ bufferSize }
+    };
+
+    VkWriteDescriptorSet descriptorWrite
+    {
+      .sType{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+      .dstSet{ bindlessDescriptorSet_ },
+      .dstBinding{ 0 },
+      .dstArrayElement{ 0 },
+      .descriptorCount{ 1 },
+      .descriptorType{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+      .pBufferInfo{ &bufferInfo }
+    };
+
+    vkUpdateDescriptorSets( logicalDevice_, 1, &descriptorWrite, 0, nullptr );
+  }
+
+  auto getTexturePixels() const
+  {
+    auto texture = applicationPath_.parent_path() / textureRelativePath_;
+
+    int width, height, texChannels;
+    stbi_uc *pixels = stbi_load( texture.string().c_str(), &width, &height, &texChannels, STBI_rgb_alpha );
+    VkDeviceSize size = static_cast< VkDeviceSize >( width ) * height * 4;
+
+    if( !pixels )
+      throw std::runtime_error{ "Error failed to load texture image!" };
+
+    return TexturePixelsBuffer
+    {
+      pixels,
+      width,
+      height,
+      size
+    };
+  }
+
+  void createImage( std::uint32_t width,
+                    std::uint32_t height,
+                    std::uint32_t mipLevels,
+                    VkFormat format,
+                    VkImageTiling tiling,
+                    VkImageUsageFlags usage,
+                    VkMemoryPropertyFlags memoryProperties,
+                    VkImage &image,
+                    DeviceMemoryAllocation &imageAllocation,
+                    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT )
+  {
+    // exclusive to one queue family at a time, uploads transfer the ownership explicitly
+    VkImageCreateInfo imageInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO },
+      .imageType{ VK_IMAGE_TYPE_2D },
+      .format{ format },
+      .extent
+      {
+        .width{ width },
+        .height{ height },
+        .depth{ 1 }
+      },
+      .mipLevels{ mipLevels },
+      .arrayLayers{ 1 },
+      .samples{ samples },
+      .tiling{ tiling },
+      .usage{ usage },
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED }
+    };
+
+    if( vkCreateImage( logicalDevice_, &imageInfo, nullptr, &image ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create image!" };
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements( logicalDevice_, image, &memRequirements );
+
+    // lazily allocated memory is a preference, only tiled GPUs expose it
+    if( ( memoryProperties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT ) && !memoryAllocator_.isMemoryTypeAvailable( memRequirements.memoryTypeBits, memoryProperties ) )
+      memoryProperties &= ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+    imageAllocation = memoryAllocator_.allocate( memRequirements,
+                                                 memoryProperties,
+                                                 tiling == VK_IMAGE_TILING_OPTIMAL ? DeviceMemoryAllocator::ResourceKind::Optimal : DeviceMemoryAllocator::ResourceKind::Linear,
+                                                 getImageMemoryCategory( usage ) );
+
+    vkBindImageMemory( logicalDevice_, image, imageAllocation.memory, imageAllocation.offset );
+  }
+
+  static constexpr std::uint32_t computeMipLevelCount( std::uint32_t width, std::uint32_t height ) noexcept
+  {
+    std::uint32_t mipLevels{ 1 };
+
+    for( auto size = std::max( width, height ); size > 1; size /= 2 )
+      ++mipLevels;
+
+    return mipLevels;
+  }
+
+  // mip levels are generated by successive linear blits, that the format has to support
+  bool isLinearBlitSupported( VkFormat format ) const
+  {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties( physicalDevice_, format, &properties );
+
+    const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    return ( properties.optimalTilingFeatures & requiredFeatures ) == requiredFeatures;
+  }
+
+  static constexpr bool isKtx2FormatHandled( VkFormat format ) noexcept
+  {
+    switch( format )
+    {
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // handled formats all use 16 bytes per 4x4 texel block
+  static constexpr VkDeviceSize getCompressedLevelSize( std::uint32_t width, std::uint32_t height ) noexcept
+  {
+    return VkDeviceSize{ ( width + 3 ) / 4 } * ( ( height + 3 ) / 4 ) * 16;
+  }
+
+  // only plain 2D textures without supercompression are read, level data is pointed in the mapped file
+  static std::optional< CompressedTexture > parseKtx2Texture( const MappedFile &file )
+  {
+    constexpr std::uint8_t ktx2Identifier[]{ 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    Ktx2Header header;
+
+    if( file.getSize() < sizeof( header ) )
+      return std::nullopt;
+
+    std::memcpy( &header, file.getData(), sizeof( header ) );
+
+    const bool isHeaderHandled = std::memcmp( header.identifier, ktx2Identifier, sizeof( ktx2Identifier ) ) == 0
+      && isKtx2FormatHandled( static_cast< VkFormat >( header.vkFormat ) )
+      && header.pixelWidth > 0 && header.pixelHeight > 0 && header.pixelDepth == 0
+      && header.layerCount == 0 && header.faceCount == 1
+      && header.levelCount > 0 && header.levelCount <= computeMipLevelCount( header.pixelWidth, header.pixelHeight )
+      && header.supercompressionScheme == 0
+      && file.getSize() >= sizeof( header ) + header.levelCount * sizeof( Ktx2LevelIndex );
+
+    if( !isHeaderHandled )
+      return std::nullopt;
+
+    CompressedTexture texture
+    {
+      .format{ static_cast< VkFormat >( header.vkFormat ) },
+      .width{ header.pixelWidth },
+      .height{ header.pixelHeight }
+    };
+
+    for( std::uint32_t level = 0; level < header.levelCount; ++level )
+    {
+      Ktx2LevelIndex levelIndex;
+      std::memcpy( &levelIndex, file.getData() + sizeof( header ) + level * sizeof( Ktx2LevelIndex ), sizeof( levelIndex ) );
+
+      const auto expectedSize = getCompressedLevelSize( std::max( header.pixelWidth >> level, 1u ), std::max( header.pixelHeight >> level, 1u ) );
+
+      if( levelIndex.byteLength != expectedSize || levelIndex.byteOffset > file.getSize() || levelIndex.byteLength > file.getSize() - levelIndex.byteOffset )
+        return std::nullopt;
+
+      texture.levels.push_back( ImageLevelData{ file.getData() + levelIndex.byteOffset, levelIndex.byteLength } );
+    }
+
+    return texture;
+  }
+
+  // picks the first precooked texture whose block compressed format the device can sample
+  std::optional< CompressedTexture > loadCompressedTexture( MappedFile &file ) const
+  {
+    for( auto &&relativePath : compressedTextureRelativePaths_ )
+    {
+      if( !file.open( applicationPath_.parent_path() / relativePath ) )
+        continue;
+
+      auto texture = parseKtx2Texture( file );
+
+      if( texture.has_value()
+          && isFormatSupported( texture->format, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT ) )
+        return texture;
+
+      file.close();
+    }
+
+    return std::nullopt;
+  }
+
+  // runs on a streaming worker, only the device format support is queried
+  std::unique_ptr< DecodedTexture > decodeTexture() const
+  {
+    auto texture = std::make_unique< DecodedTexture >();
+
+    if( auto compressedTexture = loadCompressedTexture( texture->file ) )
+    {
+      texture->format = compressedTexture->format;
+      texture->width = compressedTexture->width;
+      texture->height = compressedTexture->height;
+      texture->mipLevels = static_cast< std::uint32_t >( compressedTexture->levels.size() );
+      texture->levels = std::move( compressedTexture->levels );
+
+      return texture;
+    }
+
+    auto [texturePixels, width, height, imageSize] = getTexturePixels();
+
+    texture->pixels = texturePixels;
+    texture->format = VK_FORMAT_R8G8B8A8_SRGB;
+    texture->width = static_cast< std::uint32_t >( width );
+    texture->height = static_cast< std::uint32_t >( height );
+    texture->mipLevels = isLinearBlitSupported( texture->format ) ? computeMipLevelCount( texture->width, texture->height ) : 1;
+    texture->levels.push_back( ImageLevelData{ texturePixels, imageSize } );
+
+    return texture;
+  }
+
+  // every level of the chain included, either told by the file or the size of the generated levels
+  static VkDeviceSize estimateTextureMemorySize( const DecodedTexture &texture ) noexcept
+  {
+    if( texture.levels.size() == texture.mipLevels )
+      return std::accumulate( texture.levels.begin(),
+                              texture.levels.end(),
+                              VkDeviceSize{},
+                              []( VkDeviceSize size, const ImageLevelData &level ) { return size + level.size; } );
+
+    VkDeviceSize size{};
+
+    for( std::uint32_t level = 0; level < texture.mipLevels; ++level )
+      size += VkDeviceSize{ std::max( texture.width >> level, 1u ) } * std::max( texture.height >> level, 1u ) * 4;
+
+    return size;
+  }
+
+  // block compressed levels cannot be filtered here, only a complete chain can lose its first level
+  static bool isTextureTopLevelDroppable( const DecodedTexture &texture ) noexcept
+  {
+    return texture.pixels ? texture.width > 1 || texture.height > 1 : texture.levels.size() > 1;
+  }
+
+  static void dropTextureTopLevel( DecodedTexture &texture )
+  {
+    const auto width = std::max( texture.width / 2, 1u );
+    const auto height = std::max( texture.height / 2, 1u );
+
+    if( !texture.pixels )
+    {
+      texture.levels.erase( texture.levels.begin() );
+      texture.mipLevels = static_cast< std::uint32_t >( texture.levels.size() );
+    }
+    else
+    {
+      // 2x2 box filter, odd edges clamp to the last texel
+      const auto *source = static_cast< const stbi_uc * >( texture.levels.front().data );
+      std::vector< stbi_uc > pixels( std::size_t{ width } * height * 4 );
+
+      for( std::uint32_t y = 0; y < height; ++y )
+        for( std::uint32_t x = 0; x < width; ++x )
+          for( std::uint32_t channel = 0; channel < 4; ++channel )
+          {
+            std::uint32_t sum{};
+
+            for( std::uint32_t dy = 0; dy < 2; ++dy )
+              for( std::uint32_t dx = 0; dx < 2; ++dx )
+              {
+                const auto sourceX = std::min( x * 2 + dx, texture.width - 1 );
+                const auto sourceY = std::min( y * 2 + dy, texture.height - 1 );
+                sum += source[ ( std::size_t{ sourceY } * texture.width + sourceX ) * 4 + channel ];
+              }
+
+            pixels[ ( std::size_t{ y } * width + x ) * 4 + channel ] = static_cast< stbi_uc >( ( sum + 2 ) / 4 );
+          }
+
+      texture.resizedPixels = std::move( pixels );
+      texture.levels.front() = ImageLevelData{ texture.resizedPixels.data(), texture.resizedPixels.size() };
+      texture.mipLevels = texture.mipLevels > 1 ? computeMipLevelCount( width, height ) : 1;
+    }
+
+    texture.width = width;
+    texture.height = height;
+  }
+
+  // rather than failing to allocate near the budget, the texture is streamed in at a lower resolution
+  void fitTextureInMemoryBudget( DecodedTexture &texture )
+  {
+    memoryAllocator_.updateBudget();
+
+    const auto headroom = memoryAllocator_.getBudgetHeadroom( VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+    const auto originalWidth = texture.width;
+    const auto originalHeight = texture.height;
+
+    while( estimateTextureMemorySize( texture ) + memoryBudgetMargin_ > headroom && isTextureTopLevelDroppable( texture ) )
+      dropTextureTopLevel( texture );
+
+    if( texture.width != originalWidth || texture.height != originalHeight )
+      std::cout << "texture reduced from " << originalWidth << 'x' << originalHeight << " to " << texture.width << 'x' << texture.height
+                << " to fit in the memory budget" << std::endl;
+  }
+
+  void createTextureImage( const DecodedTexture &texture )
+  {
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    // missing mip levels are generated by blits from the first one
+    if( texture.levels.size() < texture.mipLevels )
+      usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    textureFormat_ = texture.format;
+    textureMipLevels_ = texture.mipLevels;
+
+    createImage( texture.width,
+                 texture.height,
+                 textureMipLevels_,
+                 textureFormat_,
+                 VK_IMAGE_TILING_OPTIMAL,
+                 usage,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 textureImage_, textureImageAllocation_ );
+
+    recordImageUpload( textureImage_, textureFormat_, texture.width, texture.height, textureMipLevels_, texture.levels );
+  }
+
+  void createTextureImageView()
+  {
+    createImageView( textureImage_, &textureImageView_, textureFormat_, VK_IMAGE_ASPECT_COLOR_BIT, textureMipLevels_ );
+  }
+
+  void createTextureSampler()
+  {
+    VkSamplerCreateInfo samplerInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO },
+      .magFilter{ VK_FILTER_LINEAR },
+      .minFilter{ VK_FILTER_LINEAR },
+      .mipmapMode{ VK_SAMPLER_MIPMAP_MODE_LINEAR },
+      .addressModeU{ VK_SAMPLER_ADDRESS_MODE_REPEAT },
+      .addressModeV{ VK_SAMPLER_ADDRESS_MODE_REPEAT },
+      .addressModeW{ VK_SAMPLER_ADDRESS_MODE_REPEAT },
+      .mipLodBias{ 0 },
+      .anisotropyEnable{ VK_TRUE },
+      .maxAnisotropy{ 16 },
+      .compareEnable{ VK_FALSE },
+      .compareOp{ VK_COMPARE_OP_ALWAYS },
+      .minLod{ 0 },
+      // created before any texture is resident, shared by all of them
+      .maxLod{ VK_LOD_CLAMP_NONE },
+      .borderColor{ VK_BORDER_COLOR_INT_OPAQUE_BLACK },
+      .unnormalizedCoordinates{ VK_FALSE }
+    };
+
+    if( vkCreateSampler( logicalDevice_, &samplerInfo, nullptr, &textureSampler_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create texture sampler!" };
+  }
+
+  bool isFormatSupported( VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features ) const
+  {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties( physicalDevice_, format, &props );
+
+    if( tiling == VK_IMAGE_TILING_LINEAR )
+      return ( props.linearTilingFeatures & features ) == features;
+
+    return tiling == VK_IMAGE_TILING_OPTIMAL && ( props.optimalTilingFeatures & features ) == features;
+  }
+
+  VkFormat findSupportedFormat( std::initializer_list< VkFormat > &&candidates, VkImageTiling tiling, VkFormatFeatureFlags features )
+  {
+    for( VkFormat format : candidates )
+      if( isFormatSupported( format, tiling, features ) )
+        return format;
+
+    throw std::runtime_error{ "Error failed to find supported format!" };
+  }
+
+  constexpr static bool hasStencilComponent( VkFormat format ) noexcept
+  {
+    return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+  }
+
+  VkFormat findDepthFormat()
+  {
+    return findSupportedFormat( { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+                                VK_IMAGE_TILING_OPTIMAL,
+                                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT );
+  }
+
+  bool isMultisampled() const noexcept
+  {
+    return msaaSamples_ != VK_SAMPLE_COUNT_1_BIT;
+  }
+
+  // the highest count supported by both color and depth attachments that does not exceed the requested one
+  VkSampleCountFlagBits chooseSampleCount() const noexcept
+  {
+    const auto supportedCounts = physicalDeviceProperties_.limits.framebufferColorSampleCounts & physicalDeviceProperties_.limits.framebufferDepthSampleCounts;
+
+    for( auto count = options_.msaaSampleCount; count > 1; count /= 2 )
+      if( supportedCounts & count )
+        return static_cast< VkSampleCountFlagBits >( count );
+
+    return VK_SAMPLE_COUNT_1_BIT;
+  }
+
+  // Multisampled color is resolved in the render pass and never stored, as is depth. Neither needs memory outside of the tile memory of a
+  // tiled GPU, which only backs them if they are transient and lazily allocated
+  void createColorResources()
+  {
+    if( !isMultisampled() )
+      return;
+
+    createImage( swapChainExtent_.width,
+                 swapChainExtent_.height,
+                 1,
+                 swapChainSurfaceFormat_.format,
+                 VK_IMAGE_TILING_OPTIMAL,
+                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+                 colorImage_,
+                 colorImageAllocation_,
+                 msaaSamples_ );
+
+    createImageView( colorImage_, &colorImageView_, swapChainSurfaceFormat_.format, VK_IMAGE_ASPECT_COLOR_BIT, 1 );
+  }
+
+  void createDepthResources()
+  {
+    auto depthFormat = findDepthFormat();
+
+    createImage( swapChainExtent_.width,
+                 swapChainExtent_.height,
+                 1,
+                 depthFormat,
+                 VK_IMAGE_TILING_OPTIMAL,
+                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+                 depthImage_,
+                 depthImageAllocation_,
+                 msaaSamples_ );
+
+    // no explicit layout transition, the render pass takes the depth attachment from an undefined layout
+    createImageView( depthImage_, &depthImageView_, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1 );
+  }
+
+  static Vertex makeVertex( const tinyobj::index_t &index, const tinyobj::attrib_t &attrib )
+  {
+    const std::size_t vertexPositionBase = std::size_t{ 3 } *index.vertex_index;
+    const std::size_t textureCoordinateBase = std::size_t{ 2 }  *index.texcoord_index;
+
+    return Vertex
+    {
+      .color{ 1, 1, 1 },
+      .position
+      {
+        attrib.vertices[ vertexPositionBase + 0 ],
+        attrib.vertices[ vertexPositionBase + 1 ],
+        attrib.vertices[ vertexPositionBase + 2 ]
+      },
+      .texturePosition
+      {
+        attrib.texcoords[ textureCoordinateBase + 0 ],
+        1 - attrib.texcoords[ textureCoordinateBase + 1 ] // vulkan top-bottom coord
+      }
+    };
+  }
+
+  // deduplicates a contiguous range of the model indices, spanning as many shapes as needed
+  static void importMeshChunk( MeshImportChunk &chunk,
+                               const std::vector< tinyobj::shape_t > &shapes,
+                               const std::vector< std::size_t > &shapeIndexOffsets,
+                               const tinyobj::attrib_t &attrib )
+  {
+    const auto indexCount = chunk.endIndex - chunk.beginIndex;
+    VertexDeduplicationTable uniqueVertices{ indexCount / 2 };
+
+    chunk.indices.reserve( indexCount );
+
+    auto shapeIndex = static_cast< std::size_t >( std::upper_bound( shapeIndexOffsets.begin(), shapeIndexOffsets.end(), chunk.beginIndex ) - shapeIndexOffsets.begin() - 1 );
+
+    for( auto i = chunk.beginIndex; i < chunk.endIndex; ++i )
+    {
+      while( i >= shapeIndexOffsets[ shapeIndex + 1 ] )
+        ++shapeIndex;
+
+      const auto &index = shapes[ shapeIndex ].mesh.indices[ i - shapeIndexOffsets[ shapeIndex ] ];
+
+      chunk.indices.push_back( uniqueVertices.findOrInsert( makeVertex( index, attrib ), chunk.vertices ) );
+    }
+  }
+
+  static void importObjModel( MeshAsset &mesh, const std::filesystem::path &objPath )
+  {
+    tinyobj::attrib_t attrib;
+    std::vector< tinyobj::shape_t > shapes;
+    std::vector< tinyobj::material_t > materials;
+    std::string warn, err;
+
+    if( !tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, objPath.string().c_str() ) )
+      throw std::runtime_error{ "Error when loading obj file: " + warn + err };
+
+    std::vector< std::size_t > shapeIndexOffsets{ 0 };
+
+    for( const auto &shape : shapes )
+      shapeIndexOffsets.push_back( shapeIndexOffsets.back() + shape.mesh.indices.size() );
+
+    const auto totalIndexCount = shapeIndexOffsets.back();
+    const auto workerCount = std::size_t{ std::max( 1u, std::thread::hardware_concurrency() ) };
+    const auto chunkCount = std::clamp( totalIndexCount / minimumIndicesPerImportChunk_, std::size_t{ 1 }, workerCount );
+
+    std::vector< MeshImportChunk > chunks( chunkCount );
+
+    for( std::size_t i = 0; i < chunkCount; ++i )
+    {
+      chunks[ i ].beginIndex = totalIndexCount * i / chunkCount;
+      chunks[ i ].endIndex = totalIndexCount * ( i + 1 ) / chunkCount;
+    }
+
+    parallelFor( chunkCount, [ & ]( std::size_t chunkIndex )
+    {
+      importMeshChunk( chunks[ chunkIndex ], shapes, shapeIndexOffsets, attrib );
+    } );
+
+    // merged in chunk order so that vertices keep the order of their first occurrence, as a serial import would
+    std::size_t chunkVertexCount{};
+
+    for( auto &&chunk : chunks )
+      chunkVertexCount += chunk.vertices.size();
+
+    VertexDeduplicationTable uniqueVertices{ chunkVertexCount };
+
+    mesh.vertices.clear();
+    mesh.vertices.reserve( chunkVertexCount );
+
+    for( auto &&chunk : chunks )
+    {
+      chunk.remap.reserve( chunk.vertices.size() );
+
+      for( auto &&vertex : chunk.vertices )
+        chunk.remap.push_back( uniqueVertices.findOrInsert( vertex, mesh.vertices ) );
+    }
+
+    mesh.indices.resize( totalIndexCount );
+
+    parallelFor( chunkCount, [ & ]( std::size_t chunkIndex )
+    {
+      const auto &chunk = chunks[ chunkIndex ];
+
+      for( std::size_t i = 0; i < chunk.indices.size(); ++i )
+        mesh.indices[ chunk.beginIndex + i ] = chunk.remap[ chunk.indices[ i ] ];
+    } );
+  }
+
+  // done once at import, the mesh cache stores the optimized geometry
+  static void optimizeMesh( MeshAsset &mesh )
+  {
+    const auto rawCacheMissRatio = computeAverageCacheMissRatio( mesh.indices, mesh.vertices.size(), meshCacheMissRatioCacheSize_ );
+
+    optimizeVertexCache( mesh.indices, mesh.vertices.size() );
+    optimizeOverdraw( mesh.indices, mesh.vertices, trianglesPerOverdrawCluster_ );
+    optimizeVertexFetch( mesh.indices, mesh.vertices );
+
+    std::cout << std::fixed << std::setprecision( 3 )
+              << "mesh average cache miss ratio " << rawCacheMissRatio << " -> "
+              << computeAverageCacheMissRatio( mesh.indices, mesh.vertices.size(), meshCacheMissRatioCacheSize_ ) << std::endl;
+  }
+
+  // each level halves the triangle count of the previous one, until it does not pay off anymore
+  static void buildMeshLods( MeshAsset &mesh )
+  {
+    const auto sourceIndexCount = mesh.indices.size();
+
+    mesh.lods.assign( 1, MeshLod{ .firstIndex{ 0 }, .indexCount{ static_cast< std::uint32_t >( sourceIndexCount ) }, .error{ 0.0f } } );
+
+    std::vector< std::size_t > targetIndexCounts;
+
+    for( std::size_t lod = 1; lod < maxMeshLodCount_; ++lod )
+      targetIndexCounts.push_back( ( sourceIndexCount / 3 >> lod ) * 3 );
+
+    for( auto &&simplifiedMesh : simplifyMesh( mesh.indices, mesh.vertices, targetIndexCounts ) )
+    {
+      if( simplifiedMesh.indices.size() > mesh.lods.back().indexCount * minimumLodReductionRatio_ )
+        break;
+
+      optimizeVertexCache( simplifiedMesh.indices, mesh.vertices.size() );
+
+      mesh.lods.push_back( MeshLod
+                           {
+                             .firstIndex{ static_cast< std::uint32_t >( mesh.indices.size() ) },
+                             .indexCount{ static_cast< std::uint32_t >( simplifiedMesh.indices.size() ) },
+                             .error{ simplifiedMesh.error }
+                           } );
+
+      mesh.indices.insert( mesh.indices.end(), simplifiedMesh.indices.begin(), simplifiedMesh.indices.end() );
+    }
+
+    for( std::size_t lod = 0; lod < mesh.lods.size(); ++lod )
+      std::cout << "mesh lod " << lod << ": " << mesh.lods[ lod ].indexCount / 3 << " triangles, error " << mesh.lods[ lod ].error << std::endl;
+  }
+
+  static MeshCacheHeader makeMeshCacheHeader( const std::filesystem::path &objPath )
+  {
+    const auto sourcePath = std::filesystem::absolute( objPath ).generic_u8string();
+
+    return MeshCacheHeader
+    {
+      .magic{ 'V', 'L', 'M', 'C' },
+      .version{ meshCacheVersion_ },
+      .vertexLayoutHash{ getVertexLayoutHash< GpuVertex >() },
+      .sourcePathHash{ hashBytes( sourcePath.data(), sourcePath.size() ) },
+      .sourceWriteTime{ static_cast< std::int64_t >( std::filesystem::last_write_time( objPath ).time_since_epoch().count() ) }
+    };
+  }
+
+  static bool loadMeshCache( MeshAsset &mesh, const std::filesystem::path &cachePath, const MeshCacheHeader &expectedHeader )
+  {
+    if( !mesh.cacheFile.open( cachePath ) )
+      return false;
+
+    const auto fileData = mesh.cacheFile.getData();
+    const auto fileSize = mesh.cacheFile.getSize();
+    MeshCacheHeader header;
+
+    if( fileSize < sizeof( header ) )
+    {
+      mesh.cacheFile.close();
+      return false;
+    }
+
+    std::memcpy( &header, fileData, sizeof( header ) );
+
+    const auto payloadSize = fileSize - sizeof( header );
+    const bool isHeaderMatching = std::memcmp( header.magic, expectedHeader.magic, sizeof( header.magic ) ) == 0
+      && header.version == expectedHeader.version
+      && header.vertexLayoutHash == expectedHeader.vertexLayoutHash
+      && header.sourcePathHash == expectedHeader.sourcePathHash
+      && header.sourceWriteTime == expectedHeader.sourceWriteTime
+      && ( header.indexSize == sizeof( std::uint16_t ) || header.indexSize == sizeof( std::uint32_t ) )
+      && header.vertexCount <= payloadSize / sizeof( GpuVertex )
+      && header.indexCount <= payloadSize / header.indexSize
+      && header.lodCount >= 1 && header.lodCount <= maxMeshLodCount_
+      && std::all_of( header.lods, header.lods + header.lodCount, [ &header ]( const MeshLod &lod ) { return std::uint64_t{ lod.firstIndex } + lod.indexCount <= header.indexCount; } );
+
+    if( !isHeaderMatching || header.vertexCount * sizeof( GpuVertex ) + header.indexCount * header.indexSize != payloadSize )
+    {
+      mesh.cacheFile.close();
+      return false;
+    }
+
+    const auto vertexData = fileData + sizeof( header );
+
+    mesh.positionQuantization = header.positionQuantization;
+    mesh.lods.assign( header.lods, header.lods + header.lodCount );
+
+    mesh.view = MeshView
+    {
+      .vertexData{ vertexData },
+      .vertexCount{ static_cast< std::size_t >( header.vertexCount ) },
+      .indexData{ vertexData + header.vertexCount * sizeof( GpuVertex ) },
+      .indexCount{ static_cast< std::size_t >( header.indexCount ) },
+      .indexType{ header.indexSize == sizeof( std::uint16_t ) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32 }
+    };
+
+    return true;
+  }
+
+  // failing to write the cache leaves the next run importing the obj file again
+  static void writeMeshCache( const MeshAsset &mesh, const std::filesystem::path &cachePath, MeshCacheHeader header )
+  {
+    const auto indexSize = mesh.view.indexType == VK_INDEX_TYPE_UINT16 ? sizeof( std::uint16_t ) : sizeof( std::uint32_t );
+
+    header.vertexCount = mesh.view.vertexCount;
+    header.indexCount = mesh.view.indexCount;
+    header.indexSize = static_cast< std::uint32_t >( indexSize );
+    header.positionQuantization = mesh.positionQuantization;
+    header.lodCount = static_cast< std::uint32_t >( mesh.lods.size() );
+    std::copy( mesh.lods.begin(), mesh.lods.end(), header.lods );
+
+    writeCacheFile( cachePath,
+                    {
+                      std::as_bytes( std::span{ &header, 1 } ),
+                      std::span{ static_cast< const std::byte * >( mesh.view.vertexData ), mesh.view.vertexCount * sizeof( GpuVertex ) },
+                      std::span{ static_cast< const std::byte * >( mesh.view.indexData ), mesh.view.indexCount * indexSize }
+                    } );
+  }
+
+  // converts the imported geometry in its vertex buffer layout, with the smallest index type able to address it
+  static void packMesh( MeshAsset &mesh )
+  {
+    mesh.positionQuantization = GpuVertex::makePositionQuantization( mesh.vertices );
+
+    mesh.gpuVertices.resize( mesh.vertices.size() );
+    std::transform( mesh.vertices.begin(), mesh.vertices.end(), mesh.gpuVertices.begin(), [ &mesh ]( const Vertex &vertex ) { return GpuVertex::pack( vertex, mesh.positionQuantization ); } );
+
+    const bool isIndexing16Bits = mesh.vertices.size() <= std::size_t{ std::numeric_limits< std::uint16_t >::max() } + 1;
+
+    if( isIndexing16Bits )
+      mesh.compactIndices.assign( mesh.indices.begin(), mesh.indices.end() );
+
+    mesh.view = MeshView
+    {
+      .vertexData{ mesh.gpuVertices.data() },
+      .vertexCount{ mesh.gpuVertices.size() },
+      .indexData{ isIndexing16Bits ? static_cast< const void * >( mesh.compactIndices.data() ) : mesh.indices.data() },
+      .indexCount{ mesh.indices.size() },
+      .indexType{ isIndexing16Bits ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32 }
+    };
+  }
+
+  // runs on a streaming worker, either mapping the mesh cache or importing the obj file and caching the result
+  std::unique_ptr< MeshAsset > loadModel() const
+  {
+    const auto objPath = applicationPath_.parent_path() / objRelativePath_;
+    const auto cacheHeader = makeMeshCacheHeader( objPath );
+    const auto cachePath = applicationPath_.parent_path() / cacheRelativeDirectory_ / ( std::to_string( cacheHeader.sourcePathHash ) + ".mesh" );
+
+    auto mesh = std::make_unique< MeshAsset >();
+
+    if( !loadMeshCache( *mesh, cachePath, cacheHeader ) )
+    {
+      importObjModel( *mesh, objPath );
+      optimizeMesh( *mesh );
+      buildMeshLods( *mesh );
+      packMesh( *mesh );
+      writeMeshCache( *mesh, cachePath, cacheHeader );
+    }
+
+    computeMeshBoundingSphere( *mesh );
+
+    return mesh;
+  }
+
+  // a box with the footprint of the model, drawn until the model is streamed in
+  static std::unique_ptr< MeshAsset > makePlaceholderMesh()
+  {
+    auto mesh = std::make_unique< MeshAsset >();
+
+    for( int axis = 0; axis < 3; ++axis )
+      for( const float side : { -1.0f, 1.0f } )
+      {
+        const auto firstVertex = static_cast< std::uint32_t >( mesh->vertices.size() );
+        const glm::vec2 corners[]{ { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+
+        for( auto &&corner : corners )
+        {
+          glm::vec3 position;
+
+          // counter clockwise seen from outside the box, the second corner coordinate is mirrored on the negative side
+          position[ axis ] = side;
+          position[ ( axis + 1 ) % 3 ] = corner.x;
+          position[ ( axis + 2 ) % 3 ] = corner.y * side;
+
+          mesh->vertices.push_back( Vertex
+                                    {
+                                      .color{ 1, 1, 1 },
+                                      .position{ position * placeholderMeshHalfExtent_ + placeholderMeshCenter_ },
+                                      .texturePosition{ ( corner + 1.0f ) * 0.5f }
+                                    } );
+        }
+
+        for( const std::uint32_t index : { 0u, 1u, 2u, 0u, 2u, 3u } )
+          mesh->indices.push_back( firstVertex + index );
+      }
+
+    mesh->lods.assign( 1, MeshLod{ .firstIndex{ 0 }, .indexCount{ static_cast< std::uint32_t >( mesh->indices.size() ) }, .error{ 0.0f } } );
+
+    packMesh( *mesh );
+    computeMeshBoundingSphere( *mesh );
+
+    return mesh;
+  }
+
+  // each level split in contiguous ranges of triangles, the unit of work shared out between recording workers
+  void createDrawList()
+  {
+    drawList_.clear();
+
+    for( auto &&lod : meshLods_ )
+    {
+      lod.firstDraw = static_cast< std::uint32_t >( drawList_.size() );
+
+      for( std::uint32_t offset = 0; offset < lod.indexCount; offset += indicesPerDrawRange_ )
+        drawList_.push_back( DrawRange
+                             {
+                               .firstIndex{ lod.firstIndex + offset },
+                               .indexCount{ std::min( indicesPerDrawRange_, lod.indexCount - offset ) }
+                             } );
+
+      lod.drawCount = static_cast< std::uint32_t >( drawList_.size() ) - lod.firstDraw;
+    }
+  }
+
+  // loose but cheap: centered on the bounding box, reaching the farthest vertex
+  static void computeMeshBoundingSphere( MeshAsset &mesh )
+  {
+    const auto vertices = std::span{ static_cast< const GpuVertex * >( mesh.view.vertexData ), mesh.view.vertexCount };
+
+    glm::vec3 minimum{ std::numeric_limits< float >::max() };
+    glm::vec3 maximum{ std::numeric_limits< float >::lowest() };
+
+    for( const auto &vertex : vertices )
+    {
+      minimum = glm::min( minimum, vertex.getPosition( mesh.positionQuantization ) );
+      maximum = glm::max( maximum, vertex.getPosition( mesh.positionQuantization ) );
+    }
+
+    const auto center = ( minimum + maximum ) * 0.5f;
+    float radius{};
+
+    for( const auto &vertex : vertices )
+      radius = std::max( radius, glm::length( vertex.getPosition( mesh.positionQuantization ) - center ) );
+
+    mesh.boundingSphere = glm::vec4( center, radius );
+  }
+
+  // the geometry is copied in staging memory as its upload is recorded, the asset can be released right after
+  PendingMesh stageMesh( const MeshAsset &mesh )
+  {
+    PendingMesh pendingMesh
+    {
+      .indexType{ mesh.view.indexType },
+      .positionQuantization{ mesh.positionQuantization },
+      .lods{ mesh.lods },
+      .boundingSphere{ mesh.boundingSphere }
+    };
+
+    createVertexBuffer( mesh.view, pendingMesh.vertexBuffer, pendingMesh.vertexBufferAllocation );
+    createIndexBuffer( mesh.view, pendingMesh.indexBuffer, pendingMesh.indexBufferAllocation );
+    submitUploadBatch();
+
+    pendingMesh.uploadValue = uploadTimelineValue_;
+
+    return pendingMesh;
+  }
+
+  void installMesh( PendingMesh &&mesh )
+  {
+    vertexBuffer_ = mesh.vertexBuffer;
+    vertexBufferAllocation_ = mesh.vertexBufferAllocation;
+    indexBuffer_ = mesh.indexBuffer;
+    indexBufferAllocation_ = mesh.indexBufferAllocation;
+    meshIndexType_ = mesh.indexType;
+    positionQuantization_ = mesh.positionQuantization;
+    meshLods_ = std::move( mesh.lods );
+    meshBoundingSphere_ = mesh.boundingSphere;
+
+    createDrawList();
+  }
+
+  // the resident mesh is retired along with the per image resources sized after it, frames in flight keep drawing it
+  void publishMesh( PendingMesh &&mesh )
+  {
+    RetiredSwapChain retiredMesh;
+
+    retirePerImageResources( retiredMesh );
+    retiredMesh.buffers.push_back( { std::exchange( vertexBuffer_, VK_NULL_HANDLE ), std::exchange( vertexBufferAllocation_, {} ) } );
+    retiredMesh.buffers.push_back( { std::exchange( indexBuffer_, VK_NULL_HANDLE ), std::exchange( indexBufferAllocation_, {} ) } );
+
+    if( options_.prebakedCommandBuffers )
+      retireDrawCommandBuffers( retiredMesh );
+
+    installMesh( std::move( mesh ) );
+    createUniformBuffers();
+    createInstanceBuffers();
+    createCullingBuffers();
+    createDescriptorPool();
+    createDescriptorSets();
+    createTimestampQueryPool();
+
+    if( options_.prebakedCommandBuffers )
+      createDrawCommandBuffers();
+
+    retiredMesh.completionValue = frameTimelineValue_;
+    retiredSwapChains_.push_back( std::move( retiredMesh ) );
+  }
+
+  // the workers only read the application path and the physical device, both set once and for all before they start
+  void startAssetStreaming()
+  {
+    meshStreaming_ = std::async( std::launch::async, [ this ]() { return loadModel(); } );
+    textureStreaming_ = std::async( std::launch::async, [ this ]() { return decodeTexture(); } );
+  }
+
+  template< typename T >
+  static bool isStreamingDone( const std::future< T > &streaming )
+  {
+    return streaming.valid() && streaming.wait_for( std::chrono::seconds{ 0 } ) == std::future_status::ready;
+  }
+
+  // decoded assets are uploaded, uploaded ones are published: never a wait, the placeholders are drawn meanwhile
+  void updateAssetStreaming()
+  {
+    if( isStreamingDone( meshStreaming_ ) )
+      pendingMesh_ = stageMesh( *meshStreaming_.get() );
+
+    if( isStreamingDone( textureStreaming_ ) )
+    {
+      auto texture = textureStreaming_.get();
+
+      fitTextureInMemoryBudget( *texture );
+      createTextureImage( *texture );
+      createTextureImageView();
+      submitUploadBatch();
+
+      pendingTextureUploadValue_ = uploadTimelineValue_;
+    }
+
+    if( !pendingMesh_.has_value() && !pendingTextureUploadValue_.has_value() )
+      return;
+
+    std::uint64_t completedValue{};
+    vkGetSemaphoreCounterValue( logicalDevice_, uploadTimelineSemaphore_, &completedValue );
+
+    if( pendingMesh_.has_value() && pendingMesh_->uploadValue <= completedValue )
+    {
+      publishMesh( std::move( pendingMesh_.value() ) );
+      pendingMesh_.reset();
+    }
+
+    // the slot has never been sampled, the later frames index it
+    if( pendingTextureUploadValue_.has_value() && pendingTextureUploadValue_.value() <= completedValue )
+    {
+      writeBindlessTexture( streamedTextureIndex_, textureImageView_ );
+      residentTextureCount_ = streamedTextureIndex_ + 1;
+      pendingTextureUploadValue_.reset();
+    }
+  }
+
+  // benchmarks measure the complete scene
+  void finishAssetStreaming()
+  {
+    if( meshStreaming_.valid() )
+      meshStreaming_.wait();
+
+    if( textureStreaming_.valid() )
+      textureStreaming_.wait();
+
+    updateAssetStreaming();
+    waitForUploadTimelineValue( uploadTimelineValue_ );
+    updateAssetStreaming();
+  }
+
+  // a worker still decoding is waited for, what it produced is dropped with its future
+  void cleanupAssetStreaming()
+  {
+    if( meshStreaming_.valid() )
+      meshStreaming_.wait();
+
+    if( textureStreaming_.valid() )
+      textureStreaming_.wait();
+
+    if( pendingMesh_.has_value() )
+    {
+      vkDestroyBuffer( logicalDevice_, pendingMesh_->vertexBuffer, nullptr );
+      memoryAllocator_.free( pendingMesh_->vertexBufferAllocation );
+      vkDestroyBuffer( logicalDevice_, pendingMesh_->indexBuffer, nullptr );
+      memoryAllocator_.free( pendingMesh_->indexBufferAllocation );
+    }
+  }
+
+  void initVulkan()
+  {
+    checkValidationSupport();
+    createInstance();
+    setupDebugMessenger();
+    createSurface();
+    pickPhysicalDevice();
+    startAssetStreaming();
+    createLogicalDevice();
+    createMemoryAllocator();
+    createPipelineCache();
+    createShaderManager();
+
+    if( isHeadless() )
+      createOffscreenImages();
+    else
+      createSwapChain();
+
+    createImageViews();
+    createRenderPass();
+    createDescriptorSetLayout();
+    createBindlessDescriptorSetLayout();
+    createGraphicPipeline();
+    createCullingPipeline();
+    createCommandPools();
+    createColorResources();
+    createDepthResources();
+    createFramebuffers();
+    createTimelineSemaphore( &uploadTimelineSemaphore_, "Error failed to create the upload timeline semaphore!" );
+    createStagingRing();
+    createTextureSampler();
+    createBindlessDescriptorSet();
+    createPlaceholderTexture();
+    createMaterialBuffer();
+    // nothing has been drawn yet, every frame is submitted after the placeholder upload
+    installMesh( stageMesh( *makePlaceholderMesh() ) );
+    createUniformBuffers();
+    createInstanceBuffers();
+    createCullingBuffers();
+    createDescriptorPool();
+    createDescriptorSets();
+    createTimestampQueryPool();
+    createDrawCommandBuffers();
+    createSynchronizationObjects();
+  }
+
+  // the driver ignores cache data it does not recognize, checking the header first still avoids handing it data from another device or driver
+  bool isPipelineCacheDataCompatible( const MappedFile &file ) const noexcept
+  {
+    std::uint32_t header[ 4 ];
+    std::uint8_t pipelineCacheUUID[ VK_UUID_SIZE ];
+
+    if( file.getSize() < sizeof( header ) + sizeof( pipelineCacheUUID ) )
+      return false;
+
+    std::memcpy( header, file.getData(), sizeof( header ) );
+    std::memcpy( pipelineCacheUUID, file.getData() + sizeof( header ), sizeof( pipelineCacheUUID ) );
+
+    const auto [headerSize, headerVersion, vendorID, deviceID] = header;
+
+    return headerSize >= sizeof( header ) + sizeof( pipelineCacheUUID )
+      && headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+      && vendorID == physicalDeviceProperties_.vendorID
+      && deviceID == physicalDeviceProperties_.deviceID
+      && std::memcmp( pipelineCacheUUID, physicalDeviceProperties_.pipelineCacheUUID, sizeof( pipelineCacheUUID ) ) == 0;
+  }
+
+  void createPipelineCache()
+  {
+    MappedFile cacheFile;
+    const bool isCacheDataUsable = cacheFile.open( applicationPath_.parent_path() / pipelineCacheRelativePath_ ) && isPipelineCacheDataCompatible( cacheFile );
+
+    VkPipelineCacheCreateInfo cacheInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO },
+      .initialDataSize{ isCacheDataUsable ? cacheFile.getSize() : 0 },
+      .pInitialData{ isCacheDataUsable ? cacheFile.getData() : nullptr }
+    };
+
+    if( vkCreatePipelineCache( logicalDevice_, &cacheInfo, nullptr, &pipelineCache_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create pipeline cache!" };
+  }
+
+  void savePipelineCache()
+  {
+    std::size_t dataSize{};
+
+    if( vkGetPipelineCacheData( logicalDevice_, pipelineCache_, &dataSize, nullptr ) != VK_SUCCESS || dataSize == 0 )
+      return;
+
+    std::vector< std::byte > data( dataSize );
+
+    if( vkGetPipelineCacheData( logicalDevice_, pipelineCache_, &dataSize, data.data() ) != VK_SUCCESS )
+      return;
+
+    data.resize( dataSize );
+
+    writeCacheFile( applicationPath_.parent_path() / pipelineCacheRelativePath_, { std::span< const std::byte >{ data } } );
+  }
+
+  void createMemoryAllocator()
+  {
+    memoryAllocator_.initialize( physicalDevice_, logicalDevice_, isMemoryBudgetEnabled_ );
+  }
+
+  // the first matching usage wins, a vertex buffer also written by a transfer is still accounted as a vertex buffer
+  static MemoryCategory getBufferMemoryCategory( VkBufferUsageFlags usage ) noexcept
+  {
+    if( usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT )
+      return MemoryCategory::Vertex;
+
+    if( usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT )
+      return MemoryCategory::Index;
+
+    if( usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT )
+      return MemoryCategory::Uniform;
+
+    if( usage & ( VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT ) )
+      return MemoryCategory::Storage;
+
+    return MemoryCategory::Staging;
+  }
+
+  static MemoryCategory getImageMemoryCategory( VkImageUsageFlags usage ) noexcept
+  {
+    if( usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT )
+      return MemoryCategory::Depth;
+
+    if( usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT )
+      return MemoryCategory::Color;
+
+    return MemoryCategory::Texture;
+  }
+
+  void allocateAndBindBuffer( VkBuffer &buffer, VkMemoryPropertyFlags properties, MemoryCategory category, DeviceMemoryAllocation &bufferAllocation )
+  {
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements( logicalDevice_, buffer, &memoryRequirements );
+
+    bufferAllocation = memoryAllocator_.allocate( memoryRequirements, properties, DeviceMemoryAllocator::ResourceKind::Linear, category );
+
+    vkBindBufferMemory( logicalDevice_, buffer, bufferAllocation.memory, bufferAllocation.offset );
+  }
+
+  void createBuffer( VkDeviceSize size,
+                     VkBufferUsageFlags usage,
+                     VkMemoryPropertyFlags properties,
+                     VkBuffer &buffer,
+                     DeviceMemoryAllocation &bufferAllocation,
+                     bool isSharedWithCulling = false )
+  {
+    const bool isConcurrent = isSharedWithCulling && isCullingAsynchronous();
+    const std::uint32_t queueFamilyIndices[]
+    {
+      requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+      requiredQueueFamilyIndices_.computeQueueFamilyIndex.value_or( 0 )
+    };
+
+    // exclusive to one queue family at a time, uploads transfer the ownership explicitly. Buffers the culling reads or writes from its own
+    // queue every frame are concurrent instead
+    VkBufferCreateInfo bufferInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO },
+      .size{ size },
+      .usage{ usage },
+      .sharingMode{ isConcurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE },
+      .queueFamilyIndexCount{ isConcurrent ? 2u : 0u },
+      .pQueueFamilyIndices{ queueFamilyIndices }
+    };
+
+    if( vkCreateBuffer( logicalDevice_, &bufferInfo, nullptr, &buffer ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create a buffer!" };
+
+    allocateAndBindBuffer( buffer, properties, getBufferMemoryCategory( usage ), bufferAllocation );
+  }
+
+  void allocateCommandBuffers( VkCommandPool pool,
+                               std::uint32_t bufferCount,
+                               VkCommandBuffer *commandBuffers,
+                               VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY )
+  {
+    VkCommandBufferAllocateInfo allocInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO },
+      .commandPool{ pool },
+      .level{ level },
+      .commandBufferCount{ bufferCount }
+    };
+
+    if( vkAllocateCommandBuffers( logicalDevice_, &allocInfo, commandBuffers ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to allocate command buffers" };
+  }
+
+  void createTimelineSemaphore( VkSemaphore *semaphore, const char *const exceptionMessage )
+  {
+    VkSemaphoreTypeCreateInfo timelineInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO },
+      .semaphoreType{ VK_SEMAPHORE_TYPE_TIMELINE },
+      .initialValue{ 0 }
+    };
+
+    VkSemaphoreCreateInfo semaphoreInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO },
+      .pNext{ &timelineInfo }
+    };
+
+    if( vkCreateSemaphore( logicalDevice_, &semaphoreInfo, nullptr, semaphore ) != VK_SUCCESS )
+      throw std::runtime_error{ exceptionMessage };
+  }
+
+  bool isQueueFamilyOwnershipTransferRequired() const noexcept
+  {
+    return requiredQueueFamilyIndices_.graphicsQueueFamilyIndex != requiredQueueFamilyIndices_.transfertQueueFamilyIndex;
+  }
+
+  static void beginOneTimeSubmitCommandBuffer( VkCommandBuffer commandBuffer )
+  {
+    VkCommandBufferBeginInfo beginInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO },
+      .flags{ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT }
+    };
+
+    if( vkBeginCommandBuffer( commandBuffer, &beginInfo ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to begin recording upload command buffer!" };
+  }
+
+  // uploads are recorded lazily into the current batch, that is submitted as a whole by submitUploadBatch
+  UploadBatch &getUploadBatch()
+  {
+    if( uploadBatch_.has_value() )
+      return uploadBatch_.value();
+
+    auto &batch = uploadBatch_.emplace();
+
+    allocateCommandBuffers( transfertCommandPool_, 1, &batch.transfertCommandBuffer );
+    allocateCommandBuffers( graphicUploadCommandPool_, 1, &batch.graphicCommandBuffer );
+
+    beginOneTimeSubmitCommandBuffer( batch.transfertCommandBuffer );
+    beginOneTimeSubmitCommandBuffer( batch.graphicCommandBuffer );
+
+    return batch;
+  }
+
+  static void recordPipelineBarrier( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, const VkMemoryBarrier &barrier )
+  {
+    vkCmdPipelineBarrier( commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+  }
+
+  static void recordPipelineBarrier( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, const VkBufferMemoryBarrier &barrier )
+  {
+    vkCmdPipelineBarrier( commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+  }
+
+  static void recordPipelineBarrier( VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, const VkImageMemoryBarrier &barrier )
+  {
+    vkCmdPipelineBarrier( commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+  }
+
+  // makes the result of the batch transfers visible to the graphic queue, releasing and acquiring resource ownership when queue families differ
+  template< typename Barrier >
+  void recordUploadBarrier( UploadBatch &batch, VkPipelineStageFlags dstStageMask, Barrier barrier )
+  {
+    if( !isQueueFamilyOwnershipTransferRequired() )
+    {
+      recordPipelineBarrier( batch.graphicCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, barrier );
+      return;
+    }
+
+    barrier.srcQueueFamilyIndex = requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value();
+    barrier.dstQueueFamilyIndex = requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value();
+
+    auto releaseBarrier = barrier;
+    releaseBarrier.dstAccessMask = 0;
+    recordPipelineBarrier( batch.transfertCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, releaseBarrier );
+
+    auto acquireBarrier = barrier;
+    acquireBarrier.srcAccessMask = 0;
+    recordPipelineBarrier( batch.graphicCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask, acquireBarrier );
+  }
+
+  void createStagingRing()
+  {
+    VkBuffer buffer;
+    DeviceMemoryAllocation allocation;
+
+    createBuffer( stagingRingSize_,
+                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  buffer, allocation );
+
+    stagingRing_.initialize( buffer, allocation );
+  }
+
+  void waitForUploadTimelineValue( std::uint64_t value )
+  {
+    VkSemaphoreWaitInfo waitInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO },
+      .semaphoreCount{ 1 },
+      .pSemaphores{ &uploadTimelineSemaphore_ },
+      .pValues{ &value }
+    };
+
+    if( vkWaitSemaphores( logicalDevice_, &waitInfo, std::numeric_limits< std::uint64_t >::max() ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to wait for the upload timeline semaphore!" };
+  }
+
+  StagingRing::Region acquireStagingRegion( VkDeviceSize size, VkDeviceSize alignment )
+  {
+    for( ;; )
+    {
+      if( auto region = stagingRing_.allocate( size, alignment ) )
+        return region.value();
+
+      // the ring is full, what it holds is submitted if needed then the oldest uploads are waited for
+      if( stagingRing_.hasUncommittedRegions() )
+        submitUploadBatch();
+
+      waitForUploadTimelineValue( stagingRing_.getOldestCommittedValue().value() );
+      retireCompletedUploadBatches();
+    }
+  }
+
+  // may submit the current upload batch when the staging ring is full, the memory has to be filled before anything else is staged
+  StagingMemory reserveStagingMemory( VkDeviceSize size, VkDeviceSize alignment )
+  {
+    if( size > stagingRing_.getCapacity() )
+    {
+      auto &stagingBuffer = getUploadBatch().stagingBuffers.emplace_back();
+
+      createBuffer( size,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    stagingBuffer.buffer, stagingBuffer.allocation );
+
+      return StagingMemory{ stagingBuffer.buffer, 0, static_cast< std::byte * >( stagingBuffer.allocation.mappedData ) };
+    }
+
+    auto region = acquireStagingRegion( size, alignment );
+
+    return StagingMemory{ stagingRing_.getBuffer(), region.offset, static_cast< std::byte * >( region.mappedData ) };
+  }
+
+  void recordBufferUpload( VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask )
+  {
+    auto stagingMemory = reserveStagingMemory( size, bufferUploadAlignment_ );
+    std::memcpy( stagingMemory.mappedData, data, static_cast< size_t >( size ) );
+
+    auto &batch = getUploadBatch();
+
+    VkBufferCopy copyRegion
+    {
+      .srcOffset{ stagingMemory.offset },
+      .size{ size }
+    };
+
+    vkCmdCopyBuffer( batch.transfertCommandBuffer, stagingMemory.buffer, dstBuffer, 1, &copyRegion );
+
+    recordUploadBarrier( batch,
+                         dstStageMask,
+                         VkBufferMemoryBarrier
+                         {
+                           .sType{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER },
+                           .srcAccessMask{ VK_ACCESS_TRANSFER_WRITE_BIT },
+                           .dstAccessMask{ dstAccessMask },
+                           .srcQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED },
+                           .dstQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED },
+                           .buffer{ dstBuffer },
+                           .offset{ 0 },
+                           .size{ VK_WHOLE_SIZE }
+                         } );
+  }
+
+  // uploads the given mip levels, the missing ones are generated on the graphic queue once the ownership has been acquired
+  void recordImageUpload( VkImage image, VkFormat format, std::uint32_t width, std::uint32_t height, std::uint32_t mipLevels, std::span< const ImageLevelData > levels )
+  {
+    // every level is staged in one piece so that none can be retired before the copy is submitted, offsets honouring the texel or
+    // compressed block size as well as the device copy alignment
+    const auto alignment = std::max( bufferUploadAlignment_, physicalDeviceProperties_.limits.optimalBufferCopyOffsetAlignment );
+
+    std::vector< VkDeviceSize > levelOffsets;
+    VkDeviceSize stagingSize{};
+
+    for( auto &&level : levels )
+    {
+      stagingSize = alignUp( stagingSize, alignment );
+      levelOffsets.push_back( stagingSize );
+      stagingSize += level.size;
+    }
+
+    auto stagingMemory = reserveStagingMemory( stagingSize, alignment );
+    std::vector< VkBufferImageCopy > regions;
+
+    for( std::uint32_t i = 0; i < levels.size(); ++i )
+    {
+      std::memcpy( stagingMemory.mappedData + levelOffsets[ i ], levels[ i ].data, static_cast< size_t >( levels[ i ].size ) );
+
+      regions.push_back( VkBufferImageCopy
+                         {
+                           .bufferOffset{ stagingMemory.offset + levelOffsets[ i ] },
+                           .bufferRowLength{ 0 },
+                           .bufferImageHeight{ 0 },
+                           .imageSubresource
+                           {
+                             .aspectMask{ VK_IMAGE_ASPECT_COLOR_BIT },
+                             .mipLevel{ i },
+                             .baseArrayLayer{ 0 },
+                             .layerCount{ 1 },
+                           },
+                           .imageOffset{ 0, 0, 0 },
+                           .imageExtent
+                           {
+                               .width{ std::max( width >> i, 1u ) },
+                               .height{ std::max( height >> i, 1u ) },
+                               .depth{ 1 }
+                           }
+                         } );
+    }
+
+    auto &batch = getUploadBatch();
+
+    auto [undefinedStageFlags, transferStageFlags] = getPipelineStageFlagsFromTransitionLayouts( { VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL } );
+
+    recordPipelineBarrier( batch.transfertCommandBuffer,
+                           undefinedStageFlags,
+                           transferStageFlags,
+                           makeImageLayoutBarrier( image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, mipLevels ) );
+
+    vkCmdCopyBufferToImage( batch.transfertCommandBuffer,
+                            stagingMemory.buffer,
+                            image,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            static_cast< std::uint32_t >( regions.size() ),
+                            regions.data()
+    );
+
+    if( levels.size() == mipLevels )
+    {
+      auto [copyStageFlags, shaderStageFlags] = getPipelineStageFlagsFromTransitionLayouts( { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } );
+
+      recordUploadBarrier( batch,
+                           shaderStageFlags,
+                           makeImageLayoutBarrier( image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, mipLevels ) );
+      return;
+    }
+
+    recordUploadBarrier( batch,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         makeImageLayoutBarrier( image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, mipLevels ) );
+
+    recordMipmapGeneration( batch.graphicCommandBuffer, image, format, width, height, static_cast< std::uint32_t >( levels.size() ), mipLevels );
+  }
+
+  // each level from firstGeneratedLevel is blitted from the previous one, that is made shader readable right after
+  void recordMipmapGeneration( VkCommandBuffer commandBuffer,
+                               VkImage image,
+                               VkFormat format,
+                               std::uint32_t width,
+                               std::uint32_t height,
+                               std::uint32_t firstGeneratedLevel,
+                               std::uint32_t mipLevels )
+  {
+    auto [copyStageFlags, blitStageFlags] = getPipelineStageFlagsFromTransitionLayouts( { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL } );
+    auto [blittedStageFlags, shaderStageFlags] = getPipelineStageFlagsFromTransitionLayouts( { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } );
+
+    auto mipWidth = static_cast< std::int32_t >( std::max( width >> ( firstGeneratedLevel - 1 ), 1u ) );
+    auto mipHeight = static_cast< std::int32_t >( std::max( height >> ( firstGeneratedLevel - 1 ), 1u ) );
+
+    for( std::uint32_t level = firstGeneratedLevel; level < mipLevels; ++level )
+    {
+      recordPipelineBarrier( commandBuffer,
+                             copyStageFlags,
+                             blitStageFlags,
+                             makeImageLayoutBarrier( image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, level - 1, 1 ) );
+
+      const auto nextMipWidth = std::max( mipWidth / 2, 1 );
+      const auto nextMipHeight = std::max( mipHeight / 2, 1 );
+
+      VkImageBlit blit
+      {
+        .srcSubresource
+        {
+          .aspectMask{ VK_IMAGE_ASPECT_COLOR_BIT },
+          .mipLevel{ level - 1 },
+          .baseArrayLayer{ 0 },
+          .layerCount{ 1 }
+        },
+        .srcOffsets{ { 0, 0, 0 }, { mipWidth, mipHeight, 1 } },
+        .dstSubresource
+        {
+          .aspectMask{ VK_IMAGE_ASPECT_COLOR_BIT },
+          .mipLevel{ level },
+          .baseArrayLayer{ 0 },
+          .layerCount{ 1 }
+        },
+        .dstOffsets{ { 0, 0, 0 }, { nextMipWidth, nextMipHeight, 1 } }
+      };
+
+      vkCmdBlitImage( commandBuffer,
+                      image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                      image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      1, &blit,
+                      VK_FILTER_LINEAR );
+
+      recordPipelineBarrier( commandBuffer,
+                             blittedStageFlags,
+                             shaderStageFlags,
+                             makeImageLayoutBarrier( image, format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, level - 1, 1 ) );
+
+      mipWidth = nextMipWidth;
+      mipHeight = nextMipHeight;
+    }
+
+    recordPipelineBarrier( commandBuffer,
+                           copyStageFlags,
+                           shaderStageFlags,
+                           makeImageLayoutBarrier( image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels - 1, 1 ) );
+  }
+
+  // submits the current batch without waiting: the graphic queue waits on the transfers through the upload timeline semaphore
+  void submitUploadBatch()
+  {
+    if( !uploadBatch_.has_value() )
+      return;
+
+    auto &batch = uploadBatch_.value();
+
+    if( vkEndCommandBuffer( batch.transfertCommandBuffer ) != VK_SUCCESS || vkEndCommandBuffer( batch.graphicCommandBuffer ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to record upload command buffers!" };
+
+    const std::uint64_t transfertDoneValue = ++uploadTimelineValue_;
+    const std::uint64_t uploadDoneValue = ++uploadTimelineValue_;
+
+    VkTimelineSemaphoreSubmitInfo transfertTimelineInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO },
+      .signalSemaphoreValueCount{ 1 },
+      .pSignalSemaphoreValues{ &transfertDoneValue }
+    };
+
+    VkSubmitInfo transfertSubmitInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SUBMIT_INFO },
+      .pNext{ &transfertTimelineInfo },
+      .commandBufferCount{ 1 },
+      .pCommandBuffers{ &batch.transfertCommandBuffer },
+      .signalSemaphoreCount{ 1 },
+      .pSignalSemaphores{ &uploadTimelineSemaphore_ }
+    };
+
+    if( vkQueueSubmit( transfertQueue_, 1, &transfertSubmitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to submit upload transfert command buffer!" };
+
+    // every later graphic submission is ordered after this one, hence after the ownership acquisition it contains
+    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+
+    VkTimelineSemaphoreSubmitInfo graphicTimelineInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO },
+      .waitSemaphoreValueCount{ 1 },
+      .pWaitSemaphoreValues{ &transfertDoneValue },
+      .signalSemaphoreValueCount{ 1 },
+      .pSignalSemaphoreValues{ &uploadDoneValue }
+    };
+
+    VkSubmitInfo graphicSubmitInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SUBMIT_INFO },
+      .pNext{ &graphicTimelineInfo },
+      .waitSemaphoreCount{ 1 },
+      .pWaitSemaphores{ &uploadTimelineSemaphore_ },
+      .pWaitDstStageMask{ waitStages },
+      .commandBufferCount{ 1 },
+      .pCommandBuffers{ &batch.graphicCommandBuffer },
+      .signalSemaphoreCount{ 1 },
+      .pSignalSemaphores{ &uploadTimelineSemaphore_ }
+    };
+
+    if( vkQueueSubmit( graphicsQueue_, 1, &graphicSubmitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to submit upload graphic command buffer!" };
+
+    batch.completionValue = uploadDoneValue;
+    stagingRing_.commit( uploadDoneValue );
+    pendingUploadBatches_.push_back( std::move( batch ) );
+    uploadBatch_.reset();
+  }
+
+  void destroyUploadBatch( UploadBatch &batch )
+  {
+    for( auto &&stagingBuffer : batch.stagingBuffers )
+    {
+      vkDestroyBuffer( logicalDevice_, stagingBuffer.buffer, nullptr );
+      memoryAllocator_.free( stagingBuffer.allocation );
+    }
+
+    vkFreeCommandBuffers( logicalDevice_, transfertCommandPool_, 1, &batch.transfertCommandBuffer );
+    vkFreeCommandBuffers( logicalDevice_, graphicUploadCommandPool_, 1, &batch.graphicCommandBuffer );
+  }
+
+  void retireCompletedUploadBatches()
+  {
+    std::uint64_t completedValue{};
+    vkGetSemaphoreCounterValue( logicalDevice_, uploadTimelineSemaphore_, &completedValue );
+
+    stagingRing_.retire( completedValue );
+
+    while( !pendingUploadBatches_.empty() && pendingUploadBatches_.front().completionValue <= completedValue )
+    {
+      destroyUploadBatch( pendingUploadBatches_.front() );
+      pendingUploadBatches_.pop_front();
+    }
+  }
+
+  void cleanupUploads()
+  {
+    if( uploadBatch_.has_value() )
+    {
+      vkEndCommandBuffer( uploadBatch_->transfertCommandBuffer );
+      vkEndCommandBuffer( uploadBatch_->graphicCommandBuffer );
+      destroyUploadBatch( uploadBatch_.value() );
+      uploadBatch_.reset();
+    }
+
+    retireCompletedUploadBatches();
+
+    vkDestroyBuffer( logicalDevice_, stagingRing_.getBuffer(), nullptr );
+    memoryAllocator_.free( stagingRing_.getAllocation() );
+
+    vkDestroySemaphore( logicalDevice_, uploadTimelineSemaphore_, nullptr );
+  }
+
+  constexpr std::pair< VkAccessFlags, VkAccessFlags > getPipelineStageFlagsFromTransitionLayouts( std::pair< VkImageLayout, VkImageLayout > &&transitionLayouts )
+  {
+    auto [oldLayout, newLayout] = transitionLayouts;
+
+    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
+      return { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
+      return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
+      return { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && ( newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL || newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL ) )
+      return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
+      return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+
+    throw std::invalid_argument{ "Error unsupported layout transition!" };
+  }
+
+  constexpr std::tuple< VkAccessFlags, VkAccessFlags, VkImageAspectFlags > getPipelineMasksFromTransitionLayouts( std::tuple< VkImageLayout, VkImageLayout, VkFormat > &&transitionLayoutInfo )
+  {
+    auto [oldLayout, newLayout, format] = transitionLayoutInfo;
+
+    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
+      return { 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
+      return { VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
+      return { 0,
+               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+               hasStencilComponent( format ) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT };
+
+    // same layout, only queue family ownership changes before mip levels are generated
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
+      return { VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL )
+      return { VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+
+    if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
+      return { VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+
+    throw std::invalid_argument{ "Error unsupported layout transition!" };
+  }
+
+  VkImageMemoryBarrier makeImageLayoutBarrier( VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, std::uint32_t baseMipLevel, std::uint32_t levelCount )
+  {
+    auto [srcAccessMask, dstAccessMask, aspectMask] = getPipelineMasksFromTransitionLayouts( { oldLayout, newLayout, format } );
+
+    return VkImageMemoryBarrier
+    {
+      .sType{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER },
+      .srcAccessMask{ srcAccessMask },
+      .dstAccessMask{ dstAccessMask },
+      .oldLayout{ oldLayout },
+      .newLayout{ newLayout },
+      .srcQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED },
+      .dstQueueFamilyIndex{ VK_QUEUE_FAMILY_IGNORED },
+      .image{ image },
+      .subresourceRange
+      {
+        .aspectMask{ aspectMask },
+        .baseMipLevel{ baseMipLevel },
+        .levelCount{ levelCount },
+        .baseArrayLayer{ 0 },
+        .layerCount{ 1 },
+      }
+    };
+  }
+
+  void createVertexBuffer( const MeshView &meshView, VkBuffer &vertexBuffer, DeviceMemoryAllocation &vertexBufferAllocation )
+  {
+    VkDeviceSize bufferSize = sizeof( GpuVertex ) * meshView.vertexCount;
+
+    createBuffer( bufferSize,
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  vertexBuffer,
+                  vertexBufferAllocation );
+
+    recordBufferUpload( vertexBuffer, meshView.vertexData, bufferSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT );
+  }
+
+  // Frames in flight keep rendering with the resources they were recorded with, those are retired rather than destroyed and only the ones
+  // depending on the extent are created again. Per image resources are kept as long as the image count does not change, the slots of a new
+  // image are still guarded by the fence of the last frame that used them
+  // false when the window has been closed while minimized, nothing is recreated then
+  bool recreateSwapChain()
+  {
+    if( !handleMinimizedWindow() )
+      return false;
+
+    const auto previousSurfaceFormat = swapChainSurfaceFormat_.format;
+    const auto previousImageCount = swapChainImages_.size();
+
+    auto retiredSwapChain = retireSwapChain();
+
+    setupSwapChainSupportForPhysicalDevice( physicalDevice_ );
+    createSwapChain( retiredSwapChain.swapChain );
+    createImageViews();
+
+    // the present ids of a new swap chain start over, earlier ones will never be reported by it
+    firstSwapChainPresentId_ = lastPresentId_ + 1;
+
+    // render pass and pipeline only depend on the attachment formats, that seldom change with the swap chain
+    if( swapChainSurfaceFormat_.format != previousSurfaceFormat )
+    {
+      retireGraphicPipeline( retiredSwapChain );
+      createRenderPass();
+      createGraphicPipeline();
+    }
+
+    createColorResources();
+    createDepthResources();
+    createFramebuffers();
+
+    if( swapChainImages_.size() != previousImageCount )
+    {
+      retirePerImageResources( retiredSwapChain );
+      inFlightImageFences_.resize( swapChainImages_.size(), VK_NULL_HANDLE );
+      createUniformBuffers();
+      createInstanceBuffers();
+      createCullingBuffers();
+      createDescriptorPool();
+      createDescriptorSets();
+      createTimestampQueryPool();
+    }
+
+    createDrawCommandBuffers();
+
+    // the last frame submitted is the last one that may use the retired resources
+    retiredSwapChain.completionValue = frameTimelineValue_;
+    retiredSwapChains_.push_back( std::move( retiredSwapChain ) );
+
+    return true;
+  }
+
+  // takes over the extent dependent resources, as well as the prebaked command buffers recorded with them
+  RetiredSwapChain retireSwapChain()
+  {
+    RetiredSwapChain retiredSwapChain
+    {
+      .swapChain{ std::exchange( swapChain_, VK_NULL_HANDLE ) },
+      .imageViews{ std::exchange( swapChainImageViews_, {} ) },
+      .framebuffers{ std::exchange( swapChainFramebuffers_, {} ) },
+      .depthImage{ std::exchange( depthImage_, VK_NULL_HANDLE ) },
+      .depthImageView{ std::exchange( depthImageView_, VK_NULL_HANDLE ) },
+      .depthImageAllocation{ std::exchange( depthImageAllocation_, {} ) },
+      .colorImage{ std::exchange( colorImage_, VK_NULL_HANDLE ) },
+      .colorImageView{ std::exchange( colorImageView_, VK_NULL_HANDLE ) },
+      .colorImageAllocation{ std::exchange( colorImageAllocation_, {} ) }
+    };
+
+    retireDrawCommandBuffers( retiredSwapChain );
+
+    return retiredSwapChain;
+  }
+
+  // prebaked mode only, the per frame command buffers are recorded again anyway
+  void retireDrawCommandBuffers( RetiredSwapChain &retiredSwapChain )
+  {
+    retiredSwapChain.commandBuffers = std::exchange( commandBuffers_, {} );
+
+    for( auto &&context : recordingContexts_ )
+    {
+      retiredSwapChain.secondaryCommandBuffers.push_back( std::exchange( context.commandBuffers, {} ) );
+      context.usedCommandBufferCount = 0;
+    }
+  }
+
+  // the previous pipelines are retired like those of a swap chain, no wait on the device
+  void reloadChangedShaders()
+  {
+    if( !shaderManager_.updateModules() )
+      return;
+
+    RetiredSwapChain retiredPipelines{ .graphicPipelines{ std::exchange( graphicPipelines_, {} ) } };
+
+    createGraphicPipelines();
+
+    if( options_.prebakedCommandBuffers )
+    {
+      retireDrawCommandBuffers( retiredPipelines );
+      createDrawCommandBuffers();
+    }
+
+    retiredPipelines.completionValue = frameTimelineValue_;
+    retiredSwapChains_.push_back( std::move( retiredPipelines ) );
+  }
+
+  void retireGraphicPipeline( RetiredSwapChain &retiredSwapChain )
+  {
+    retiredSwapChain.renderPass = std::exchange( renderPass_, VK_NULL_HANDLE );
+    retiredSwapChain.pipelineLayout = std::exchange( pipelineLayout_, VK_NULL_HANDLE );
+    retiredSwapChain.graphicPipelines = std::exchange( graphicPipelines_, {} );
+  }
+
+  void retirePerImageResources( RetiredSwapChain &retiredSwapChain )
+  {
+    retiredSwapChain.buffers =
+    {
+      { std::exchange( uniformBuffer_, VK_NULL_HANDLE ), std::exchange( uniformBufferAllocation_, {} ) },
+      { std::exchange( instanceBuffer_, VK_NULL_HANDLE ), std::exchange( instanceBufferAllocation_, {} ) },
+      { std::exchange( visibleInstanceBuffer_, VK_NULL_HANDLE ), std::exchange( visibleInstanceBufferAllocation_, {} ) },
+      { std::exchange( indirectCommandBuffer_, VK_NULL_HANDLE ), std::exchange( indirectCommandBufferAllocation_, {} ) }
+    };
+
+    // destroying the pool frees its descriptor set
+    retiredSwapChain.descriptorPool = std::exchange( descriptorPool_, VK_NULL_HANDLE );
+    retiredSwapChain.timestampQueryPool = std::exchange( timestampQueryPool_, VK_NULL_HANDLE );
+  }
+
+  void destroyRetiredSwapChain( RetiredSwapChain &retiredSwapChain )
+  {
+    if( !retiredSwapChain.commandBuffers.empty() )
+      vkFreeCommandBuffers( logicalDevice_, graphicCommandPool_, static_cast< std::uint32_t >( retiredSwapChain.commandBuffers.size() ), retiredSwapChain.commandBuffers.data() );
+
+    for( std::size_t i = 0; i < retiredSwapChain.secondaryCommandBuffers.size(); ++i )
+      if( !retiredSwapChain.secondaryCommandBuffers[ i ].empty() )
+        vkFreeCommandBuffers( logicalDevice_,
+                              recordingContexts_[ i ].commandPool,
+                              static_cast< std::uint32_t >( retiredSwapChain.secondaryCommandBuffers[ i ].size() ),
+                              retiredSwapChain.secondaryCommandBuffers[ i ].data() );
+
+    for( auto &&framebuffer : retiredSwapChain.framebuffers )
+      vkDestroyFramebuffer( logicalDevice_, framebuffer, nullptr );
+
+    vkDestroyImageView( logicalDevice_, retiredSwapChain.depthImageView, nullptr );
+    vkDestroyImage( logicalDevice_, retiredSwapChain.depthImage, nullptr );
+    memoryAllocator_.free( retiredSwapChain.depthImageAllocation );
+    vkDestroyImageView( logicalDevice_, retiredSwapChain.colorImageView, nullptr );
+    vkDestroyImage( logicalDevice_, retiredSwapChain.colorImage, nullptr );
+    memoryAllocator_.free( retiredSwapChain.colorImageAllocation );
+
+    for( auto &&imageView : retiredSwapChain.imageViews )
+      vkDestroyImageView( logicalDevice_, imageView, nullptr );
+
+    // headless, VK_KHR_swapchain is not even enabled
+    if( !isHeadless() )
+      vkDestroySwapchainKHR( logicalDevice_, retiredSwapChain.swapChain, nullptr );
+
+    for( auto &&graphicPipeline : retiredSwapChain.graphicPipelines )
+      vkDestroyPipeline( logicalDevice_, graphicPipeline, nullptr );
+
+    vkDestroyPipelineLayout( logicalDevice_, retiredSwapChain.pipelineLayout, nullptr );
+    vkDestroyRenderPass( logicalDevice_, retiredSwapChain.renderPass, nullptr );
+
+    for( auto &&[ buffer, allocation ] : retiredSwapChain.buffers )
+    {
+      vkDestroyBuffer( logicalDevice_, buffer, nullptr );
+      memoryAllocator_.free( allocation );
+    }
+
+    vkDestroyDescriptorPool( logicalDevice_, retiredSwapChain.descriptorPool, nullptr );
+    vkDestroyQueryPool( logicalDevice_, retiredSwapChain.timestampQueryPool, nullptr );
+  }
+
+  void destroyCompletedRetiredSwapChains()
+  {
+    std::uint64_t completedValue{};
+    vkGetSemaphoreCounterValue( logicalDevice_, frameTimelineSemaphore_, &completedValue );
+
+    while( !retiredSwapChains_.empty() && retiredSwapChains_.front().completionValue <= completedValue )
+    {
+      destroyRetiredSwapChain( retiredSwapChains_.front() );
+      retiredSwapChains_.pop_front();
+    }
+  }
+
+  // the simulation thread keeps servicing the window and publishing its extent meanwhile
+  bool handleMinimizedWindow()
+  {
+    for( auto extent = framebufferExtent_.load( std::memory_order_acquire ); ; extent = framebufferExtent_.load( std::memory_order_acquire ) )
+    {
+      if( extent == closedWindowExtent_ )
+        return false;
+
+      if( const auto [ width, height ] = unpackFramebufferExtent( extent ); width != 0 && height != 0 )
+        return true;
+
+      framebufferExtent_.wait( extent, std::memory_order_acquire );
+    }
+  }
+
+  void createSynchronizationObjects()
+  {
+    VkSemaphoreCreateInfo semaphoreInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO }
+    };
+
+    VkFenceCreateInfo fenceInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO },
+      .flags{ VK_FENCE_CREATE_SIGNALED_BIT }
+    };
+
+    imageAvailableSemaphore_.resize( maxFrameInFlight_ );
+    renderFinishedSemaphore_.resize( maxFrameInFlight_ );
+    inFlightFences_.resize( maxFrameInFlight_ );
+    framePresentIds_.assign( maxFrameInFlight_, 0 );
+    inFlightImageFences_.resize( swapChainImages_.size(), VK_NULL_HANDLE );
+
+    for( std::uint8_t i = 0; i < maxFrameInFlight_; ++i )
+      if( vkCreateSemaphore( logicalDevice_, &semaphoreInfo, nullptr, &imageAvailableSemaphore_[ i ] ) != VK_SUCCESS ||
+          vkCreateSemaphore( logicalDevice_, &semaphoreInfo, nullptr, &renderFinishedSemaphore_[ i ] ) != VK_SUCCESS ||
+          vkCreateFence( logicalDevice_, &fenceInfo, nullptr, &inFlightFences_[ i ] ) != VK_SUCCESS )
+        throw std::runtime_error{ "Error failed to create synchronization objects!" };
+
+    for( auto &&context : cullingContexts_ )
+      if( vkCreateSemaphore( logicalDevice_, &semaphoreInfo, nullptr, &context.semaphore ) != VK_SUCCESS )
+        throw std::runtime_error{ "Error failed to create synchronization objects!" };
+
+    createTimelineSemaphore( &frameTimelineSemaphore_, "Error failed to create the frame timeline semaphore!" );
+  }
+
+  // secondary command buffers inherit nothing but the render pass, every state is set again in each of them
+  void recordDrawPartition( VkCommandBuffer targetCommandBuffer,
+                            VkFramebuffer targetFrameBuffer,
+                            VkPipeline pipeline,
+                            std::uint32_t uniformBufferSlot,
+                            std::size_t firstDraw,
+                            std::size_t drawCount )
+  {
+    VkCommandBufferInheritanceInfo inheritanceInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO },
+      .renderPass{ renderPass_ },
+      .subpass{ 0 },
+      .framebuffer{ targetFrameBuffer }
+    };
+
+    VkCommandBufferBeginInfo beginInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO },
+      .flags{ VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT },
+      .pInheritanceInfo{ &inheritanceInfo }
+    };
+
+    if( vkBeginCommandBuffer( targetCommandBuffer, &beginInfo ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to begin recording secondary command buffer!" };
+
+    vkCmdBindPipeline( targetCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline );
+
+    VkViewport viewport
+    {
+      .x{ 0.0f },
+      .y{ 0.0f },
+      .width{ static_cast< float >( swapChainExtent_.width ) },
+      .height{ static_cast< float >( swapChainExtent_.height ) },
+      .minDepth{ 0.0f },
+      .maxDepth{ 1.0f },
+    };
+
+    VkRect2D scissor
+    {
+      .offset{ 0, 0 },
+      .extent{ swapChainExtent_ }
+    };
+
+    vkCmdSetViewport( targetCommandBuffer, 0, 1, &viewport );
+    vkCmdSetScissor( targetCommandBuffer, 0, 1, &scissor );
+
+    VkBuffer vertexBuffers[] = { vertexBuffer_ };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers( targetCommandBuffer, 0, 1, vertexBuffers, offsets );
+    vkCmdBindIndexBuffer( targetCommandBuffer, indexBuffer_, 0, meshIndexType_ );
+    // the per frame set and the bindless one together, whatever the materials of the draws
+    const auto dynamicOffsets = getDynamicOffsets( uniformBufferSlot );
+    const VkDescriptorSet descriptorSets[]{ descriptorSet_, bindlessDescriptorSet_ };
+    vkCmdBindDescriptorSets( targetCommandBuffer,
+                             VK_PIPELINE_BIND_POINT_GRAPHICS,
+                             pipelineLayout_,
+                             0,
+                             sizeof( descriptorSets ) / sizeof( VkDescriptorSet ),
+                             descriptorSets,
+                             static_cast< std::uint32_t >( dynamicOffsets.size() ),
+                             dynamicOffsets.data() );
+
+    // instance counts are only known on the device, written by the culling pass
+    vkCmdDrawIndexedIndirect( targetCommandBuffer,
+                              indirectCommandBuffer_,
+                              uniformBufferSlot * indirectCommandBufferSlotSize_ + firstDraw * sizeof( VkDrawIndexedIndirectCommand ),
+                              static_cast< std::uint32_t >( drawCount ),
+                              sizeof( VkDrawIndexedIndirectCommand ) );
+
+    if( vkEndCommandBuffer( targetCommandBuffer ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to record secondary command buffer!" };
+  }
+
+  void createDrawCommandBuffer( VkFramebuffer targetFrameBuffer,
+                                VkCommandBuffer targetCommandBuffer,
+                                std::uint32_t uniformBufferSlot,
+                                std::span< const VkCommandBuffer > secondaryCommandBuffers,
+                                const LodSelection &lodSelection )
+  {
+    VkCommandBufferBeginInfo beginInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO },
+      .flags{ 0 }, // Optional
+      .pInheritanceInfo{ nullptr } // Optional
+    };
+
+    if( vkBeginCommandBuffer( targetCommandBuffer, &beginInfo ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to begin recording command buffer!" };
+
+    if( timestampQueryPool_ != VK_NULL_HANDLE )
+    {
+      vkCmdResetQueryPool( targetCommandBuffer, timestampQueryPool_, 2 * uniformBufferSlot, 2 );
+      vkCmdWriteTimestamp( targetCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool_, 2 * uniformBufferSlot );
+    }
+
+    if( !isCullingAsynchronous() )
+      recordCulling( targetCommandBuffer, uniformBufferSlot, lodSelection );
+
+    VkClearValue clearColors[]
+    {
+      { 0, 0, 0, 1 },
+      { 1, 0 }
+    };
+
+    VkRenderPassBeginInfo renderPassInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO },
+      .renderPass{ renderPass_},
+      .framebuffer{ targetFrameBuffer },
+      .renderArea
+      {
+        .offset{ 0, 0 },
+        .extent{ swapChainExtent_ }
+      },
+      .clearValueCount{ sizeof( clearColors ) / sizeof( VkClearValue ) },
+      .pClearValues{ clearColors }
+    };
+
+    vkCmdBeginRenderPass( targetCommandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+    vkCmdExecuteCommands( targetCommandBuffer, static_cast< std::uint32_t >( secondaryCommandBuffers.size() ), secondaryCommandBuffers.data() );
+    vkCmdEndRenderPass( targetCommandBuffer );
+
+    if( timestampQueryPool_ != VK_NULL_HANDLE )
+      vkCmdWriteTimestamp( targetCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool_, 2 * uniformBufferSlot + 1 );
+
+    if( vkEndCommandBuffer( targetCommandBuffer ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to record command buffer!" };
+  }
+
+  // as many partitions as workers, unless there are too few draws to make it worth it
+  std::size_t getDrawPartitionCount( std::size_t drawCount ) const noexcept
+  {
+    const auto partitionCount = ( drawCount + minimumDrawsPerPartition_ - 1 ) / minimumDrawsPerPartition_;
+
+    return std::clamp< std::size_t >( partitionCount, 1, jobSystem_.getWorkerCount() );
+  }
+
+  VkCommandBuffer acquireSecondaryCommandBuffer( RecordingContext &context )
+  {
+    if( context.usedCommandBufferCount == context.commandBuffers.size() )
+    {
+      VkCommandBuffer commandBuffer;
+      allocateCommandBuffers( context.commandPool, 1, &commandBuffer, VK_COMMAND_BUFFER_LEVEL_SECONDARY );
+      context.commandBuffers.push_back( commandBuffer );
+    }
+
+    return context.commandBuffers[ context.usedCommandBufferCount++ ];
+  }
+
+  // only the draws of the selected levels of detail are recorded, the others would have no instance to draw
+  std::size_t getSelectedDrawCount( const LodSelection &lodSelection ) const noexcept
+  {
+    const auto &coarsestLod = meshLods_[ lodSelection.coarsestLod ];
+
+    return coarsestLod.firstDraw + coarsestLod.drawCount - meshLods_[ lodSelection.finestLod ].firstDraw;
+  }
+
+  // the pipeline of each pass, the depth pre-pass one first when enabled
+  std::vector< VkPipeline > getDrawPassPipelines() const
+  {
+    if( depthPrePassEnabled_ )
+      return { getGraphicPipeline( { PipelineFeature::depthOnly } ), getGraphicPipeline( { PipelineFeature::depthEqual } ) };
+
+    return { getGraphicPipeline( {} ) };
+  }
+
+  // Secondary command buffers are recorded by the workers from their own pool, grouped by image then by pass in secondaryCommandBuffers. All
+  // the partitions of a pass are executed before the next pass. Returns the secondary command buffer count of each image
+  std::size_t recordDrawPartitions( std::span< RecordingContext > recordingContexts,
+                                    std::span< const std::uint32_t > imageIndices,
+                                    std::vector< VkCommandBuffer > &secondaryCommandBuffers,
+                                    const LodSelection &lodSelection )
+  {
+    const auto selectedDrawCount = getSelectedDrawCount( lodSelection );
+    const auto partitionCount = getDrawPartitionCount( selectedDrawCount );
+    const auto passPipelines = getDrawPassPipelines();
+    const auto commandBuffersPerImage = passPipelines.size() * partitionCount;
+
+    secondaryCommandBuffers.assign( imageIndices.size() * commandBuffersPerImage, VK_NULL_HANDLE );
+
+    jobSystem_.run( secondaryCommandBuffers.size(), [ &, selectedDrawCount, partitionCount, commandBuffersPerImage ]( std::size_t workerIndex, std::size_t taskIndex )
+    {
+      const auto imageIndex = imageIndices[ taskIndex / commandBuffersPerImage ];
+      const auto pipeline = passPipelines[ taskIndex % commandBuffersPerImage / partitionCount ];
+      const auto partitionIndex = taskIndex % partitionCount;
+      const auto firstDraw = meshLods_[ lodSelection.finestLod ].firstDraw + selectedDrawCount * partitionIndex / partitionCount;
+      const auto endDraw = meshLods_[ lodSelection.finestLod ].firstDraw + selectedDrawCount * ( partitionIndex + 1 ) / partitionCount;
+
+      auto commandBuffer = acquireSecondaryCommandBuffer( recordingContexts[ workerIndex ] );
+      secondaryCommandBuffers[ taskIndex ] = commandBuffer;
+
+      recordDrawPartition( commandBuffer, swapChainFramebuffers_[ imageIndex ], pipeline, imageIndex, firstDraw, endDraw - firstDraw );
+    } );
+
+    return commandBuffersPerImage;
+  }
+
+  // the levels the draws of the frame are recorded for, the culling selects among them
+  LodSelection getRecordedLodSelection() const noexcept
+  {
+    // the camera is not known when prebaking, the device selects among all levels
+    if( options_.prebakedCommandBuffers )
+      return LodSelection{ .finestLod{ 0 }, .coarsestLod{ static_cast< std::uint32_t >( meshLods_.size() - 1 ) } };
+
+    return frameLodSelection_;
+  }
+
+  // prebaked mode only, primary command buffers then only execute the secondary ones in order
+  void createDrawCommandBuffers()
+  {
+    if( !options_.prebakedCommandBuffers )
+      return;
+
+    commandBuffers_.resize( swapChainFramebuffers_.size() );
+
+    allocateCommandBuffers( graphicCommandPool_, static_cast< std::uint32_t >( commandBuffers_.size() ), commandBuffers_.data() );
+
+    std::vector< std::uint32_t > imageIndices( commandBuffers_.size() );
+    std::iota( imageIndices.begin(), imageIndices.end(), 0 );
+
+    const auto lodSelection = getRecordedLodSelection();
+    const auto commandBuffersPerImage = recordDrawPartitions( recordingContexts_, imageIndices, secondaryCommandBuffers_, lodSelection );
+
+    for( std::size_t i = 0; i < commandBuffers_.size(); i++ )
+      createDrawCommandBuffer( swapChainFramebuffers_[ i ],
+                               commandBuffers_[ i ],
+                               static_cast< std::uint32_t >( i ),
+                               std::span{ secondaryCommandBuffers_ }.subspan( i * commandBuffersPerImage, commandBuffersPerImage ),
+                               lodSelection );
+  }
+
+  // resetting a whole pool is cheaper than resetting its command buffers one by one, and keeps their memory around for the next recording
+  void resetRecordingContext( RecordingContext &context )
+  {
+    if( vkResetCommandPool( logicalDevice_, context.commandPool, 0 ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to reset a recording command pool!" };
+
+    context.usedCommandBufferCount = 0;
+  }
+
+  // the frame fence has been waited on, nothing recorded from its pools is executing anymore
+  void recordFrameCommandBuffer( std::uint32_t imageIndex )
+  {
+    auto &frame = frameContexts_[ currentFrame_ ];
+
+    if( vkResetCommandPool( logicalDevice_, frame.commandPool, 0 ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to reset a frame command pool!" };
+
+    for( auto &&context : frame.recordingContexts )
+      resetRecordingContext( context );
+
+    const std::uint32_t imageIndices[] = { imageIndex };
+
+    recordDrawPartitions( frame.recordingContexts, imageIndices, frame.secondaryCommandBuffers, frameLodSelection_ );
+    createDrawCommandBuffer( swapChainFramebuffers_[ imageIndex ], frame.commandBuffer, imageIndex, frame.secondaryCommandBuffers, frameLodSelection_ );
+  }
+
+  // the frame fence has been waited on, the draws that waited on the previous culling of this slot are complete and so is the culling
+  void recordCullingCommandBuffer( std::uint32_t imageIndex )
+  {
+    auto &context = cullingContexts_[ currentFrame_ ];
+
+    if( vkResetCommandPool( logicalDevice_, context.commandPool, 0 ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to reset a culling command pool!" };
+
+    VkCommandBufferBeginInfo beginInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO },
+      .flags{ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT }
+    };
+
+    if( vkBeginCommandBuffer( context.commandBuffer, &beginInfo ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to begin recording culling command buffer!" };
+
+    recordCulling( context.commandBuffer, imageIndex, getRecordedLodSelection() );
+
+    if( vkEndCommandBuffer( context.commandBuffer ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to record culling command buffer!" };
+  }
+
+  void submitCullingQueue()
+  {
+    const auto &context = cullingContexts_[ currentFrame_ ];
+
+    VkSubmitInfo submitInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SUBMIT_INFO },
+      .commandBufferCount{ 1 },
+      .pCommandBuffers{ &context.commandBuffer },
+      .signalSemaphoreCount{ 1 },
+      .pSignalSemaphores{ &context.semaphore }
+    };
+
+    if( vkQueueSubmit( computeQueue_, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to submit culling command buffer!" };
+  }
+
+  VkCommandBuffer getDrawCommandBuffer( std::uint32_t imageIndex ) const
+  {
+    return options_.prebakedCommandBuffers ? commandBuffers_[ imageIndex ] : frameContexts_[ currentFrame_ ].commandBuffer;
+  }
+
+  void createCommandPool( VkCommandPoolCreateFlags flags, std::uint32_t queueFamilyIndex, VkCommandPool *commandPool, const char *const exceptionMessage )
+  {
+    VkCommandPoolCreateInfo poolInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO },
+      .flags{ flags },
+      .queueFamilyIndex{ queueFamilyIndex }
+    };
+
+    if( vkCreateCommandPool( logicalDevice_, &poolInfo, nullptr, commandPool ) != VK_SUCCESS )
+      throw std::runtime_error{ exceptionMessage };
+  }
+
+  void createGraphicPool()
+  {
+    createCommandPool( 0,
+                       requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+                       &graphicCommandPool_,
+                       "Error failed to create the graphic command pool!" );
+  }
+
+  void createTransfertPool()
+  {
+    createCommandPool( VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                       requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value(),
+                       &transfertCommandPool_,
+                       "Error failed to create the transfert command pool!" );
+  }
+
+  void createGraphicUploadPool()
+  {
+    createCommandPool( VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                       requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+                       &graphicUploadCommandPool_,
+                       "Error failed to create the graphic upload command pool!" );
+  }
+
+  // a command pool must not be used by several threads at once, each recording worker owns one
+  void createRecordingPools()
+  {
+    recordingContexts_.resize( jobSystem_.getWorkerCount() );
+
+    for( auto &&context : recordingContexts_ )
+      createCommandPool( 0,
+                         requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+                         &context.commandPool,
+                         "Error failed to create a recording command pool!" );
+  }
+
+  void createFramePools()
+  {
+    frameContexts_.resize( maxFrameInFlight_ );
+
+    for( auto &&frame : frameContexts_ )
+    {
+      createCommandPool( VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                         requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+                         &frame.commandPool,
+                         "Error failed to create a frame command pool!" );
+
+      allocateCommandBuffers( frame.commandPool, 1, &frame.commandBuffer );
+
+      frame.recordingContexts.resize( jobSystem_.getWorkerCount() );
+
+      for( auto &&context : frame.recordingContexts )
+        createCommandPool( VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                           requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+                           &context.commandPool,
+                           "Error failed to create a frame recording command pool!" );
+    }
+  }
+
+  void createCullingPools()
+  {
+    if( !isCullingAsynchronous() )
+      return;
+
+    cullingContexts_.resize( maxFrameInFlight_ );
+
+    for( auto &&context : cullingContexts_ )
+    {
+      createCommandPool( VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                         requiredQueueFamilyIndices_.computeQueueFamilyIndex.value(),
+                         &context.commandPool,
+                         "Error failed to create a culling command pool!" );
+
+      allocateCommandBuffers( context.commandPool, 1, &context.commandBuffer );
+    }
+  }
+
+  void createCommandPools()
+  {
+    createGraphicPool();
+    createTransfertPool();
+    createGraphicUploadPool();
+    createCullingPools();
+
+    if( options_.prebakedCommandBuffers )
+      createRecordingPools();
+    else
+      createFramePools();
+  }
+
+  void createFramebuffer( VkImageView imageView, VkImageView depthImageView, VkFramebuffer *targetFramebuffer )
+  {
+    // the swap chain image is the resolve attachment when multisampled
+    VkImageView attachments[]
+    {
+      isMultisampled() ? colorImageView_ : imageView,
+      depthImageView,
+      imageView
+    };
+
+    VkFramebufferCreateInfo framebufferInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO },
+      .renderPass{ renderPass_ },
+      .attachmentCount{ isMultisampled() ? 3u : 2u },
+      .pAttachments{ attachments },
+      .width{ swapChainExtent_.width },
+      .height{ swapChainExtent_.height },
+      .layers{ 1 }
+    };
+
+    if( vkCreateFramebuffer( logicalDevice_, &framebufferInfo, nullptr, targetFramebuffer ) != VK_SUCCESS )
+      throw std::runtime_error{ "failed to create framebuffer!" };
+  }
+
+  void createFramebuffers()
+  {
+    swapChainFramebuffers_.resize( swapChainImageViews_.size() );
+
+    for( std::size_t i = 0; i < swapChainImageViews_.size(); i++ )
+      createFramebuffer( swapChainImageViews_[ i ], depthImageView_, &swapChainFramebuffers_[ i ] );
+  }
+
+  void createRenderPass()
+  {
+    const auto presentedLayout = isHeadless() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // color, depth then, when multisampled only, the swap chain image color is resolved to at the end of the subpass
+    VkAttachmentDescription attachmentDescriptions[]
+    {
+      {
+        .format{ swapChainSurfaceFormat_.format },
+        .samples{ msaaSamples_ },
+        .loadOp{ VK_ATTACHMENT_LOAD_OP_CLEAR },
+        .storeOp{ isMultisampled() ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE },
+        .stencilLoadOp{ VK_ATTACHMENT_LOAD_OP_DONT_CARE },
+        .stencilStoreOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
+        .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED },
+        .finalLayout{ isMultisampled() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : presentedLayout },
+      },
+      {
+        .format{ findDepthFormat() },
+        .samples{ msaaSamples_ },
+        .loadOp{ VK_ATTACHMENT_LOAD_OP_CLEAR },
+        .storeOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
+        .stencilLoadOp{ VK_ATTACHMENT_LOAD_OP_DONT_CARE },
+        .stencilStoreOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
+        .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED },
+        .finalLayout{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+      },
+      {
+        .format{ swapChainSurfaceFormat_.format },
+        .samples{ VK_SAMPLE_COUNT_1_BIT },
+        .loadOp{ VK_ATTACHMENT_LOAD_OP_DONT_CARE },
+        .storeOp{ VK_ATTACHMENT_STORE_OP_STORE },
+        .stencilLoadOp{ VK_ATTACHMENT_LOAD_OP_DONT_CARE },
+        .stencilStoreOp{ VK_ATTACHMENT_STORE_OP_DONT_CARE },
+        .initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED },
+        .finalLayout{ presentedLayout },
+      }
+    };
+
+    VkAttachmentReference colorAttachmentReferences[]
+    {
+      {
+        .attachment{ 0 },
+        .layout{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }
+      }
+    };
+
+    VkAttachmentReference depthStencilAttachmentReference
+    {
+      .attachment{ 1 },
+      .layout{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL }
+    };
+
+    VkAttachmentReference resolveAttachmentReferences[]
+    {
+      {
+        .attachment{ 2 },
+        .layout{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }
+      }
+    };
+
+    VkSubpassDescription subPasses[]
+    {
+      {
+        .pipelineBindPoint{ VK_PIPELINE_BIND_POINT_GRAPHICS },
+        .colorAttachmentCount{ sizeof( colorAttachmentReferences ) / sizeof( VkAttachmentReference ) },
+        .pColorAttachments{ colorAttachmentReferences },
+        .pResolveAttachments{ isMultisampled() ? resolveAttachmentReferences : nullptr },
+        .pDepthStencilAttachment{ &depthStencilAttachmentReference }
+      }
+    };
+
+    VkSubpassDependency dependencies[]
+    {
+      {
+        .srcSubpass{ VK_SUBPASS_EXTERNAL },
+        .dstSubpass{ 0 },
+        .srcStageMask{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
+        .dstStageMask{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
+        .srcAccessMask{ 0 },
+        .dstAccessMask{ VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT }
+      }
+    };
+
+    VkRenderPassCreateInfo renderPassInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO },
+      .attachmentCount{ isMultisampled() ? 3u : 2u },
+      .pAttachments{ attachmentDescriptions },
+      .subpassCount{ sizeof( subPasses ) / sizeof( VkSubpassDescription ) },
+      .pSubpasses{ subPasses },
+      .dependencyCount{ sizeof( dependencies ) / sizeof( VkSubpassDependency ) },
+      .pDependencies{ dependencies }
+    };
+
+    if( vkCreateRenderPass( logicalDevice_, &renderPassInfo, nullptr, &renderPass_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create render pass!" };
+  }
+
+  // the culling shader is not watched, its pipeline is never created again
+  void createShaderManager()
+  {
+    shaderManager_.initialize( logicalDevice_, applicationPath_.parent_path() / "shaders", options_.shaderSourceDirectory );
+    shaderManager_.watchSource( "vert", "shader.vert" );
+    shaderManager_.watchSource( "frag", "shader.frag" );
+    shaderManager_.watchSource( "depth", "depth.vert" );
+  }
+
+  GraphicShaderModules getShaderModules()
+  {
+    return { shaderManager_.getModule( "vert" ), shaderManager_.getModule( "frag" ), shaderManager_.getModule( "depth" ) };
+  }
+
+  void createGraphicPipelineLayout()
+  {
+    const VkDescriptorSetLayout setLayouts[]{ descriptorSetLayout_, bindlessDescriptorSetLayout_ };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO },
+      .setLayoutCount{ sizeof( setLayouts ) / sizeof( VkDescriptorSetLayout ) },
+      .pSetLayouts{ setLayouts },
+      .pushConstantRangeCount{ 0 }, // Optional
+      .pPushConstantRanges{ nullptr }, // Optional
+    };
+
+    if( vkCreatePipelineLayout( logicalDevice_, &pipelineLayoutInfo, nullptr, &pipelineLayout_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create pipeline layout!" };
+  }
 
   void createGraphicPipeline()
   {
-    createGraphicPipelineLayout();
+    createGraphicPipelineLayout();
+    createGraphicPipelines();
+  }
+
+  template< std::size_t... Indices >
+  static constexpr auto makeGraphicPipelineFactories( std::index_sequence< Indices... > ) noexcept
+  {
+    return std::array{ &VulkanApplication::createGraphicPipelineVariant< std::tuple_element_t< Indices, GraphicPipelineVariants > >... };
+  }
+
+  // Each variant is built by its own worker into the shared pipeline cache, it is internally synchronized. Modules are obtained beforehand,
+  // the shader manager is not thread safe
+  void createGraphicPipelines()
+  {
+    static constexpr auto factories = makeGraphicPipelineFactories( std::make_index_sequence< std::tuple_size_v< GraphicPipelineVariants > >{} );
+
+    const auto shaderModules = getShaderModules();
+
+    graphicPipelines_.assign( factories.size(), VK_NULL_HANDLE );
+
+    jobSystem_.run( factories.size(), [ & ]( std::size_t, std::size_t variantIndex )
+    {
+      ( this->*factories[ variantIndex ] )( shaderModules, graphicPipelines_[ variantIndex ] );
+    } );
+  }
+
+  // O(1), the variant must be one of GraphicPipelineVariants once combined with the vertex layout of the build
+  VkPipeline getGraphicPipeline( std::initializer_list< PipelineFeature > features ) const noexcept
+  {
+    return graphicPipelines_[ graphicPipelineVariantIndices[ gpuVertexPipelineKey | makePipelineVariantKey( features ) ] ];
+  }
+
+  template< typename Variant >
+  void createGraphicPipelineVariant( const GraphicShaderModules &shaderModules, VkPipeline &pipeline ) const
+  {
+    constexpr bool isDepthOnly = hasPipelineFeature( Variant::key, PipelineFeature::depthOnly );
+    constexpr bool isDepthEqual = hasPipelineFeature( Variant::key, PipelineFeature::depthEqual );
+
+    auto bindingDescription = Variant::VertexLayout::getBindingDescription();
+    auto attributeDescriptions = Variant::VertexLayout::getAttributeDescriptions();
+
+    // positions only for the depth pre-pass, they come first
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO },
+      .vertexBindingDescriptionCount{ 1 },
+      .pVertexBindingDescriptions{ &bindingDescription },
+      .vertexAttributeDescriptionCount{ isDepthOnly ? 1 : static_cast< std::uint32_t >( attributeDescriptions.size() ) },
+      .pVertexAttributeDescriptions{ attributeDescriptions.data() }
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO },
+      .topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST },
+      .primitiveRestartEnable{ VK_FALSE }
+    };
+
+    // viewport and scissor are set when recording, the pipeline survives swap chain extent changes
+    VkPipelineViewportStateCreateInfo viewportState
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO },
+      .viewportCount{ 1 },
+      .pViewports{ nullptr },
+      .scissorCount{ 1 },
+      .pScissors{ nullptr },
+    };
+
+    VkDynamicState dynamicStates[]
+    {
+      VK_DYNAMIC_STATE_VIEWPORT,
+      VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO },
+      .dynamicStateCount{ sizeof( dynamicStates ) / sizeof( VkDynamicState ) },
+      .pDynamicStates{ dynamicStates }
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterizer
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO },
+      .depthClampEnable{ VK_FALSE },
+      .rasterizerDiscardEnable{ VK_FALSE },
+      .polygonMode{ VK_POLYGON_MODE_FILL },
+      .cullMode{ VK_CULL_MODE_BACK_BIT },
+      .frontFace{ VK_FRONT_FACE_COUNTER_CLOCKWISE },
+      .depthBiasEnable{ VK_FALSE },
+      .depthBiasConstantFactor{ 0.0f }, // Optional
+      .depthBiasClamp{ 0.0f }, // Optional
+      .depthBiasSlopeFactor{ 0.0f }, // Optional
+      .lineWidth{ 1.0f },
+    };
+
+    VkPipelineMultisampleStateCreateInfo multisampling
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO },
+      .rasterizationSamples{ msaaSamples_ },
+      .sampleShadingEnable{ VK_FALSE },
+      .minSampleShading{ 1.0f }, // Optional
+      .pSampleMask{ nullptr }, // Optional
+      .alphaToCoverageEnable{ VK_FALSE }, // Optional
+      .alphaToOneEnable{ VK_FALSE }, // Optional
+    };
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachments[]
+    {
+      {
+        .blendEnable{ VK_FALSE },
+        .srcColorBlendFactor{ VK_BLEND_FACTOR_ONE }, // Optional
+        .dstColorBlendFactor{ VK_BLEND_FACTOR_ZERO }, // Optional
+        .colorBlendOp{ VK_BLEND_OP_ADD }, // Optional
+        .srcAlphaBlendFactor{ VK_BLEND_FACTOR_ONE }, // Optional
+        .dstAlphaBlendFactor{ VK_BLEND_FACTOR_ZERO }, // Optional
+        .alphaBlendOp{ VK_BLEND_OP_ADD }, // Optional
+        .colorWriteMask{ isDepthOnly ? 0 : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT }
+      }
+    };
+
+    VkPipelineColorBlendStateCreateInfo colorBlending
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO },
+      .logicOpEnable{ VK_FALSE },
+      .logicOp{ VK_LOGIC_OP_COPY }, // Optional
+      .attachmentCount{ sizeof( colorBlendAttachments ) / sizeof( VkPipelineColorBlendAttachmentState ) },
+      .pAttachments{ colorBlendAttachments },
+      .blendConstants{ 0.0f, 0.0f, 0.0f, 0.0f }
+    };
+
+    const auto specializationInfo = Variant::getSpecializationInfo();
+
+    // no fragment shader for the depth pre-pass, depth is all it writes
+    VkPipelineShaderStageCreateInfo shaderStages[]
+    {
+      {
+        .sType{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO },
+        .stage{ VK_SHADER_STAGE_VERTEX_BIT },
+        .module{ isDepthOnly ? shaderModules.depthVertex : shaderModules.vertex },
+        .pName{ "main" },
+        .pSpecializationInfo{ &specializationInfo }
+      },
+      {
+        .sType{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO },
+        .stage{ VK_SHADER_STAGE_FRAGMENT_BIT },
+        .module{ shaderModules.fragment },
+        .pName{ "main" },
+        .pSpecializationInfo{ &specializationInfo }
+      }
+    };
+
+    // after the pre-pass, only the nearest fragment of each pixel is shaded
+    VkPipelineDepthStencilStateCreateInfo depthStencilInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO },
+      .depthTestEnable{ VK_TRUE },
+      .depthWriteEnable{ isDepthEqual ? VK_FALSE : VK_TRUE },
+      .depthCompareOp{ isDepthEqual ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS },
+      .depthBoundsTestEnable{ VK_FALSE },
+      .stencilTestEnable{ VK_FALSE },
+      .front{}, // Optional
+      .back{}, // Optional
+      .minDepthBounds{ 0.0f }, // Optional
+      .maxDepthBounds{ 1.0f } // Optional
+    };
+
+    VkGraphicsPipelineCreateInfo pipelineInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO },
+      .stageCount{ isDepthOnly ? 1u : 2u },
+      .pStages{ shaderStages },
+      .pVertexInputState{ &vertexInputInfo },
+      .pInputAssemblyState{ &inputAssembly },
+      .pViewportState{ &viewportState },
+      .pRasterizationState{ &rasterizer },
+      .pMultisampleState{ &multisampling },
+      .pDepthStencilState{ &depthStencilInfo },
+      .pColorBlendState{ &colorBlending },
+      .pDynamicState{ &dynamicState },
+      .layout{ pipelineLayout_ },
+      .renderPass{ renderPass_ },
+      .subpass{ 0 },
+      .basePipelineHandle{ VK_NULL_HANDLE }, // Optional
+      .basePipelineIndex{ -1 } // Optional
+    };
+
+    if( vkCreateGraphicsPipelines( logicalDevice_, pipelineCache_, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create graphics pipeline!" };
+  }
+
+  // shares the descriptor set layout of the graphic pipeline, the very same descriptor set is bound to both bind points
+  void createCullingPipeline()
+  {
+    VkPushConstantRange pushConstantRanges[]
+    {
+      {
+        .stageFlags{ VK_SHADER_STAGE_COMPUTE_BIT },
+        .offset{ 0 },
+        .size{ sizeof( CullingParameters ) }
+      }
+    };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO },
+      .setLayoutCount{ 1 },
+      .pSetLayouts{ &descriptorSetLayout_ },
+      .pushConstantRangeCount{ sizeof( pushConstantRanges ) / sizeof( VkPushConstantRange ) },
+      .pPushConstantRanges{ pushConstantRanges }
+    };
+
+    if( vkCreatePipelineLayout( logicalDevice_, &pipelineLayoutInfo, nullptr, &cullingPipelineLayout_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create culling pipeline layout!" };
+
+    auto computeShaderModule = shaderManager_.getModule( "cull" );
+
+    VkComputePipelineCreateInfo pipelineInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO },
+      .stage
+      {
+        .sType{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO },
+        .stage{ VK_SHADER_STAGE_COMPUTE_BIT },
+        .module{ computeShaderModule },
+        .pName{ "main" }
+      },
+      .layout{ cullingPipelineLayout_ },
+      .basePipelineHandle{ VK_NULL_HANDLE },
+      .basePipelineIndex{ -1 }
+    };
+
+    if( vkCreateComputePipelines( logicalDevice_, pipelineCache_, 1, &pipelineInfo, nullptr, &cullingPipeline_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create culling pipeline!" };
+  }
+
+  // runs just before the render pass in the same command buffer, thus reading the very uniform and instance data the draws use
+  void recordCulling( VkCommandBuffer commandBuffer, std::uint32_t slot, const LodSelection &lodSelection )
+  {
+    vkCmdFillBuffer( commandBuffer, visibleInstanceBuffer_, slot * visibleInstanceBufferSlotSize_, sizeof( std::uint32_t ) * maxMeshLodCount_, 0 );
+
+    recordPipelineBarrier( commandBuffer,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VkMemoryBarrier
+                           {
+                             .sType{ VK_STRUCTURE_TYPE_MEMORY_BARRIER },
+                             .srcAccessMask{ VK_ACCESS_TRANSFER_WRITE_BIT },
+                             .dstAccessMask{ VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT }
+                           } );
+
+    vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline_ );
+
+    const auto dynamicOffsets = getDynamicOffsets( slot );
+    vkCmdBindDescriptorSets( commandBuffer,
+                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                             cullingPipelineLayout_,
+                             0,
+                             1,
+                             &descriptorSet_,
+                             static_cast< std::uint32_t >( dynamicOffsets.size() ),
+                             dynamicOffsets.data() );
+
+    CullingParameters parameters
+    {
+      .boundingSphere{ meshBoundingSphere_ },
+      .lodPixelScale{ getLodPixelScale() },
+      .instanceCount{ options_.instanceCount },
+      .indicesPerDrawRange{ indicesPerDrawRange_ },
+      .drawCount{ static_cast< std::uint32_t >( drawList_.size() ) },
+      .lodCount{ static_cast< std::uint32_t >( meshLods_.size() ) },
+      .finestLod{ lodSelection.finestLod },
+      .coarsestLod{ lodSelection.coarsestLod },
+      .pass{ 0 }
+    };
+
+    // unused levels keep null ranges and errors, they are never selected
+    for( std::size_t lod = 0; lod < meshLods_.size(); ++lod )
+    {
+      parameters.lodErrors[ static_cast< int >( lod ) ] = meshLods_[ lod ].error;
+      parameters.lodFirstDraws[ static_cast< int >( lod ) ] = meshLods_[ lod ].firstDraw;
+      parameters.lodFirstIndices[ static_cast< int >( lod ) ] = meshLods_[ lod ].firstIndex;
+      parameters.lodIndexCounts[ static_cast< int >( lod ) ] = meshLods_[ lod ].indexCount;
+    }
+
+    vkCmdPushConstants( commandBuffer, cullingPipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( parameters ), &parameters );
+    vkCmdDispatch( commandBuffer, ( parameters.instanceCount + cullingGroupSize_ - 1 ) / cullingGroupSize_, 1, 1 );
+
+    // the visible instance count must be final before it is written in the draw commands
+    recordPipelineBarrier( commandBuffer,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VkMemoryBarrier
+                           {
+                             .sType{ VK_STRUCTURE_TYPE_MEMORY_BARRIER },
+                             .srcAccessMask{ VK_ACCESS_SHADER_WRITE_BIT },
+                             .dstAccessMask{ VK_ACCESS_SHADER_READ_BIT }
+                           } );
+
+    parameters.pass = 1;
+
+    vkCmdPushConstants( commandBuffer, cullingPipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( parameters ), &parameters );
+    vkCmdDispatch( commandBuffer, ( parameters.drawCount + cullingGroupSize_ - 1 ) / cullingGroupSize_, 1, 1 );
+
+    // on its own queue, the semaphore the draws wait on makes the results visible to them
+    if( isCullingAsynchronous() )
+      return;
+
+    recordPipelineBarrier( commandBuffer,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                           VkMemoryBarrier
+                           {
+                             .sType{ VK_STRUCTURE_TYPE_MEMORY_BARRIER },
+                             .srcAccessMask{ VK_ACCESS_SHADER_WRITE_BIT },
+                             .dstAccessMask{ VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT }
+                           } );
+  }
+
+  void createImageView( VkImage image, VkImageView *targetImageView, VkFormat format, VkImageAspectFlags aspectFlags, std::uint32_t mipLevels )
+  {
+    VkImageViewCreateInfo createInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO },
+      .image{ image },
+      .viewType{ VK_IMAGE_VIEW_TYPE_2D },
+      .format{ format },
+      .components
+      {
+        .r{ VK_COMPONENT_SWIZZLE_IDENTITY },
+        .g{ VK_COMPONENT_SWIZZLE_IDENTITY },
+        .b{ VK_COMPONENT_SWIZZLE_IDENTITY },
+        .a{ VK_COMPONENT_SWIZZLE_IDENTITY }
+      },
+      .subresourceRange
+      {
+        .aspectMask{ aspectFlags },
+        .baseMipLevel{ 0 },
+        .levelCount{ mipLevels },
+        .baseArrayLayer{ 0 },
+        .layerCount{ 1 }
+      }
+    };
+
+    if( vkCreateImageView( logicalDevice_, &createInfo, nullptr, targetImageView ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create image views!" };
+  }
+
+  void createImageViews()
+  {
+    swapChainImageViews_.resize( swapChainImages_.size() );
+
+    for( std::size_t i = 0; i < swapChainImages_.size(); ++i )
+      createImageView( swapChainImages_[ i ], &swapChainImageViews_[ i ], swapChainSurfaceFormat_.format, VK_IMAGE_ASPECT_COLOR_BIT, 1 );
+  }
+
+  void setupSwapChainImageSharingMode( VkSwapchainCreateInfoKHR &createInfo )
+  {
+    uint32_t queueFamilyIndices[]
+    {
+      requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
+      requiredQueueFamilyIndices_.presentationQueueFamilyIndex.value()
+    };
+
+    if( requiredQueueFamilyIndices_.graphicsQueueFamilyIndex != requiredQueueFamilyIndices_.presentationQueueFamilyIndex )
+    {
+      createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+      createInfo.queueFamilyIndexCount = 2;
+      createInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+    else
+    {
+      createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      createInfo.queueFamilyIndexCount = 0; // Optional
+      createInfo.pQueueFamilyIndices = nullptr; // Optional
+    }
+  }
+
+  // frames in flight do not depend on the swap chain image count, whose maximum may even be unbounded
+  std::uint8_t getFramesInFlight() const noexcept
+  {
+    switch( options_.latencyPolicy )
+    {
+    case LatencyPolicy::throughput:
+      return 3;
+    case LatencyPolicy::powerSave:
+      return 1;
+    default:
+      return 2;
+    }
+  }
+
+  // one more image than the minimum lets the application acquire without waiting on the presentation engine, FIFO presentation also keeps
+  // an image per frame in flight
+  auto getRelevantSwapChainImageCount()
+  {
+    const auto &capabilities = swapChainSupportDetails_.surfaceCapabilities_;
+    std::uint32_t imageCount = capabilities.minImageCount + 1;
+
+    if( options_.latencyPolicy == LatencyPolicy::throughput )
+      imageCount = std::max< std::uint32_t >( imageCount, getFramesInFlight() );
+    else if( options_.latencyPolicy == LatencyPolicy::powerSave )
+      imageCount = capabilities.minImageCount;
+
+    if( capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount )
+      imageCount = capabilities.maxImageCount;
+
+    return imageCount;
+  }
+
+  // the old swap chain, if any, is retired: its images already acquired may still be presented, but no other can be acquired
+  void createSwapChain( VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE )
+  {
+    setupSwapChainSurfaceFormat();
+    setupSwapChainExtent();
+
+    auto imageCount = getRelevantSwapChainImageCount();
+
+    VkSwapchainCreateInfoKHR createInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR },
+      .surface{ surface_ },
+      .minImageCount{ imageCount },
+      .imageFormat{ swapChainSurfaceFormat_.format },
+      .imageColorSpace{ swapChainSurfaceFormat_.colorSpace },
+      .imageExtent{ swapChainExtent_ },
+      .imageArrayLayers{ 1 },
+      .imageUsage{ VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+      .preTransform{ swapChainSupportDetails_.surfaceCapabilities_.currentTransform },
+      .compositeAlpha{ VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR },
+      .presentMode{ chooseSwapPresentMode() },
+      .clipped{ VK_TRUE },
+      .oldSwapchain{ oldSwapChain }
+    };
+
+    setupSwapChainImageSharingMode( createInfo );
+
+    if( vkCreateSwapchainKHR( logicalDevice_, &createInfo, nullptr, &swapChain_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create swap chain!" };
+
+    vkGetSwapchainImagesKHR( logicalDevice_, swapChain_, &imageCount, nullptr );
+    swapChainImages_.resize( imageCount );
+    vkGetSwapchainImagesKHR( logicalDevice_, swapChain_, &imageCount, swapChainImages_.data() );
+  }
+
+  // stands in for the swap chain images, nothing is ever presented so that the frame rate is not bound to any display
+  void createOffscreenImages()
+  {
+    const auto format = findSupportedFormat( { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB },
+                                             VK_IMAGE_TILING_OPTIMAL,
+                                             VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT );
+
+    swapChainSurfaceFormat_ = VkSurfaceFormatKHR{ .format{ format }, .colorSpace{ VK_COLOR_SPACE_SRGB_NONLINEAR_KHR } };
+    swapChainExtent_ = VkExtent2D{ .width{ windowWidth_ }, .height{ windowHeight_ } };
+
+    swapChainImages_.resize( offscreenImageCount_ );
+    offscreenImageAllocations_.resize( offscreenImageCount_ );
+
+    for( std::size_t i = 0; i < offscreenImageCount_; ++i )
+      createImage( swapChainExtent_.width,
+                   swapChainExtent_.height,
+                   1,
+                   format,
+                   VK_IMAGE_TILING_OPTIMAL,
+                   VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                   swapChainImages_[ i ],
+                   offscreenImageAllocations_[ i ] );
+  }
+
+  void setupSwapChainSurfaceFormat()
+  {
+    swapChainSurfaceFormat_ = swapChainSupportDetails_.surfaceFormats_.front();
+
+    for( const auto &availableFormat : swapChainSupportDetails_.surfaceFormats_ )
+      if( availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
+      {
+        swapChainSurfaceFormat_ = availableFormat;
+        return;
+      }
+  }
+
+  // FIFO is the only mode every device supports, the fallback of every policy
+  VkPresentModeKHR chooseSwapPresentMode()
+  {
+    static constexpr VkPresentModeKHR lowLatencyPresentModes[] = { VK_PRESENT_MODE_MAILBOX_KHR };
+    static constexpr VkPresentModeKHR uncappedPresentModes[] = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+
+    std::span< const VkPresentModeKHR > presentModes;
+
+    if( options_.latencyPolicy == LatencyPolicy::lowLatency )
+      presentModes = lowLatencyPresentModes;
+    else if( options_.latencyPolicy == LatencyPolicy::uncapped )
+      presentModes = uncappedPresentModes;
+
+    // FIFO is the only mode always supported, and the only one never tearing
+    for( auto presentMode : presentModes )
+      if( std::find( swapChainSupportDetails_.presentModes_.begin(), swapChainSupportDetails_.presentModes_.end(), presentMode ) != swapChainSupportDetails_.presentModes_.end() )
+        return presentMode;
+
+    return VK_PRESENT_MODE_FIFO_KHR;
+  }
+
+  void setupSwapChainExtent()
+  {
+    const auto &capabilities = swapChainSupportDetails_.surfaceCapabilities_;
+
+    if( capabilities.currentExtent.width != std::numeric_limits< std::uint32_t >::max() )
+    {
+      swapChainExtent_ = capabilities.currentExtent;
+      return;
+    }
+
+    auto actualExtent = unpackFramebufferExtent( framebufferExtent_.load( std::memory_order_acquire ) );
+
+    actualExtent.width = std::max( capabilities.minImageExtent.width, std::min( capabilities.maxImageExtent.width, actualExtent.width ) );
+    actualExtent.height = std::max( capabilities.minImageExtent.height, std::min( capabilities.maxImageExtent.height, actualExtent.height ) );
+
+    swapChainExtent_ = actualExtent;
+  }
+
+  void createSurface()
+  {
+    if( isHeadless() )
+      return;
+
+    if( glfwCreateWindowSurface( vulkanInstance_, window_, nullptr, &surface_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create window surface!" };
+  }
+
+  auto getAllDeviceQueueCreateInfo()
+  {
+    std::vector< VkDeviceQueueCreateInfo > allQueueCreateInfo;
+
+    float queuePriorities[] = { 1.0f };
+
+    for( std::uint32_t queueFamilyIndex : requiredQueueFamilyIndices_.toSet() )
+      allQueueCreateInfo.emplace_back( VkDeviceQueueCreateInfo
+                                       {
+                                         .sType{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO },
+                                         .queueFamilyIndex{ queueFamilyIndex },
+                                         .queueCount{ 1 }, // as today
+                                         .pQueuePriorities{ queuePriorities }
+                                       } );
+    return allQueueCreateInfo;
+  }
+
+  static std::vector< VkExtensionProperties > getAvailableDeviceExtensions( VkPhysicalDevice device )
+  {
+    std::uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, nullptr );
+
+    std::vector< VkExtensionProperties > availableExtensions( extensionCount );
+    vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, availableExtensions.data() );
+
+    return availableExtensions;
+  }
+
+  static bool isDeviceExtensionAvailable( std::span< const VkExtensionProperties > availableExtensions, std::string_view extension )
+  {
+    return std::any_of( availableExtensions.begin(),
+                        availableExtensions.end(),
+                        [ &extension ]( const VkExtensionProperties &properties ) { return extension == properties.extensionName; } );
+  }
+
+#ifdef VK_KHR_present_wait
+  bool isDeviceSupportingPresentWait( VkPhysicalDevice device ) const
+  {
+    const auto availableExtensions = getAvailableDeviceExtensions( device );
+
+    for( std::string_view extension : { VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME } )
+      if( !isDeviceExtensionAvailable( availableExtensions, extension ) )
+        return false;
+
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{ .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR } };
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{ .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR }, .pNext{ &presentWaitFeatures } };
+    VkPhysicalDeviceFeatures2 features{ .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 }, .pNext{ &presentIdFeatures } };
+
+    vkGetPhysicalDeviceFeatures2( device, &features );
+
+    return presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+  }
+#endif // VK_KHR_present_wait
+
+  bool isDeviceSupportingMemoryBudget( VkPhysicalDevice device ) const
+  {
+    return isDeviceExtensionAvailable( getAvailableDeviceExtensions( device ), VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+  }
+
+  // present wait and memory budget are optional, frames are paced on their fences only and the budget is estimated without them
+  void createLogicalDevice()
+  {
+    auto allQueueCreateInfo = getAllDeviceQueueCreateInfo();
+
+    const auto requiredExtensions = getRequiredDeviceExtensions();
+    std::vector< const char * > enabledExtensions( requiredExtensions.begin(), requiredExtensions.end() );
+    void *enabledFeatures = &requiredVulkan12Features_;
+
+#ifdef VK_KHR_present_wait
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures
+    {
+      .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR },
+      .pNext{ &requiredVulkan12Features_ },
+      .presentWait{ VK_TRUE }
+    };
+
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures
+    {
+      .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR },
+      .pNext{ &presentWaitFeatures },
+      .presentId{ VK_TRUE }
+    };
+
+    const bool isPresentWaitEnabled = !isHeadless() && isDeviceSupportingPresentWait( physicalDevice_ );
+
+    if( isPresentWaitEnabled )
+    {
+      enabledExtensions.push_back( VK_KHR_PRESENT_ID_EXTENSION_NAME );
+      enabledExtensions.push_back( VK_KHR_PRESENT_WAIT_EXTENSION_NAME );
+      enabledFeatures = &presentIdFeatures;
+    }
+#endif // VK_KHR_present_wait
+
+    isMemoryBudgetEnabled_ = isDeviceSupportingMemoryBudget( physicalDevice_ );
+
+    if( isMemoryBudgetEnabled_ )
+      enabledExtensions.push_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+
+    VkDeviceCreateInfo deviceCreateInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO },
+      .pNext{ enabledFeatures },
+      .queueCreateInfoCount{ static_cast< std::uint32_t >( allQueueCreateInfo.size() ) },
+      .pQueueCreateInfos{ allQueueCreateInfo.data() },
+      .enabledLayerCount{ 0 },
+      .enabledExtensionCount{ static_cast< std::uint32_t >( enabledExtensions.size() ) },
+      .ppEnabledExtensionNames{ enabledExtensions.data() },
+      .pEnabledFeatures{ &requiredPhysicalDeviceFeatures_ }
+    };
+
+    if( IsVulkanValidationEnabled() )
+    {
+      deviceCreateInfo.enabledLayerCount = static_cast< std::uint32_t >( vulkanValidationLayers_.size() );
+      deviceCreateInfo.ppEnabledLayerNames = vulkanValidationLayers_.data();
+    }
+
+    if( vkCreateDevice( physicalDevice_, &deviceCreateInfo, nullptr, &logicalDevice_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create logical device!" };
+
+#ifdef VK_KHR_present_wait
+    if( isPresentWaitEnabled )
+      waitForPresent_ = reinterpret_cast< PFN_vkWaitForPresentKHR >( vkGetDeviceProcAddr( logicalDevice_, "vkWaitForPresentKHR" ) );
+#endif // VK_KHR_present_wait
+
+    vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(), 0, &graphicsQueue_ );
+    vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.presentationQueueFamilyIndex.value(), 0, &presentationQueue_ );
+    vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value(), 0, &transfertQueue_ );
+
+    if( isCullingAsynchronous() )
+      vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.computeQueueFamilyIndex.value(), 0, &computeQueue_ );
+  }
+
+  // discrete GPUs first, then the one with the most device local memory, then the one with the largest limits
+  static auto getPhysicalDeviceRank( VkPhysicalDevice device )
+  {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties( device, &properties );
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties( device, &memoryProperties );
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    VkDeviceSize deviceLocalHeapSize{};
 
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo
+    for( std::uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i )
+      if( memoryProperties.memoryHeaps[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
+        deviceLocalHeapSize += memoryProperties.memoryHeaps[ i ].size;
+
+    int typeRank{};
+
+    switch( properties.deviceType )
     {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO },
-      .vertexBindingDescriptionCount{ 1 },
-      .pVertexBindingDescriptions{ &bindingDescription },
-      .vertexAttributeDescriptionCount{ static_cast< std::uint32_t >( attributeDescriptions.size() ) },
-      .pVertexAttributeDescriptions{ attributeDescriptions.data() }
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      typeRank = 4;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      typeRank = 3;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+      typeRank = 2;
+      break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      typeRank = 1;
+      break;
+    default:
+      break;
+    }
+
+    return std::make_tuple( typeRank, deviceLocalHeapSize, properties.limits.maxImageDimension2D, properties.limits.maxComputeSharedMemorySize );
+  }
+
+  // an index in the enumeration order when made of digits only, a part of the device name otherwise
+  static bool isPhysicalDeviceSelected( VkPhysicalDevice device, std::size_t deviceIndex, std::string_view selector )
+  {
+    if( !selector.empty() && std::all_of( selector.begin(), selector.end(), []( char c ) { return c >= '0' && c <= '9'; } ) )
+      return std::to_string( deviceIndex ) == selector;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties( device, &properties );
+
+    return std::string_view{ properties.deviceName }.find( selector ) != std::string_view::npos;
+  }
+
+  void pickPhysicalDevice()
+  {
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices( vulkanInstance_, &deviceCount, nullptr );
+
+    if( deviceCount == 0 )
+      throw std::runtime_error{ "Error when attempting to find GPUs with Vulkan support!" };
+
+    std::vector< VkPhysicalDevice > devices{ deviceCount };
+    vkEnumeratePhysicalDevices( vulkanInstance_, &deviceCount, devices.data() );
+
+    for( std::size_t i = 0; i < devices.size(); ++i )
+    {
+      if( options_.physicalDeviceSelector.has_value() && !isPhysicalDeviceSelected( devices[ i ], i, options_.physicalDeviceSelector.value() ) )
+        continue;
+
+      if( isPhysicalDeviceSuitable( devices[ i ] )
+          && ( physicalDevice_ == VK_NULL_HANDLE || getPhysicalDeviceRank( devices[ i ] ) > getPhysicalDeviceRank( physicalDevice_ ) ) )
+        physicalDevice_ = devices[ i ];
+    }
+
+    if( physicalDevice_ == VK_NULL_HANDLE && options_.physicalDeviceSelector.has_value() )
+      throw std::runtime_error{ "Error failed to find a suitable GPU matching " + options_.physicalDeviceSelector.value() + "!" };
+
+    if( physicalDevice_ == VK_NULL_HANDLE )
+      throw std::runtime_error{ "Error failed to find a suitable GPU!" };
+
+    // the queue families and the swap chain support left over are those of the last device checked
+    isPhysicalDeviceSuitable( physicalDevice_ );
+
+    VkPhysicalDeviceProperties2 properties
+    {
+      .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 },
+      .pNext{ &physicalDeviceVulkan12Properties_ }
+    };
+
+    vkGetPhysicalDeviceProperties2( physicalDevice_, &properties );
+    physicalDeviceProperties_ = properties.properties;
+    msaaSamples_ = chooseSampleCount();
+
+    std::cout << "using " << physicalDeviceProperties_.deviceName
+              << ( isQueueFamilyOwnershipTransferRequired() ? ", dedicated transfert queue" : "" )
+              << ( isCullingAsynchronous() ? ", asynchronous compute queue" : "" ) << std::endl;
+  }
+
+  template< typename Features, std::size_t N >
+  static bool areRequiredFeaturesSupported( const Features &requiredFeatures, const Features &actualFeatures, const std::size_t( &featureOffsets )[ N ] )
+  {
+    auto packedRequiredFeatures = &reinterpret_cast< char const volatile & >( requiredFeatures );
+    auto packedActualFeatures = &reinterpret_cast< char const volatile & >( actualFeatures );
+
+    for( auto &&offset : featureOffsets )
+    {
+      auto required = *( packedRequiredFeatures + offset );
+      auto actual = *( packedActualFeatures + offset );
+
+      if( required && !actual )
+        return false;
+    }
+
+    return true;
+  }
+
+  bool isDeviceSupportingRequiredFeatures( VkPhysicalDevice device )
+  {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties( device, &properties );
+
+    // Vulkan 1.2 features cannot be queried from an older device
+    if( properties.apiVersion < VK_API_VERSION_1_2 )
+      return false;
+
+    VkPhysicalDeviceVulkan12Features actualVulkan12Features
+    {
+      .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES }
+    };
+
+    VkPhysicalDeviceFeatures2 actualFeatures
+    {
+      .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 },
+      .pNext{ &actualVulkan12Features }
+    };
+
+    vkGetPhysicalDeviceFeatures2( device, &actualFeatures );
+
+    return areRequiredFeaturesSupported( requiredPhysicalDeviceFeatures_, actualFeatures.features, requiredPhysicalDeviceFeatureOffsets_ )
+      && areRequiredFeaturesSupported( requiredVulkan12Features_, actualVulkan12Features, requiredVulkan12FeatureOffsets_ );
+  }
+
+  template< typename Features, std::size_t N >
+  static void enableRequiredFeatures( Features &features, const std::size_t( &featureOffsets )[ N ] )
+  {
+    auto packedFeatures = &reinterpret_cast< char volatile & >( features );
+
+    for( auto &&offset : featureOffsets )
+      *( packedFeatures + offset ) = VkBool32{ VK_TRUE };
+  }
+
+  void setupRequiredFeaturesForPhysicalDevice( VkPhysicalDevice device )
+  {
+    enableRequiredFeatures( requiredPhysicalDeviceFeatures_, requiredPhysicalDeviceFeatureOffsets_ );
+    enableRequiredFeatures( requiredVulkan12Features_, requiredVulkan12FeatureOffsets_ );
+  }
+
+  bool isPhysicalDeviceSuitable( VkPhysicalDevice device )
+  {
+    setupRequiredQueueFamiliesForPhysicalDevice( device );
+    setupRequiredFeaturesForPhysicalDevice( device );
+
+    if( !isHeadless() )
+      setupSwapChainSupportForPhysicalDevice( device );
+
+    return ( requiredQueueFamilyIndices_.isComplete()
+             && isDeviceSupportingRequiredExtensions( device )
+             && ( isHeadless() || swapChainSupportDetails_.isComplete() )
+             && isDeviceSupportingRequiredFeatures( device ) );
+  }
+
+  void setupSwapChainSupportForPhysicalDevice( VkPhysicalDevice device )
+  {
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR( device, surface_, &swapChainSupportDetails_.surfaceCapabilities_ );
+
+    std::uint32_t formatCount;
+    vkGetPhysicalDeviceSurfaceFormatsKHR( device, surface_, &formatCount, nullptr );
+
+    if( formatCount != 0 )
+    {
+      swapChainSupportDetails_.surfaceFormats_.resize( formatCount );
+      vkGetPhysicalDeviceSurfaceFormatsKHR( device, surface_, &formatCount, swapChainSupportDetails_.surfaceFormats_.data() );
+    }
+
+    std::uint32_t presentModeCount;
+    vkGetPhysicalDeviceSurfacePresentModesKHR( device, surface_, &presentModeCount, nullptr );
+
+    if( presentModeCount != 0 )
+    {
+      swapChainSupportDetails_.presentModes_.resize( presentModeCount );
+      vkGetPhysicalDeviceSurfacePresentModesKHR( device, surface_, &presentModeCount, swapChainSupportDetails_.presentModes_.data() );
+    }
+  }
+
+  bool isDeviceSupportingRequiredExtensions( VkPhysicalDevice device )
+  {
+    const auto availableExtensions = getAvailableDeviceExtensions( device );
+
+    for( std::string_view extension : getRequiredDeviceExtensions() )
+      if( !isDeviceExtensionAvailable( availableExtensions, extension ) )
+        return false;
+
+    return true;
+  }
+
+  // the first family having all the required capabilities and none of the excluded ones
+  static std::optional< std::uint32_t > findQueueFamily( std::span< const VkQueueFamilyProperties > queueFamilies, VkQueueFlags requiredFlags, VkQueueFlags excludedFlags )
+  {
+    for( std::uint32_t i = 0; i < queueFamilies.size(); ++i )
+      if( ( queueFamilies[ i ].queueFlags & requiredFlags ) == requiredFlags && ( queueFamilies[ i ].queueFlags & excludedFlags ) == 0 )
+        return i;
+
+    return std::nullopt;
+  }
+
+  bool hasPresentationSupport( VkPhysicalDevice device, const VkQueueFamilyProperties &queueFamily, std::uint32_t queueFamilyIndex ) const
+  {
+    // without surface, the presentation queue is a mere alias of the graphics one, it is never used
+    if( isHeadless() )
+      return ( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ) != 0;
+
+    VkBool32 isSupported = false;
+    vkGetPhysicalDeviceSurfaceSupportKHR( device, queueFamilyIndex, surface_, &isSupported );
+
+    return isSupported;
+  }
+
+  // Transfers and culling go to families of their own when the device has some, running alongside the graphic queue: a transfer only family
+  // is the copy engine, a compute family without graphics is the asynchronous compute one. Otherwise the graphics family does it all
+  void setupRequiredQueueFamiliesForPhysicalDevice( VkPhysicalDevice device )
+  {
+    std::uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties( device, &queueFamilyCount, nullptr );
+
+    std::vector< VkQueueFamilyProperties > queueFamilies{ queueFamilyCount };
+    vkGetPhysicalDeviceQueueFamilyProperties( device, &queueFamilyCount, queueFamilies.data() );
+
+    requiredQueueFamilyIndices_ = {};
+    requiredQueueFamilyIndices_.graphicsQueueFamilyIndex = findQueueFamily( queueFamilies, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0 );
+
+    if( !requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.has_value() )
+      return;
+
+    const auto graphicsQueueFamilyIndex = requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value();
+
+    // presenting from the graphics family spares an ownership transfer of the swap chain images
+    if( hasPresentationSupport( device, queueFamilies[ graphicsQueueFamilyIndex ], graphicsQueueFamilyIndex ) )
+      requiredQueueFamilyIndices_.presentationQueueFamilyIndex = graphicsQueueFamilyIndex;
+    else
+      for( std::uint32_t i = 0; i < queueFamilies.size() && !requiredQueueFamilyIndices_.presentationQueueFamilyIndex.has_value(); ++i )
+        if( hasPresentationSupport( device, queueFamilies[ i ], i ) )
+          requiredQueueFamilyIndices_.presentationQueueFamilyIndex = i;
+
+    // graphics families always support transfers, even when they do not tell
+    requiredQueueFamilyIndices_.transfertQueueFamilyIndex = findQueueFamily( queueFamilies, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT )
+      .value_or( findQueueFamily( queueFamilies, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT ).value_or( graphicsQueueFamilyIndex ) );
+
+    requiredQueueFamilyIndices_.computeQueueFamilyIndex = findQueueFamily( queueFamilies, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT );
+  }
+
+  // culling is either dispatched in the draw command buffers or submitted on its own queue, the draws waiting on it
+  bool isCullingAsynchronous() const noexcept
+  {
+    return requiredQueueFamilyIndices_.computeQueueFamilyIndex.has_value();
+  }
+
+  void setupDebugMessenger()
+  {
+    if( !IsVulkanValidationEnabled() )
+      return;
+
+    VkDebugUtilsMessengerCreateInfoEXT createInfos
+    {
+      .sType{ VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT },
+      .messageSeverity{ VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+                         VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+                         VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT },
+      .messageType{ VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                     VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                     VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT },
+      .pfnUserCallback{ debugCallback },
+      .pUserData{ nullptr }
+    };
+
+    if( createDebugUtilsMessengerEXT( vulkanInstance_, &createInfos, nullptr, &debugMessenger_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error while setup the debug messenger" };
+  }
+
+  void appendProductionExtensionsIn( std::vector< const char * > &extensions )
+  {
+    // glfw is not even initialized without window
+    if( isHeadless() )
+      return;
+
+    uint32_t glfwExtensionCount = 0u;
+    auto rawGlfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+
+    if( rawGlfwExtensions == nullptr )
+      throw std::runtime_error{ "Error while querying glfw required vulkan extensions" };
+
+    for( std::size_t i = 0; i < glfwExtensionCount; ++i )
+      extensions.push_back( rawGlfwExtensions[ i ] );
+  }
+
+  void appendValidationExtensionsIn( std::vector< const char * > &extensions )
+  {
+    std::for_each( std::cbegin( vulkanValidationExtensions_ ),
+                   std::cend( vulkanValidationExtensions_ ),
+                   [ &extensions ]( const char *const &extensionName ) mutable { extensions.push_back( extensionName ); } );
+  }
+
+  auto getEnabledExtensions()
+  {
+    std::vector< const char *> enabledExtensions;
+
+    appendProductionExtensionsIn( enabledExtensions );
+
+    if( IsVulkanValidationEnabled() )
+      appendValidationExtensionsIn( enabledExtensions );
+
+    return enabledExtensions;
+  }
+
+  auto getEnabledLayers()
+  {
+    std::vector< const char * > enabledLayers;
+
+    if( IsVulkanValidationEnabled() )
+      std::for_each( std::cbegin( vulkanValidationLayers_ ),
+                     std::cend( vulkanValidationLayers_ ),
+                     [ &enabledLayers ]( const char *const &layerName ) mutable { enabledLayers.push_back( layerName ); } );
+
+    return enabledLayers;
+  }
+
+  void createInstance()
+  {
+    VkApplicationInfo appInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_APPLICATION_INFO },
+      .pApplicationName{ "Hello Triangle" },
+      .applicationVersion{ VK_MAKE_VERSION( 1, 0, 0 ) },
+      .pEngineName{ "No Engine" },
+      .engineVersion{ VK_MAKE_VERSION( 0, 0, 0 ) },
+      .apiVersion{ VK_API_VERSION_1_2 }
     };
 
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly
-    {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO },
-      .topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST },
-      .primitiveRestartEnable{ VK_FALSE }
-    };
+    auto enabledExtensions = getEnabledExtensions();
+    auto enabledLayers = getEnabledLayers();
 
-    VkViewport viewports[]
+    VkInstanceCreateInfo instanceInfo
     {
-      {
-        .x{ 0.0f },
-        .y{ 0.0f },
-        .width{ static_cast< float >( swapChainExtent_.width ) },
-        .height{ static_cast< float >( swapChainExtent_.height ) },
-        .minDepth{ 0.0f },
-        .maxDepth{ 1.0f },
-      }
+      .sType{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO },
+      .pApplicationInfo{ &appInfo },
+      .enabledLayerCount{ static_cast< std::uint32_t >( enabledLayers.size() ) },
+      .ppEnabledLayerNames{ enabledLayers.data() },
+      .enabledExtensionCount{ static_cast< std::uint32_t >( enabledExtensions.size() ) },
+      .ppEnabledExtensionNames{ enabledExtensions.data() }
     };
 
-    VkRect2D scissors[]
-    {
-      {
-        .offset{ 0, 0 },
-        .extent{ swapChainExtent_ }
-      }
-    };
+    if( vkCreateInstance( &instanceInfo, nullptr, &vulkanInstance_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error while creating vulkan instance" };
+  }
 
-    VkPipelineViewportStateCreateInfo viewportState
-    {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO },
-      .viewportCount{ sizeof( viewports ) / sizeof( VkViewport ) },
-      .pViewports{ viewports },
-      .scissorCount{ sizeof( scissors ) / sizeof( VkRect2D ) },
-      .pScissors{ scissors },
-    };
+  void checkValidationSupport()
+  {
+    checkSupportedValidationLayers();
+    checkSupportedValidationExtensions();
+  }
 
-    VkPipelineRasterizationStateCreateInfo rasterizer
-    {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO },
-      .depthClampEnable{ VK_FALSE },
-      .rasterizerDiscardEnable{ VK_FALSE },
-      .polygonMode{ VK_POLYGON_MODE_FILL },
-      .cullMode{ VK_CULL_MODE_BACK_BIT },
-      .frontFace{ VK_FRONT_FACE_COUNTER_CLOCKWISE },
-      .depthBiasEnable{ VK_FALSE },
-      .depthBiasConstantFactor{ 0.0f }, // Optional
-      .depthBiasClamp{ 0.0f }, // Optional
-      .depthBiasSlopeFactor{ 0.0f }, // Optional
-      .lineWidth{ 1.0f },
-    };
+  void checkSupportedValidationLayers()
+  {
+    if( !IsVulkanValidationEnabled() )
+      return;
 
-    VkPipelineMultisampleStateCreateInfo multisampling
-    {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO },
-      .rasterizationSamples{ VK_SAMPLE_COUNT_1_BIT },
-      .sampleShadingEnable{ VK_FALSE },
-      .minSampleShading{ 1.0f }, // Optional
-      .pSampleMask{ nullptr }, // Optional
-      .alphaToCoverageEnable{ VK_FALSE }, // Optional
-      .alphaToOneEnable{ VK_FALSE }, // Optional
-    };
+    std::uint32_t availableLayerCount = 0u;
 
-    VkPipelineColorBlendAttachmentState colorBlendAttachments[]
+    if( vkEnumerateInstanceLayerProperties( &availableLayerCount, nullptr ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error while counting vulkan instance available layers" };
+
+    std::vector< VkLayerProperties > instanceLayers{ availableLayerCount };
+
+    if( vkEnumerateInstanceLayerProperties( &availableLayerCount, instanceLayers.data() ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error while querying vulkan instance available layers" };
+
+    std::for_each( std::cbegin( vulkanValidationLayers_ ),
+                   std::cend( vulkanValidationLayers_ ),
+                   [ &instanceLayers ]( std::string_view validationLayer )
     {
+      if( std::find_if( std::cbegin( instanceLayers ),
+                        std::cend( instanceLayers ),
+                        [ &validationLayer ]( const VkLayerProperties &layerProperties )
       {
-        .blendEnable{ VK_FALSE },
-        .srcColorBlendFactor{ VK_BLEND_FACTOR_ONE }, // Optional
-        .dstColorBlendFactor{ VK_BLEND_FACTOR_ZERO }, // Optional
-        .colorBlendOp{ VK_BLEND_OP_ADD }, // Optional
-        .srcAlphaBlendFactor{ VK_BLEND_FACTOR_ONE }, // Optional
-        .dstAlphaBlendFactor{ VK_BLEND_FACTOR_ZERO }, // Optional
-        .alphaBlendOp{ VK_BLEND_OP_ADD }, // Optional
-        .colorWriteMask{ VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT }
-      }
-    };
+        return validationLayer.compare( layerProperties.layerName ) == 0;
+      } ) == std::cend( instanceLayers ) )
+        throw std::runtime_error{ "Error while querying for unsupported required validation layer" };
+    } );
+  }
 
-    VkPipelineColorBlendStateCreateInfo colorBlending
-    {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO },
-      .logicOpEnable{ VK_FALSE },
-      .logicOp{ VK_LOGIC_OP_COPY }, // Optional
-      .attachmentCount{ sizeof( colorBlendAttachments ) / sizeof( VkPipelineColorBlendAttachmentState ) },
-      .pAttachments{ colorBlendAttachments },
-      .blendConstants{ 0.0f, 0.0f, 0.0f, 0.0f }
-    };
+  void checkSupportedValidationExtensions()
+  {
+    if( !IsVulkanValidationEnabled() )
+      return;
+
+    std::uint32_t availableExtensionCount = 0u;
+
+    if( vkEnumerateInstanceExtensionProperties( nullptr, &availableExtensionCount, nullptr ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error while counting vulkan instance available extensions" };
 
-    auto [vertexShaderModule, fragmentShaderModule] = getShaderModules();
+    std::vector<VkExtensionProperties> instanceExtensions{ availableExtensionCount };
+
+    if( vkEnumerateInstanceExtensionProperties( nullptr, &availableExtensionCount, instanceExtensions.data() ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error while querying vulkan instance available extensions" };
 
-    VkPipelineShaderStageCreateInfo vertexShaderStageInfo
+    std::for_each( std::cbegin( vulkanValidationExtensions_ ),
+                   std::cend( vulkanValidationExtensions_ ),
+                   [ &instanceExtensions ]( std::string_view validationExtension )
     {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO },
-      .stage{ VK_SHADER_STAGE_VERTEX_BIT },
-      .module{ vertexShaderModule },
-      .pName{ "main" }
-    };
+      if( std::find_if( std::cbegin( instanceExtensions ),
+                        std::cend( instanceExtensions ),
+                        [ &validationExtension ]( const VkExtensionProperties &extensionProperties )
+      {
+        return validationExtension.compare( extensionProperties.extensionName ) == 0;
+      } ) == std::cend( instanceExtensions ) )
+        throw std::runtime_error{ "Error while querying for unsupported required validation extension" };
+    } );
+  }
 
-    VkPipelineShaderStageCreateInfo fragmentShaderStageInfo
+  void mainLoop()
+  {
+    if( isHeadless() )
     {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO },
-      .stage{ VK_SHADER_STAGE_FRAGMENT_BIT },
-      .module{ fragmentShaderModule },
-      .pName{ "main" }
-    };
+      runBenchmark();
+      return;
+    }
 
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
+    runFramePipeline( [ this ] { simulateWindowFrames(); } );
 
-    VkPipelineDepthStencilStateCreateInfo depthStencilInfo
+    vkDeviceWaitIdle( logicalDevice_ );
+
+    exportProfile();
+  }
+
+  // the window is serviced even while the frame stages are behind, a frame is only simulated once there is room for it. A minimized window
+  // stalls them until it is restored or closed
+  void simulateWindowFrames()
+  {
+    while( glfwWindowShouldClose( window_ ) != GLFW_TRUE )
     {
-      .sType{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO },
-      .depthTestEnable{ VK_TRUE },
-      .depthWriteEnable{ VK_TRUE },
-      .depthCompareOp{ VK_COMPARE_OP_LESS },
-      .depthBoundsTestEnable{ VK_FALSE },
-      .stencilTestEnable{ VK_FALSE },
-      .front{}, // Optional
-      .back{}, // Optional
-      .minDepthBounds{ 0.0f }, // Optional
-      .maxDepthBounds{ 1.0f } // Optional
-    };
+      glfwPollEvents();
+      publishFramebufferExtent();
+
+      if( simulatedFrames_.isCancelled() )
+        return;
 
-    VkGraphicsPipelineCreateInfo pipelinesInfo[]
-    {
-      {
-        .sType{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO },
-        .stageCount{ sizeof( shaderStages ) / sizeof( VkPipelineShaderStageCreateInfo ) },
-        .pStages{ shaderStages },
-        .pVertexInputState{ &vertexInputInfo },
-        .pInputAssemblyState{ &inputAssembly },
-        .pViewportState{ &viewportState },
-        .pRasterizationState{ &rasterizer },
-        .pMultisampleState{ &multisampling },
-        .pDepthStencilState{ &depthStencilInfo },
-        .pColorBlendState{ &colorBlending },
-        .pDynamicState{ nullptr }, // Optional
-        .layout{ pipelineLayout_ },
-        .renderPass{ renderPass_ },
-        .subpass{ 0 },
-        .basePipelineHandle{ VK_NULL_HANDLE }, // Optional
-        .basePipelineIndex{ -1 } // Optional
+      if( simulatedFrames_.isFull() )
+      {
+        glfwWaitEventsTimeout( simulationRetryTimeout_ );
+        continue;
       }
-    };
 
-    graphicPipelines_.resize( sizeof( pipelinesInfo ) / sizeof( VkGraphicsPipelineCreateInfo ) );
+      updateWindowTitleWithFrameTimes();
 
-    if( vkCreateGraphicsPipelines( logicalDevice_, VK_NULL_HANDLE, 1, pipelinesInfo, nullptr, graphicPipelines_.data() ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create graphics pipeline!" };
+      // cancelled meanwhile only, the room left cannot be taken by anyone else
+      if( !simulatedFrames_.push( simulateFrame() ) )
+        return;
+    }
 
-    vkDestroyShaderModule( logicalDevice_, fragmentShaderModule, nullptr );
-    vkDestroyShaderModule( logicalDevice_, vertexShaderModule, nullptr );
+    publishWindowClosed();
+    simulatedFrames_.push( SimulatedFrame{ .isLast{ true } } );
   }
 
-  VkShaderModule createShaderModule( std::vector< char > &&code )
+  void simulateBenchmarkFrames( std::uint32_t frameCount )
   {
-    VkShaderModuleCreateInfo createInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO },
-      .codeSize{ code.size() },
-      .pCode{ reinterpret_cast< const uint32_t * >( code.data() ) }
-    };
-
-    VkShaderModule shaderModule;
-    if( vkCreateShaderModule( logicalDevice_, &createInfo, nullptr, &shaderModule ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create shader module!" };
+    for( std::uint32_t i = 0; i < frameCount; ++i )
+      if( !simulatedFrames_.push( simulateFrame() ) )
+        return;
 
-    return shaderModule;
+    simulatedFrames_.push( SimulatedFrame{ .isLast{ true } } );
   }
 
-  void createImageView( VkImage image, VkImageView *targetImageView, VkFormat format, VkImageAspectFlags aspectFlags )
+  SimulatedFrame simulateFrame()
   {
-    VkImageViewCreateInfo createInfo
+    const float time = getAnimationTime( simulatedFrameCount_++ );
+    const auto cameraPosition = getCameraPosition( time );
+
+    return SimulatedFrame
     {
-      .sType{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO },
-      .image{ image },
-      .viewType{ VK_IMAGE_VIEW_TYPE_2D },
-      .format{ format },
-      .components
+      .animationTime{ time },
+      .cameraPosition{ cameraPosition },
+      .view
       {
-        .r{ VK_COMPONENT_SWIZZLE_IDENTITY },
-        .g{ VK_COMPONENT_SWIZZLE_IDENTITY },
-        .b{ VK_COMPONENT_SWIZZLE_IDENTITY },
-        .a{ VK_COMPONENT_SWIZZLE_IDENTITY }
+        glm::lookAt( cameraPosition,
+                     glm::vec3( 0.0f, 0.0f, 0.0f ),
+                     glm::vec3( 0.0f, 0.0f, 1.0f ) )
       },
-      .subresourceRange
+      .isDepthPrePassEnabled{ requestedDepthPrePass_ }
+    };
+  }
+
+  // The calling thread simulates, a recording and a submission thread take the frames over through single producer single consumer rings:
+  // simulation -> submission (acquisition) -> recording -> submission (submission then presentation). A failing stage cancels every ring
+  template< typename Simulate >
+  void runFramePipeline( Simulate &&simulate )
+  {
+    std::vector< std::exception_ptr > errors( 3 );
+
+    const auto runStage = [ this ]( auto &&stage, std::exception_ptr &error )
+    {
+      try
       {
-        .aspectMask{ aspectFlags },
-        .baseMipLevel{ 0 },
-        .levelCount{ 1 },
-        .baseArrayLayer{ 0 },
-        .layerCount{ 1 }
+        stage();
+      }
+      catch( ... )
+      {
+        error = std::current_exception();
+        cancelFramePipeline();
       }
     };
 
-    if( vkCreateImageView( logicalDevice_, &createInfo, nullptr, targetImageView ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create image views!" };
+    std::thread recordingThread{ runStage, [ this ] { recordFrames(); }, std::ref( errors[ 1 ] ) };
+    std::thread submissionThread{ runStage, [ this ] { submitFrames(); }, std::ref( errors[ 2 ] ) };
+
+    runStage( simulate, errors[ 0 ] );
+
+    recordingThread.join();
+    submissionThread.join();
+
+    for( auto &&error : errors )
+      if( error )
+        std::rethrow_exception( error );
   }
 
-  void createImageViews()
+  void cancelFramePipeline() noexcept
   {
-    swapChainImageViews_.resize( swapChainImages_.size() );
+    simulatedFrames_.cancel();
+    frameRecordings_.cancel();
+    recordedFrames_.cancel();
+  }
 
-    for( std::size_t i = 0; i < swapChainImages_.size(); ++i )
-      createImageView( swapChainImages_[ i ], &swapChainImageViews_[ i ], swapChainSurfaceFormat_.format, VK_IMAGE_ASPECT_COLOR_BIT );
+  void runBenchmark()
+  {
+    finishAssetStreaming();
+
+    const auto frameCount = options_.benchmarkFrameCount.value();
+    const auto begin = Profiler::Clock::now();
+
+    runFramePipeline( [ this, frameCount ] { simulateBenchmarkFrames( frameCount ); } );
+
+    vkDeviceWaitIdle( logicalDevice_ );
+
+    const std::chrono::duration< double > elapsed = Profiler::Clock::now() - begin;
+
+    exportProfile();
+
+    std::cout << std::fixed << std::setprecision( 2 )
+              << "benchmark " << frameCount << " frames in " << elapsed.count() << " s, "
+              << frameCount / elapsed.count() << " frames/s, "
+              << "peak device memory " << memoryAllocator_.getPeakDeviceMemorySize() / ( 1024.0 * 1024.0 ) << " MiB" << std::endl;
   }
 
-  void setupSwapChainImageSharingMode( VkSwapchainCreateInfoKHR &createInfo )
+  void synchronizeFrames( std::uint32_t imageIndex )
   {
-    uint32_t queueFamilyIndices[]
-    {
-      requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(),
-      requiredQueueFamilyIndices_.presentationQueueFamilyIndex.value()
-    };
+    // Check if a previous frame is using this image (i.e. there is its fence to wait on)
+    if( inFlightImageFences_[ imageIndex ] != VK_NULL_HANDLE )
+      vkWaitForFences( logicalDevice_, 1, &inFlightImageFences_[ imageIndex ], VK_TRUE, std::numeric_limits< std::uint64_t >::max() );
 
-    if( requiredQueueFamilyIndices_.graphicsQueueFamilyIndex != requiredQueueFamilyIndices_.presentationQueueFamilyIndex )
-    {
-      createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-      createInfo.queueFamilyIndexCount = 2;
-      createInfo.pQueueFamilyIndices = queueFamilyIndices;
-    }
-    else
-    {
-      createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      createInfo.queueFamilyIndexCount = 0; // Optional
-      createInfo.pQueueFamilyIndices = nullptr; // Optional
-    }
+    // Mark the image as now being in use by this frame
+    inFlightImageFences_[ imageIndex ] = inFlightFences_[ currentFrame_ ];
+  }
+
+  std::optional< std::uint32_t > acquireNextImage()
+  {
+    std::uint32_t imageIndex{};
+    auto acquireNextResult = vkAcquireNextImageKHR( logicalDevice_,
+                                                    swapChain_,
+                                                    std::numeric_limits< std::uint64_t >::max(),
+                                                    imageAvailableSemaphore_[ currentFrame_ ],
+                                                    VK_NULL_HANDLE,
+                                                    &imageIndex );
+
+    // the semaphore has not been signaled, it is waited on by the acquisition from the new swap chain instead
+    if( acquireNextResult == VK_ERROR_OUT_OF_DATE_KHR )
+      return recreateSwapChain() ? acquireNextImage() : std::nullopt;
+    else if( acquireNextResult != VK_SUCCESS && acquireNextResult != VK_SUBOPTIMAL_KHR )
+      throw std::runtime_error{ "Error failed to acquire swap chain image!" };
+
+    synchronizeFrames( imageIndex );
+
+    return imageIndex;
   }
 
-  auto getRelevantSwapChainImageCount()
+  // offscreen images are simply used in turn, waiting on the fence of the frame that last rendered in it
+  auto acquireNextOffscreenImage()
   {
-    std::uint32_t imageCount = swapChainSupportDetails_.surfaceCapabilities_.minImageCount + 1;
-
-    if( swapChainSupportDetails_.surfaceCapabilities_.maxImageCount > 0 && imageCount > swapChainSupportDetails_.surfaceCapabilities_.maxImageCount )
-      imageCount = swapChainSupportDetails_.surfaceCapabilities_.maxImageCount;
+    const auto imageIndex = static_cast< std::uint32_t >( profiler_.getFrameIndex() % swapChainImages_.size() );
 
-    // use all the swap chain capacity, dunno if it is a good idea yet
-    maxFrameInFlight_ = swapChainSupportDetails_.surfaceCapabilities_.maxImageCount;
+    synchronizeFrames( imageIndex );
 
-    return imageCount;
+    return imageIndex;
   }
 
-  void createSwapChain()
+  // right after the submission of its frame, an out of date swap chain is recreated before the next image is acquired
+  void submitPresentationQueue( const PendingPresentation &presentation )
   {
-    setupSwapChainSurfaceFormat();
-    setupSwapChainExtent();
+    VkSemaphore waitSemaphores[] = { renderFinishedSemaphore_[ presentation.frameSlot ] };
+    VkSwapchainKHR swapChains[] = { swapChain_ };
+    VkPresentInfoKHR presentInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR },
+      .waitSemaphoreCount{ sizeof( waitSemaphores ) / sizeof( VkSemaphore ) },
+      .pWaitSemaphores{ waitSemaphores },
+      .swapchainCount{ sizeof( swapChains ) / sizeof( VkSwapchainKHR ) },
+      .pSwapchains{ swapChains },
+      .pImageIndices{ &presentation.imageIndex },
+      .pResults{ nullptr } // Optional
+    };
 
-    auto imageCount = getRelevantSwapChainImageCount();
+#ifdef VK_KHR_present_wait
+    const std::uint64_t presentId = ++lastPresentId_;
 
-    VkSwapchainCreateInfoKHR createInfo
+    VkPresentIdKHR presentIdInfo
     {
-      .sType{ VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR },
-      .surface{ surface_ },
-      .minImageCount{ imageCount },
-      .imageFormat{ swapChainSurfaceFormat_.format },
-      .imageColorSpace{ swapChainSurfaceFormat_.colorSpace },
-      .imageExtent{ swapChainExtent_ },
-      .imageArrayLayers{ 1 },
-      .imageUsage{ VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
-      .preTransform{ swapChainSupportDetails_.surfaceCapabilities_.currentTransform },
-      .compositeAlpha{ VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR },
-      .presentMode{ chooseSwapPresentMode() },
-      .clipped{ VK_TRUE },
-      .oldSwapchain{ VK_NULL_HANDLE }
+      .sType{ VK_STRUCTURE_TYPE_PRESENT_ID_KHR },
+      .swapchainCount{ 1 },
+      .pPresentIds{ &presentId }
     };
 
-    setupSwapChainImageSharingMode( createInfo );
+    if( waitForPresent_ != nullptr )
+    {
+      presentInfo.pNext = &presentIdInfo;
+      framePresentIds_[ presentation.frameSlot ] = presentId;
+    }
+#endif // VK_KHR_present_wait
 
-    if( vkCreateSwapchainKHR( logicalDevice_, &createInfo, nullptr, &swapChain_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create swap chain!" };
+    auto presentResult = vkQueuePresentKHR( presentationQueue_, &presentInfo );
 
-    vkGetSwapchainImagesKHR( logicalDevice_, swapChain_, &imageCount, nullptr );
-    swapChainImages_.resize( imageCount );
-    vkGetSwapchainImagesKHR( logicalDevice_, swapChain_, &imageCount, swapChainImages_.data() );
+    if( presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR && presentResult != VK_ERROR_OUT_OF_DATE_KHR )
+      throw std::runtime_error{ "Error failed to present swap chain image!" };
+
+    if( presentResult != VK_SUCCESS || framebufferResized_.exchange( false ) )
+      isSwapChainOutOfDate_ = true;
   }
 
-  void setupSwapChainSurfaceFormat()
+  // offscreen frames neither wait on an acquired image nor signal a presentation, both spans are empty then. Every frame also signals the
+  // frame timeline, telling when the resources it uses may be destroyed, and waits on its asynchronous culling if any
+  void submitGraphicQueue( VkCommandBuffer commandBuffer, std::span< const VkSemaphore > waitSemaphores, std::span< const VkSemaphore > signalSemaphores )
   {
-    swapChainSurfaceFormat_ = swapChainSupportDetails_.surfaceFormats_.front();
+    std::vector< VkSemaphore > allWaitSemaphores( waitSemaphores.begin(), waitSemaphores.end() );
+    std::vector< VkPipelineStageFlags > waitStages( allWaitSemaphores.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT );
 
-    for( const auto &availableFormat : swapChainSupportDetails_.surfaceFormats_ )
-      if( availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
-      {
-        swapChainSurfaceFormat_ = availableFormat;
-        return;
-      }
-  }
+    if( isCullingAsynchronous() )
+    {
+      allWaitSemaphores.push_back( cullingContexts_[ currentFrame_ ].semaphore );
+      waitStages.push_back( VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT );
+    }
 
-  VkPresentModeKHR chooseSwapPresentMode()
-  {
-    for( const auto &availablePresentMode : swapChainSupportDetails_.presentModes_ )
-      if( availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR )
-        return availablePresentMode;
+    std::vector< VkSemaphore > allSignalSemaphores( signalSemaphores.begin(), signalSemaphores.end() );
+    allSignalSemaphores.push_back( frameTimelineSemaphore_ );
 
-    return VK_PRESENT_MODE_FIFO_KHR;
-  }
+    // binary semaphores ignore their value
+    std::vector< std::uint64_t > signalValues( allSignalSemaphores.size(), 0 );
+    signalValues.back() = ++frameTimelineValue_;
 
-  void setupSwapChainExtent()
-  {
-    const auto &capabilities = swapChainSupportDetails_.surfaceCapabilities_;
+    VkTimelineSemaphoreSubmitInfo timelineInfo
+    {
+      .sType{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO },
+      .signalSemaphoreValueCount{ static_cast< std::uint32_t >( signalValues.size() ) },
+      .pSignalSemaphoreValues{ signalValues.data() }
+    };
 
-    if( capabilities.currentExtent.width != std::numeric_limits< std::uint32_t >::max() )
+    VkSubmitInfo submitInfo
     {
-      swapChainExtent_ = capabilities.currentExtent;
-      return;
-    }
+      .sType{ VK_STRUCTURE_TYPE_SUBMIT_INFO },
+      .pNext{ &timelineInfo },
+      .waitSemaphoreCount{ static_cast< std::uint32_t >( allWaitSemaphores.size() ) },
+      .pWaitSemaphores{ allWaitSemaphores.data() },
+      .pWaitDstStageMask{ waitStages.data() },
+      .commandBufferCount{ 1 },
+      .pCommandBuffers{ &commandBuffer },
+      .signalSemaphoreCount{ static_cast< std::uint32_t >( allSignalSemaphores.size() ) },
+      .pSignalSemaphores{ allSignalSemaphores.data() }
+    };
+
+    if( vkQueueSubmit( graphicsQueue_, 1, &submitInfo, inFlightFences_[ currentFrame_ ] ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to submit draw command buffer!" };
+  }
 
-    int currentWindowWidth, currentWindowHeight;
-    glfwGetFramebufferSize( window_, &currentWindowWidth, &currentWindowHeight );
+  // benchmark frames are animated from their index only, so that every run renders the exact same images whatever its frame rate
+  float getAnimationTime( std::uint64_t frameIndex ) const
+  {
+    if( isHeadless() )
+      return static_cast< float >( frameIndex ) * benchmarkFrameDuration_;
 
-    VkExtent2D actualExtent{ static_cast< std::uint32_t >( currentWindowWidth ), static_cast< std::uint32_t >( currentWindowHeight ) };
+    static auto startTime = std::chrono::high_resolution_clock::now();
 
-    actualExtent.width = std::max( capabilities.minImageExtent.width, std::min( capabilities.maxImageExtent.width, actualExtent.width ) );
-    actualExtent.height = std::max( capabilities.minImageExtent.height, std::min( capabilities.maxImageExtent.height, actualExtent.height ) );
+    auto currentTime = std::chrono::high_resolution_clock::now();
 
-    swapChainExtent_ = actualExtent;
+    return std::chrono::duration< float, std::chrono::seconds::period >( currentTime - startTime ).count();
   }
 
-  void createSurface()
+  std::uint32_t getInstanceGridSide() const noexcept
   {
-    if( glfwCreateWindowSurface( vulkanInstance_, window_, nullptr, &surface_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create window surface!" };
+    return static_cast< std::uint32_t >( std::ceil( std::sqrt( static_cast< double >( options_.instanceCount ) ) ) );
   }
 
-  auto getAllDeviceQueueCreateInfo()
+  // the original framing suits one cell of the grid, the camera backs off as the grid grows so that it always frames all of it
+  float getSceneScale() const noexcept
   {
-    std::vector< VkDeviceQueueCreateInfo > allQueueCreateInfo;
-
-    float queuePriorities[] = { 1.0f };
-
-    for( std::uint32_t queueFamilyIndex : requiredQueueFamilyIndices_.toSet() )
-      allQueueCreateInfo.emplace_back( VkDeviceQueueCreateInfo
-                                       {
-                                         .sType{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO },
-                                         .queueFamilyIndex{ queueFamilyIndex },
-                                         .queueCount{ 1 }, // as today
-                                         .pQueuePriorities{ queuePriorities }
-                                       } );
-    return allQueueCreateInfo;
+    return static_cast< float >( getInstanceGridSide() );
   }
 
-  void createLogicalDevice()
+  // the benchmark camera orbits and bobs around the model to exercise varying depth complexity and texture footprints
+  glm::vec3 getCameraPosition( float time ) const
   {
-    auto allQueueCreateInfo = getAllDeviceQueueCreateInfo();
-
-    VkDeviceCreateInfo deviceCreateInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO },
-      .queueCreateInfoCount{ static_cast< std::uint32_t >( allQueueCreateInfo.size() ) },
-      .pQueueCreateInfos{ allQueueCreateInfo.data() },
-      .enabledLayerCount{ 0 },
-      .enabledExtensionCount{ static_cast< std::uint32_t >( vulkanProductionExtensions_.size() ) },
-      .ppEnabledExtensionNames{ vulkanProductionExtensions_.data() },
-      .pEnabledFeatures{ &requiredPhysicalDeviceFeatures_ }
-    };
+    if( !isHeadless() )
+      return glm::vec3( 2.0f, 2.0f, 2.0f ) * getSceneScale();
 
-    if( IsVulkanValidationEnabled() )
-    {
-      deviceCreateInfo.enabledLayerCount = static_cast< std::uint32_t >( vulkanValidationLayers_.size() );
-      deviceCreateInfo.ppEnabledLayerNames = vulkanValidationLayers_.data();
-    }
+    const float angle = time * glm::radians( 24.0f );
 
-    if( vkCreateDevice( physicalDevice_, &deviceCreateInfo, nullptr, &logicalDevice_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to create logical device!" };
+    return glm::vec3( 2.8f * glm::cos( angle ), 2.8f * glm::sin( angle ), 1.5f + 0.75f * glm::sin( time * 0.5f ) ) * getSceneScale();
+  }
 
-    vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value(), 0, &graphicsQueue_ );
-    vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.presentationQueueFamilyIndex.value(), 0, &presentationQueue_ );
-    vkGetDeviceQueue( logicalDevice_, requiredQueueFamilyIndices_.transfertQueueFamilyIndex.value(), 0, &transfertQueue_ );
+  // pixels covered by one model unit seen at a unit distance, divided by the screen space error tolerated before switching to a coarser level
+  float getLodPixelScale() const noexcept
+  {
+    return static_cast< float >( swapChainExtent_.height ) * 0.5f / std::tan( glm::radians( verticalFieldOfView_ ) * 0.5f ) / lodPixelErrorThreshold_;
   }
 
-  void pickFirstSuitablePhysicalDevice()
+  // the coarsest level whose error is not visible from that far, cull.comp selects levels the same way
+  std::uint32_t selectMeshLod( float distance ) const noexcept
   {
-    uint32_t deviceCount = 0;
-    vkEnumeratePhysicalDevices( vulkanInstance_, &deviceCount, nullptr );
+    const auto lodPixelScale = getLodPixelScale();
+    std::uint32_t lod{};
 
-    if( deviceCount == 0 )
-      throw std::runtime_error{ "Error when attempting to find GPUs with Vulkan support!" };
+    while( lod + 1 < meshLods_.size() && meshLods_[ lod + 1 ].error * lodPixelScale <= distance )
+      ++lod;
 
-    std::vector< VkPhysicalDevice > devices{ deviceCount };
-    vkEnumeratePhysicalDevices( vulkanInstance_, &deviceCount, devices.data() );
+    return lod;
+  }
 
-    for( const auto &device : devices )
-      if( isPhysicalDeviceSuitable( device ) )
-      {
-        physicalDevice_ = device;
-        break;
-      }
+  // bounds the levels the instances may select from the nearest and farthest points of the grid, the mesh spinning around each instance
+  // origin. The device selection is clamped to it, whatever the rounding differences
+  LodSelection selectVisibleLods( const glm::vec3 &cameraPosition ) const noexcept
+  {
+    const auto gridOffset = ( getInstanceGridSide() - 1 ) * instanceSpacing_ / 2.0f;
+    const auto reach = glm::length( glm::vec3( meshBoundingSphere_ ) ) + meshBoundingSphere_.w;
+    const glm::vec3 gridExtent( gridOffset + reach, gridOffset + reach, reach );
 
-    if( physicalDevice_ == VK_NULL_HANDLE )
-      throw std::runtime_error{ "Error failed to find a suitable GPU!" };
+    const auto nearestDistance = glm::length( cameraPosition - glm::clamp( cameraPosition, -gridExtent, gridExtent ) );
+    const auto farthestDistance = glm::length( glm::abs( cameraPosition ) + gridExtent );
+
+    return LodSelection{ .finestLod{ selectMeshLod( nearestDistance ) }, .coarsestLod{ selectMeshLod( farthestDistance ) } };
   }
 
-  bool isDeviceSupportingRequiredFeatures( VkPhysicalDevice device )
+  // the view comes from the simulation, the projection depends on the swap chain extent that only the frame stages see
+  void updateUniformBuffer( std::uint32_t imageIndex, const SimulatedFrame &simulation )
   {
-    VkPhysicalDeviceFeatures actualFeatures;
-    vkGetPhysicalDeviceFeatures( device, &actualFeatures );
+    auto proj = glm::perspective( glm::radians( verticalFieldOfView_ ),
+                                  swapChainExtent_.width / static_cast< float >( swapChainExtent_.height ),
+                                  0.1f,
+                                  9.9f * getSceneScale() );
 
-    auto packedRequiredFeatures = &reinterpret_cast< char const volatile & >( requiredPhysicalDeviceFeatures_ );
-    auto packedActualFeatures = &reinterpret_cast< char const volatile & >( actualFeatures );
+    proj[ 1 ][ 1 ] *= -1; // vulkan top-bottom coord
 
-    for( auto &&offset : requiredPhysicalDeviceFeatureOffsets_ )
+    const UniformBufferObject ubo
     {
-      auto required = *( packedRequiredFeatures + offset );
-      auto actual = *( packedActualFeatures + offset );
+      .view{ simulation.view },
+      .proj{ proj },
+      .positionScale{ positionQuantization_.scale, 0.0f },
+      .positionOffset{ positionQuantization_.offset, 0.0f },
+      .residentTextureCount{ residentTextureCount_ }
+    };
 
-      if( required && !actual )
-        return false;
-    }
+    frameLodSelection_ = selectVisibleLods( simulation.cameraPosition );
 
-    return true;
+    // the slot lives in persistently mapped, usually write-combined memory: write it once, never read it back
+    auto slot = static_cast< std::byte * >( uniformBufferAllocation_.mappedData ) + imageIndex * uniformBufferSlotSize_;
+    *reinterpret_cast< UniformBufferObject * >( slot ) = ubo;
   }
 
-  void setupRequiredFeaturesForPhysicalDevice( VkPhysicalDevice device )
+  // instances sit on a grid centered on the origin, each one spinning with its own phase. Per instance glm reference of the batched kernel
+  glm::mat4 makeInstanceModel( std::uint32_t instanceIndex, float time ) const
   {
-    auto packedFeatures = &reinterpret_cast< char volatile & >( requiredPhysicalDeviceFeatures_ );
-
-    for( auto &&offset : requiredPhysicalDeviceFeatureOffsets_ )
-      *( packedFeatures + offset ) = VkBool32{ VK_TRUE };
-  }
+    const auto gridSide = getInstanceGridSide();
+    const auto gridOffset = ( gridSide - 1 ) * instanceSpacing_ / 2.0f;
 
-  bool isPhysicalDeviceSuitable( VkPhysicalDevice device )
-  {
-    setupRequiredQueueFamiliesForPhysicalDevice( device );
-    setupSwapChainSupportForPhysicalDevice( device );
-    setupRequiredFeaturesForPhysicalDevice( device );
+    const glm::vec3 position( static_cast< float >( instanceIndex % gridSide ) * instanceSpacing_ - gridOffset,
+                              static_cast< float >( instanceIndex / gridSide ) * instanceSpacing_ - gridOffset,
+                              0.0f );
 
-    return ( requiredQueueFamilyIndices_.isComplete()
-             && isDeviceSupportingRequiredExtensions( device )
-             && swapChainSupportDetails_.isComplete()
-             && isDeviceSupportingRequiredFeatures( device ) );
+    return glm::rotate( glm::translate( glm::mat4( 1.0f ), position ),
+                        time * glm::radians( 9.0f ) + static_cast< float >( instanceIndex ) * instancePhase_,
+                        glm::vec3( 0.0f, 0.0f, 1.0f ) );
   }
 
-  void setupSwapChainSupportForPhysicalDevice( VkPhysicalDevice device )
+  // the grid and phases of makeInstanceModel(), the spin over time being applied by the batched kernel
+  void createInstanceTransforms()
   {
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR( device, surface_, &swapChainSupportDetails_.surfaceCapabilities_ );
-
-    std::uint32_t formatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR( device, surface_, &formatCount, nullptr );
-
-    if( formatCount != 0 )
-    {
-      swapChainSupportDetails_.surfaceFormats_.resize( formatCount );
-      vkGetPhysicalDeviceSurfaceFormatsKHR( device, surface_, &formatCount, swapChainSupportDetails_.surfaceFormats_.data() );
-    }
+    const auto gridSide = getInstanceGridSide();
+    const auto gridOffset = ( gridSide - 1 ) * instanceSpacing_ / 2.0f;
 
-    std::uint32_t presentModeCount;
-    vkGetPhysicalDeviceSurfacePresentModesKHR( device, surface_, &presentModeCount, nullptr );
+    instanceTransforms_.resize( options_.instanceCount );
 
-    if( presentModeCount != 0 )
+    for( std::uint32_t i = 0; i < options_.instanceCount; ++i )
     {
-      swapChainSupportDetails_.presentModes_.resize( presentModeCount );
-      vkGetPhysicalDeviceSurfacePresentModesKHR( device, surface_, &presentModeCount, swapChainSupportDetails_.presentModes_.data() );
+      const auto rotation = glm::angleAxis( static_cast< float >( i ) * instancePhase_, glm::vec3( 0.0f, 0.0f, 1.0f ) );
+
+      instanceTransforms_.positionX[ i ] = static_cast< float >( i % gridSide ) * instanceSpacing_ - gridOffset;
+      instanceTransforms_.positionY[ i ] = static_cast< float >( i / gridSide ) * instanceSpacing_ - gridOffset;
+      instanceTransforms_.positionZ[ i ] = 0.0f;
+      instanceTransforms_.rotationX[ i ] = rotation.x;
+      instanceTransforms_.rotationY[ i ] = rotation.y;
+      instanceTransforms_.rotationZ[ i ] = rotation.z;
+      instanceTransforms_.rotationW[ i ] = rotation.w;
+      instanceTransforms_.scaleX[ i ] = 1.0f;
+      instanceTransforms_.scaleY[ i ] = 1.0f;
+      instanceTransforms_.scaleZ[ i ] = 1.0f;
     }
   }
 
-  bool isDeviceSupportingRequiredExtensions( VkPhysicalDevice device )
+  // whole batches first, the remaining instances one at a time. A batch is composed on the stack, the kernel storing column by column, then
+  // copied out in one sequential run, padding included, so that the write-combined memory of a mapped buffer only sees full lines
+  void composeInstanceRange( std::size_t begin, std::size_t end, const glm::quat &spin, InstanceData *instances ) const noexcept
   {
-    std::uint32_t extensionCount;
-    vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, nullptr );
-
-    std::vector< VkExtensionProperties > availableExtensions( extensionCount );
-    vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, availableExtensions.data() );
+    const auto composeBatch = [ & ]< typename Float >( std::size_t first, Float )
+    {
+      InstanceData batch[ Float::width ]{};
+      float *matrices[ Float::width ];
 
-    for( std::string_view extension : vulkanProductionExtensions_ )
-      if( std::find_if( std::cbegin( availableExtensions ),
-                        std::cend( availableExtensions ),
-                        [ &extension ]( const VkExtensionProperties &extensionProperties )
+      for( std::size_t lane = 0; lane < Float::width; ++lane )
       {
-        return extension.compare( extensionProperties.extensionName ) == 0;
-      } ) == std::cend( availableExtensions ) )
-        return false;
+        matrices[ lane ] = &batch[ lane ].model[ 0 ][ 0 ];
+        batch[ lane ].materialIndex = static_cast< std::uint32_t >( ( first + lane ) % materialCount_ );
+      }
 
-      return true;
+      composeInstanceMatrices< Float >( instanceTransforms_, first, spin, matrices );
+
+      std::memcpy( instances + first, batch, sizeof( batch ) );
+    };
+
+    auto i = begin;
+
+    for( ; i + SimdFloat::width <= end; i += SimdFloat::width )
+      composeBatch( i, SimdFloat{} );
+
+    for( ; i < end; ++i )
+      composeBatch( i, ScalarFloat{} );
   }
 
-  void setupRequiredQueueFamilyForPhysicalDevice( VkPhysicalDevice device, const VkQueueFamilyProperties &queueFamily, std::uint32_t &mutableQueueFamilyIndex )
+  // split across the job system once there is more than one task worth of instances
+  void composeInstances( float time, InstanceData *instances )
   {
-    if( requiredQueueFamilyIndices_.isComplete() )
+    const auto spin = glm::angleAxis( time * glm::radians( 9.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ) );
+    const auto chunkCount = ( options_.instanceCount + instancesPerUpdateTask_ - 1 ) / instancesPerUpdateTask_;
+
+    if( chunkCount == 1 )
     {
-      mutableQueueFamilyIndex = std::numeric_limits< std::uint32_t >::max() - 1;
+      composeInstanceRange( 0, options_.instanceCount, spin, instances );
       return;
     }
 
-    if( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT )
-      requiredQueueFamilyIndices_.graphicsQueueFamilyIndex = mutableQueueFamilyIndex;
-
-    VkBool32 hasPresentationSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR( device, mutableQueueFamilyIndex, surface_, &hasPresentationSupport );
-
-    if( hasPresentationSupport )
-      requiredQueueFamilyIndices_.presentationQueueFamilyIndex = mutableQueueFamilyIndex;
+    jobSystem_.run( chunkCount, [ this, &spin, instances ]( std::size_t, std::size_t chunkIndex )
+    {
+      const auto begin = chunkIndex * instancesPerUpdateTask_;
+      const auto end = std::min< std::size_t >( begin + instancesPerUpdateTask_, options_.instanceCount );
 
-    if( queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT )
-      requiredQueueFamilyIndices_.transfertQueueFamilyIndex = mutableQueueFamilyIndex;
+      composeInstanceRange( begin, end, spin, instances );
+    } );
   }
 
-  void setupRequiredQueueFamiliesForPhysicalDevice( VkPhysicalDevice device )
+  void updateInstanceBuffer( std::uint32_t imageIndex, float delta )
   {
-    std::uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties( device, &queueFamilyCount, nullptr );
+    auto instances = reinterpret_cast< InstanceData * >( static_cast< std::byte * >( instanceBufferAllocation_.mappedData ) + imageIndex * instanceBufferSlotSize_ );
 
-    std::vector< VkQueueFamilyProperties > queueFamilies{ queueFamilyCount };
-    vkGetPhysicalDeviceQueueFamilyProperties( device, &queueFamilyCount, queueFamilies.data() );
-
-    for( std::uint32_t i = 0; i < queueFamilies.size(); ++i )
-      setupRequiredQueueFamilyForPhysicalDevice( device, queueFamilies[ i ], i );
+    composeInstances( delta, instances );
   }
 
-  void setupDebugMessenger()
+  // into host memory rather than a mapped buffer, only the instruction sets and the job system are compared. The batched results are
+  // checked against the glm ones of the same frame
+  void runTransformBenchmark()
   {
-    if( !IsVulkanValidationEnabled() )
-      return;
+    std::vector< InstanceData > referenceInstances( options_.instanceCount );
+    std::vector< InstanceData > instances( options_.instanceCount );
 
-    VkDebugUtilsMessengerCreateInfoEXT createInfos
+    const auto measure = []( auto &&compose )
     {
-      .sType{ VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT },
-      .messageSeverity{ VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
-                         VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
-                         VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT },
-      .messageType{ VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
-                     VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
-                     VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT },
-      .pfnUserCallback{ debugCallback },
-      .pUserData{ nullptr }
+      const auto begin = Profiler::Clock::now();
+
+      for( std::uint32_t i = 0; i < transformBenchmarkIterationCount_; ++i )
+        compose( static_cast< float >( i ) * benchmarkFrameDuration_ );
+
+      return std::chrono::duration< double, std::milli >( Profiler::Clock::now() - begin ).count() / transformBenchmarkIterationCount_;
     };
 
-    if( createDebugUtilsMessengerEXT( vulkanInstance_, &createInfos, nullptr, &debugMessenger_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error while setup the debug messenger" };
+    const auto glmTime = measure( [ & ]( float time )
+    {
+      for( std::uint32_t i = 0; i < options_.instanceCount; ++i )
+        referenceInstances[ i ] = { .model{ makeInstanceModel( i, time ) }, .materialIndex{ i % materialCount_ } };
+    } );
+
+    const auto batchedTime = measure( [ & ]( float time )
+    {
+      composeInstanceRange( 0, options_.instanceCount, glm::angleAxis( time * glm::radians( 9.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ) ), instances.data() );
+    } );
+
+    float maximumError{};
+
+    for( std::size_t i = 0; i < instances.size(); ++i )
+      for( int column = 0; column < 4; ++column )
+        for( int row = 0; row < 4; ++row )
+          maximumError = std::max( maximumError, std::abs( instances[ i ].model[ column ][ row ] - referenceInstances[ i ].model[ column ][ row ] ) );
+
+    const auto jobTime = measure( [ & ]( float time ) { composeInstances( time, instances.data() ); } );
+
+    std::cout << std::fixed << std::setprecision( 3 )
+              << "transform benchmark " << options_.instanceCount << " instances, glm " << glmTime << " ms, "
+              << SimdFloat::name << ' ' << batchedTime << " ms (" << glmTime / batchedTime << "x), "
+              << SimdFloat::name << " over " << jobSystem_.getWorkerCount() << " workers " << jobTime << " ms (" << glmTime / jobTime << "x), "
+              << "max error " << std::scientific << maximumError << std::endl;
   }
 
-  void appendProductionExtensionsIn( std::vector< const char * > &extensions )
+  // With present wait, the frame that used this slot last is waited on until it is on screen, pacing the frames on the display rather than on
+  // the device. Its fence is most likely signaled by then, it is still waited on should the presentation engine not report in time
+  void waitForFrameSlot()
   {
-    uint32_t glfwExtensionCount = 0u;
-    auto rawGlfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+#ifdef VK_KHR_present_wait
+    const auto presentId = framePresentIds_[ currentFrame_ ];
 
-    if( rawGlfwExtensions == nullptr )
-      throw std::runtime_error{ "Error while querying glfw required vulkan extensions" };
+    if( waitForPresent_ != nullptr && presentId >= firstSwapChainPresentId_ )
+      waitForPresent_( logicalDevice_, swapChain_, presentId, presentWaitTimeout_ );
+#endif // VK_KHR_present_wait
 
-    for( std::size_t i = 0; i < glfwExtensionCount; ++i )
-      extensions.push_back( rawGlfwExtensions[ i ] );
+    vkWaitForFences( logicalDevice_, 1, &inFlightFences_[ currentFrame_ ], VK_TRUE, std::numeric_limits< std::uint64_t >::max() );
   }
 
-  void appendValidationExtensionsIn( std::vector< const char * > &extensions )
+  // The recording stage only works between the hand over of an acquired image and the return of its recorded frame. Everything else, i.e.
+  // uploads, retirements, shader reloads and swap chain recreations, happens while it is idle. Each frame is presented as soon as it is
+  // submitted, before the next image is acquired: the application never holds more than one image, and the recording of the next frame
+  // overlaps the execution of the previous one by the device rather than its presentation
+  void submitFrames()
   {
-    std::for_each( std::cbegin( vulkanValidationExtensions_ ),
-                   std::cend( vulkanValidationExtensions_ ),
-                   [ &extensions ]( const char *const &extensionName ) mutable { extensions.push_back( extensionName ); } );
+    for( ;; )
+    {
+      auto simulation = simulatedFrames_.pop();
+
+      if( !simulation.has_value() )
+        return;
+
+      if( simulation->isLast )
+        break;
+
+      const auto imageIndex = prepareFrame( simulation.value() );
+
+      // the window has been closed while minimized, its last frames are dropped
+      if( !imageIndex.has_value() )
+      {
+        simulatedFrames_.cancel();
+        break;
+      }
+
+      if( !frameRecordings_.push( FrameRecording{ simulation.value(), imageIndex.value() } ) )
+        return;
+
+      if( !recordedFrames_.pop().has_value() )
+        return;
+
+      presentFrame( submitFrame( imageIndex.value() ) );
+    }
+
+    frameRecordings_.push( FrameRecording{ .simulation{ .isLast{ true } } } );
   }
 
-  auto getEnabledExtensions()
+  void recordFrames()
   {
-    std::vector< const char *> enabledExtensions;
+    for( ;; )
+    {
+      auto recording = frameRecordings_.pop();
 
-    appendProductionExtensionsIn( enabledExtensions );
+      if( !recording.has_value() || recording->simulation.isLast )
+        return;
 
-    if( IsVulkanValidationEnabled() )
-      appendValidationExtensionsIn( enabledExtensions );
+      recordFrame( recording.value() );
 
-    return enabledExtensions;
+      if( !recordedFrames_.push( recording->imageIndex ) )
+        return;
+    }
   }
 
-  auto getEnabledLayers()
+  // toggling the depth pre-pass records the prebaked command buffers again along with the swap chain, the pending ones are retired with it
+  std::optional< std::uint32_t > prepareFrame( const SimulatedFrame &simulation )
   {
-    std::vector< const char * > enabledLayers;
+    profiler_.beginFrame();
 
-    if( IsVulkanValidationEnabled() )
-      std::for_each( std::cbegin( vulkanValidationLayers_ ),
-                     std::cend( vulkanValidationLayers_ ),
-                     [ &enabledLayers ]( const char *const &layerName ) mutable { enabledLayers.push_back( layerName ); } );
+    {
+      ScopedTimer timer{ profiler_, "fence_wait" };
+      waitForFrameSlot();
+    }
 
-    return enabledLayers;
-  }
+    submitUploadBatch();
+    retireCompletedUploadBatches();
+    destroyCompletedRetiredSwapChains();
+    sampleMemoryBudget();
+    reloadChangedShaders();
+    updateAssetStreaming();
 
-  void createInstance()
-  {
-    VkApplicationInfo appInfo
+    if( simulation.isDepthPrePassEnabled != depthPrePassEnabled_ )
     {
-      .sType{ VK_STRUCTURE_TYPE_APPLICATION_INFO },
-      .pApplicationName{ "Hello Triangle" },
-      .applicationVersion{ VK_MAKE_VERSION( 1, 0, 0 ) },
-      .pEngineName{ "No Engine" },
-      .engineVersion{ VK_MAKE_VERSION( 0, 0, 0 ) },
-      .apiVersion{ VK_API_VERSION_1_2 }
-    };
+      depthPrePassEnabled_ = simulation.isDepthPrePassEnabled;
+      isSwapChainOutOfDate_ = isSwapChainOutOfDate_ || options_.prebakedCommandBuffers;
+    }
 
-    auto enabledExtensions = getEnabledExtensions();
-    auto enabledLayers = getEnabledLayers();
+    if( isSwapChainOutOfDate_ && !isHeadless() )
+    {
+      isSwapChainOutOfDate_ = false;
+
+      if( !recreateSwapChain() )
+        return std::nullopt;
+    }
+
+    std::optional< std::uint32_t > imageIndex;
 
-    VkInstanceCreateInfo instanceInfo
     {
-      .sType{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO },
-      .pApplicationInfo{ &appInfo },
-      .enabledLayerCount{ static_cast< std::uint32_t >( enabledLayers.size() ) },
-      .ppEnabledLayerNames{ enabledLayers.data() },
-      .enabledExtensionCount{ static_cast< std::uint32_t >( enabledExtensions.size() ) },
-      .ppEnabledExtensionNames{ enabledExtensions.data() }
-    };
+      ScopedTimer timer{ profiler_, "acquire" };
+      imageIndex = isHeadless() ? acquireNextOffscreenImage() : acquireNextImage();
+    }
 
-    if( vkCreateInstance( &instanceInfo, nullptr, &vulkanInstance_ ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error while creating vulkan instance" };
+    // the previous submission of this image command buffer is complete, its timestamps are available
+    if( imageIndex.has_value() )
+      readGpuTimestamps( imageIndex.value() );
+
+    return imageIndex;
   }
 
-  void checkValidationSupport()
+  void recordFrame( const FrameRecording &recording )
   {
-    checkSupportedValidationLayers();
-    checkSupportedValidationExtensions();
+    {
+      ScopedTimer timer{ profiler_, "uniform_update" };
+      updateUniformBuffer( recording.imageIndex, recording.simulation );
+      updateInstanceBuffer( recording.imageIndex, recording.simulation.animationTime );
+    }
+
+    if( !options_.prebakedCommandBuffers )
+    {
+      ScopedTimer timer{ profiler_, "record" };
+      recordFrameCommandBuffer( recording.imageIndex );
+    }
+
+    if( isCullingAsynchronous() )
+    {
+      ScopedTimer timer{ profiler_, "culling" };
+      recordCullingCommandBuffer( recording.imageIndex );
+    }
   }
 
-  void checkSupportedValidationLayers()
+  // the culling is submitted first, the draws wait on it
+  PendingPresentation submitFrame( std::uint32_t imageIndex )
   {
-    if( !IsVulkanValidationEnabled() )
-      return;
+    vkResetFences( logicalDevice_, 1, &inFlightFences_[ currentFrame_ ] );
 
-    std::uint32_t availableLayerCount = 0u;
+    VkSemaphore waitSemaphores[] = { imageAvailableSemaphore_[ currentFrame_ ] };
+    VkSemaphore signalSemaphores[] = { renderFinishedSemaphore_[ currentFrame_ ] };
 
-    if( vkEnumerateInstanceLayerProperties( &availableLayerCount, nullptr ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error while counting vulkan instance available layers" };
+    {
+      ScopedTimer timer{ profiler_, "submit" };
 
-    std::vector< VkLayerProperties > instanceLayers{ availableLayerCount };
+      if( isCullingAsynchronous() )
+        submitCullingQueue();
 
-    if( vkEnumerateInstanceLayerProperties( &availableLayerCount, instanceLayers.data() ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error while querying vulkan instance available layers" };
+      if( isHeadless() )
+        submitGraphicQueue( getDrawCommandBuffer( imageIndex ), {}, {} );
+      else
+        submitGraphicQueue( getDrawCommandBuffer( imageIndex ), waitSemaphores, signalSemaphores );
+    }
 
-    std::for_each( std::cbegin( vulkanValidationLayers_ ),
-                   std::cend( vulkanValidationLayers_ ),
-                   [ &instanceLayers ]( std::string_view validationLayer )
-    {
-      if( std::find_if( std::cbegin( instanceLayers ),
-                        std::cend( instanceLayers ),
-                        [ &validationLayer ]( const VkLayerProperties &layerProperties )
-      {
-        return validationLayer.compare( layerProperties.layerName ) == 0;
-      } ) == std::cend( instanceLayers ) )
-        throw std::runtime_error{ "Error while querying for unsupported required validation layer" };
-    } );
+    if( timestampQueryPool_ != VK_NULL_HANDLE && imageIndex < timestampQueryFrames_.size() )
+      timestampQueryFrames_[ imageIndex ] = profiler_.getFrameIndex();
+
+    const PendingPresentation presentation{ imageIndex, currentFrame_ };
+
+    currentFrame_ = ( currentFrame_ + 1 ) % maxFrameInFlight_;
+
+    return presentation;
   }
 
-  void checkSupportedValidationExtensions()
+  void presentFrame( const PendingPresentation &presentation )
   {
-    if( !IsVulkanValidationEnabled() )
+    if( isHeadless() )
       return;
 
-    std::uint32_t availableExtensionCount = 0u;
+    ScopedTimer timer{ profiler_, "present" };
+    submitPresentationQueue( presentation );
+  }
 
-    if( vkEnumerateInstanceExtensionProperties( nullptr, &availableExtensionCount, nullptr ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error while counting vulkan instance available extensions" };
+  void createTimestampQueryPool()
+  {
+    std::uint32_t queueFamilyCount{};
+    vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice_, &queueFamilyCount, nullptr );
 
-    std::vector<VkExtensionProperties> instanceExtensions{ availableExtensionCount };
+    std::vector< VkQueueFamilyProperties > queueFamilies( queueFamilyCount );
+    vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice_, &queueFamilyCount, queueFamilies.data() );
 
-    if( vkEnumerateInstanceExtensionProperties( nullptr, &availableExtensionCount, instanceExtensions.data() ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error while querying vulkan instance available extensions" };
+    const auto timestampValidBits = queueFamilies[ requiredQueueFamilyIndices_.graphicsQueueFamilyIndex.value() ].timestampValidBits;
 
-    std::for_each( std::cbegin( vulkanValidationExtensions_ ),
-                   std::cend( vulkanValidationExtensions_ ),
-                   [ &instanceExtensions ]( std::string_view validationExtension )
+    timestampQueryPool_ = VK_NULL_HANDLE;
+    timestampQueryFrames_.assign( swapChainImages_.size(), std::nullopt );
+
+    // GPU timing is simply left out on queues without timestamp support
+    if( timestampValidBits == 0 )
+      return;
+
+    timestampMask_ = timestampValidBits >= 64 ? std::numeric_limits< std::uint64_t >::max() : ( std::uint64_t{ 1 } << timestampValidBits ) - 1;
+
+    // a begin and an end timestamp for each draw command buffer
+    VkQueryPoolCreateInfo queryPoolInfo
     {
-      if( std::find_if( std::cbegin( instanceExtensions ),
-                        std::cend( instanceExtensions ),
-                        [ &validationExtension ]( const VkExtensionProperties &extensionProperties )
-      {
-        return validationExtension.compare( extensionProperties.extensionName ) == 0;
-      } ) == std::cend( instanceExtensions ) )
-        throw std::runtime_error{ "Error while querying for unsupported required validation extension" };
-    } );
+      .sType{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO },
+      .queryType{ VK_QUERY_TYPE_TIMESTAMP },
+      .queryCount{ static_cast< std::uint32_t >( 2 * swapChainImages_.size() ) }
+    };
+
+    if( vkCreateQueryPool( logicalDevice_, &queryPoolInfo, nullptr, &timestampQueryPool_ ) != VK_SUCCESS )
+      throw std::runtime_error{ "Error failed to create timestamp query pool!" };
   }
 
-  void mainLoop()
+  void readGpuTimestamps( std::uint32_t imageIndex )
   {
-    while( glfwWindowShouldClose( window_ ) != GLFW_TRUE )
+    if( timestampQueryPool_ == VK_NULL_HANDLE || imageIndex >= timestampQueryFrames_.size() || !timestampQueryFrames_[ imageIndex ].has_value() )
+      return;
+
+    std::uint64_t timestamps[ 2 ];
+
+    const auto result = vkGetQueryPoolResults( logicalDevice_,
+                                               timestampQueryPool_,
+                                               2 * imageIndex,
+                                               2,
+                                               sizeof( timestamps ),
+                                               timestamps,
+                                               sizeof( std::uint64_t ),
+                                               VK_QUERY_RESULT_64_BIT );
+
+    if( result == VK_SUCCESS )
     {
-      glfwPollEvents();
-      drawFrame();
+      const auto ticks = ( timestamps[ 1 ] - timestamps[ 0 ] ) & timestampMask_;
+      const auto milliseconds = static_cast< double >( ticks ) * physicalDeviceProperties_.limits.timestampPeriod / 1e6;
+
+      profiler_.recordGpuFrameTime( timestampQueryFrames_[ imageIndex ].value(), milliseconds );
     }
 
-    vkDeviceWaitIdle( logicalDevice_ );
+    timestampQueryFrames_[ imageIndex ].reset();
   }
 
-  void synchronizeFrames( std::uint32_t imageIndex )
+  // poor man's overlay, no text rendering is available
+  void updateWindowTitleWithFrameTimes()
   {
-    // Check if a previous frame is using this image (i.e. there is its fence to wait on)
-    if( inFlightImageFences_[ imageIndex ] != VK_NULL_HANDLE )
-      vkWaitForFences( logicalDevice_, 1, &inFlightImageFences_[ imageIndex ], VK_TRUE, std::numeric_limits< std::uint64_t >::max() );
+    const auto now = Profiler::Clock::now();
 
-    // Mark the image as now being in use by this frame
-    inFlightImageFences_[ imageIndex ] = inFlightFences_[ currentFrame_ ];
-  }
+    if( now - lastWindowTitleUpdate_ < std::chrono::milliseconds{ 500 } )
+      return;
 
-  auto acquireNextImage()
-  {
-    std::uint32_t imageIndex{};
-    auto acquireNextResult = vkAcquireNextImageKHR( logicalDevice_,
-                                                    swapChain_,
-                                                    std::numeric_limits< std::uint64_t >::max(),
-                                                    imageAvailableSemaphore_[ currentFrame_ ],
-                                                    VK_NULL_HANDLE,
-                                                    &imageIndex );
+    lastWindowTitleUpdate_ = now;
 
-    if( acquireNextResult == VK_ERROR_OUT_OF_DATE_KHR )
-    {
-      recreateSwapChain();
-      return imageIndex;
-    }
-    else if( acquireNextResult != VK_SUCCESS && acquireNextResult != VK_SUBOPTIMAL_KHR )
-      throw std::runtime_error{ "Error failed to acquire swap chain image!" };
+    const auto [p50, p95, p99] = profiler_.getFrameTimePercentiles();
+    std::ostringstream title;
 
-    synchronizeFrames( imageIndex );
+    title << std::fixed << std::setprecision( 2 )
+          << "Vulkan - frame p50 " << p50 << " ms, p95 " << p95 << " ms, p99 " << p99 << " ms, GPU " << profiler_.getLastGpuFrameTime() << " ms";
 
-    return imageIndex;
+    if( requestedDepthPrePass_ )
+      title << ", depth pre-pass";
+
+    glfwSetWindowTitle( window_, title.str().c_str() );
   }
 
-  template< std::size_t N >
-  void submitPresentationQueue( std::uint32_t imageIndex, const VkSemaphore( &signalSemaphores )[ N ] )
+  // device local heaps and the others are summed apart, most devices expose only one of each that matters
+  void sampleMemoryBudget()
   {
-    VkSwapchainKHR swapChains[] = { swapChain_ };
-    VkPresentInfoKHR presentInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR },
-      .waitSemaphoreCount{ sizeof( signalSemaphores ) / sizeof( VkSemaphore ) },
-      .pWaitSemaphores{ signalSemaphores },
-      .swapchainCount{ sizeof( swapChains ) / sizeof( VkSwapchainKHR ) },
-      .pSwapchains{ swapChains },
-      .pImageIndices{ &imageIndex },
-      .pResults{ nullptr } // Optional
-    };
+    memoryAllocator_.updateBudget();
 
-    auto presentResult = vkQueuePresentKHR( presentationQueue_, &presentInfo );
+    if( !profiler_.isCapturing() )
+      return;
 
-    if( presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || framebufferResized_ )
+    const auto &memoryProperties = memoryAllocator_.getMemoryProperties();
+    DeviceMemoryAllocator::HeapStatistics deviceLocal{};
+    DeviceMemoryAllocator::HeapStatistics host{};
+
+    for( std::uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i )
     {
-      framebufferResized_ = false;
-      recreateSwapChain();
+      const auto statistics = memoryAllocator_.getHeapStatistics( i );
+      auto &sum = memoryProperties.memoryHeaps[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? deviceLocal : host;
+
+      sum.usage += statistics.usage;
+      sum.budget += statistics.budget;
     }
-    else if( presentResult != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to present swap chain image!" };
-  }
 
-  template< std::size_t WaitSemaphoreCount, std::size_t SignalSemaphoreCount >
-  void submitGraphicQueue( std::uint32_t imageIndex,
-                           const VkSemaphore( &waitSemaphores )[ WaitSemaphoreCount ],
-                           const VkSemaphore( &signalSemaphores )[ SignalSemaphoreCount ] )
-  {
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    VkSubmitInfo submitInfo
-    {
-      .sType{ VK_STRUCTURE_TYPE_SUBMIT_INFO },
-      .waitSemaphoreCount{ WaitSemaphoreCount },
-      .pWaitSemaphores{ waitSemaphores },
-      .pWaitDstStageMask{ waitStages },
-      .commandBufferCount{ 1 },
-      .pCommandBuffers{ &commandBuffers_[ imageIndex ] },
-      .signalSemaphoreCount{ SignalSemaphoreCount },
-      .pSignalSemaphores{ signalSemaphores }
-    };
+    profiler_.recordMemoryCounter( "device_local_usage", deviceLocal.usage );
+    profiler_.recordMemoryCounter( "device_local_budget", deviceLocal.budget );
+    profiler_.recordMemoryCounter( "host_usage", host.usage );
+    profiler_.recordMemoryCounter( "host_budget", host.budget );
 
-    if( vkQueueSubmit( graphicsQueue_, 1, &submitInfo, inFlightFences_[ currentFrame_ ] ) != VK_SUCCESS )
-      throw std::runtime_error{ "Error failed to submit draw command buffer!" };
+    for( std::size_t i = 0; i < static_cast< std::size_t >( MemoryCategory::Count ); ++i )
+    {
+      const auto category = static_cast< MemoryCategory >( i );
+      profiler_.recordMemoryCounter( getMemoryCategoryName( category ), memoryAllocator_.getCategoryAllocations( category ).size );
+    }
   }
 
-  void updateUniformBuffer( std::uint32_t imageIndex )
+  void printMemoryStatistics() const
   {
-    static auto startTime = std::chrono::high_resolution_clock::now();
+    constexpr double bytesPerMebibyte{ 1024.0 * 1024.0 };
+    const auto &memoryProperties = memoryAllocator_.getMemoryProperties();
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float delta = std::chrono::duration< float, std::chrono::seconds::period >( currentTime - startTime ).count();
+    std::cout << std::fixed << std::setprecision( 2 );
 
-    UniformBufferObject ubo
+    for( std::uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i )
     {
-      .model
-      {
-          glm::rotate( glm::mat4( 1.0f ),
-                       delta * glm::radians( 9.0f ),
-                       glm::vec3( 0.0f, 0.0f, 1.0f ) )
-      },
-      .view
-      {
-        glm::lookAt( glm::vec3( 2.0f, 2.0f, 2.0f ),
-                     glm::vec3( 0.0f, 0.0f, 0.0f ),
-                     glm::vec3( 0.0f, 0.0f, 1.0f ) )
-      },
-      .proj
+      const auto statistics = memoryAllocator_.getHeapStatistics( i );
+
+      std::cout << "memory heap " << i << ( memoryProperties.memoryHeaps[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? " device local" : " host" )
+                << ": " << statistics.allocations.size / bytesPerMebibyte << " MiB in " << statistics.allocations.count << " allocations out of "
+                << statistics.deviceMemory.size / bytesPerMebibyte << " MiB in " << statistics.deviceMemory.count << " device memories, usage "
+                << statistics.usage / bytesPerMebibyte << " MiB of a " << statistics.budget / bytesPerMebibyte << " MiB budget"
+                << ( memoryAllocator_.isBudgetQueryable() ? "" : " (estimated)" ) << std::endl;
+
+      for( std::uint32_t j = 0; j < memoryProperties.memoryTypeCount; ++j )
       {
-        glm::perspective( glm::radians( 45.0f ),
-                          swapChainExtent_.width / static_cast< float >( swapChainExtent_.height ),
-                          0.1f,
-                          9.9f )
+        const auto &deviceMemory = memoryAllocator_.getMemoryTypeDeviceMemory( j );
+
+        if( memoryProperties.memoryTypes[ j ].heapIndex != i || deviceMemory.count == 0 )
+          continue;
+
+        const auto &allocations = memoryAllocator_.getMemoryTypeAllocations( j );
+
+        std::cout << "  memory type " << j << ": " << allocations.size / bytesPerMebibyte << " MiB in " << allocations.count << " allocations out of "
+                  << deviceMemory.size / bytesPerMebibyte << " MiB in " << deviceMemory.count << " device memories" << std::endl;
       }
-    };
+    }
 
-    ubo.proj[ 1 ][ 1 ] *= -1; // vulkan top-bottom coord
+    for( std::size_t i = 0; i < static_cast< std::size_t >( MemoryCategory::Count ); ++i )
+    {
+      const auto category = static_cast< MemoryCategory >( i );
+      const auto &allocations = memoryAllocator_.getCategoryAllocations( category );
 
-    void *data;
-    vkMapMemory( logicalDevice_, uniformBuffersMemory_[ imageIndex ], 0, sizeof( UniformBufferObject ), 0, &data );
-    memcpy( data, &ubo, sizeof( UniformBufferObject ) );
-    vkUnmapMemory( logicalDevice_, uniformBuffersMemory_[ imageIndex ] );
+      std::cout << "memory " << getMemoryCategoryName( category ) << ": " << allocations.size / bytesPerMebibyte << " MiB in " << allocations.count
+                << " allocations" << std::endl;
+    }
   }
 
-  void drawFrame()
+  void exportProfile()
   {
-    vkWaitForFences( logicalDevice_, 1, &inFlightFences_[ currentFrame_ ], VK_TRUE, std::numeric_limits< std::uint64_t >::max() );
-
-    auto imageIndex = acquireNextImage();
+    for( std::uint32_t i = 0; i < timestampQueryFrames_.size(); ++i )
+      readGpuTimestamps( i );
 
-    updateUniformBuffer( imageIndex );
+    if( options_.profileCsvPath.has_value() )
+      profiler_.exportCsv( options_.profileCsvPath.value() );
 
-    vkResetFences( logicalDevice_, 1, &inFlightFences_[ currentFrame_ ] );
+    if( options_.profileTracePath.has_value() )
+      profiler_.exportChromeTrace( options_.profileTracePath.value() );
 
-    VkSemaphore waitSemaphores[] = { imageAvailableSemaphore_[ currentFrame_ ] };
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphore_[ currentFrame_ ] };
+    const auto [p50, p95, p99] = profiler_.getFrameTimePercentiles();
 
-    submitGraphicQueue( imageIndex, waitSemaphores, signalSemaphores );
-    submitPresentationQueue( imageIndex, signalSemaphores );
+    std::cout << std::fixed << std::setprecision( 2 ) << "frame time p50 " << p50 << " ms, p95 " << p95 << " ms, p99 " << p99 << " ms" << std::endl;
 
-    currentFrame_ = ( currentFrame_ + 1 ) % maxFrameInFlight_;
+    printMemoryStatistics();
   }
 
+  // the device is idle, retired resources are destroyed right away
   void cleanupSwapChain()
   {
-    vkDestroyImageView( logicalDevice_, depthImageView_, nullptr );
-    vkDestroyImage( logicalDevice_, depthImage_, nullptr );
-    vkFreeMemory( logicalDevice_, depthImageMemory_, nullptr );
+    auto retiredSwapChain = retireSwapChain();
+    retirePerImageResources( retiredSwapChain );
+    destroyRetiredSwapChain( retiredSwapChain );
 
-    for( auto &&framebuffer : swapChainFramebuffers_ )
-      vkDestroyFramebuffer( logicalDevice_, framebuffer, nullptr );
+    for( auto &&pendingRetiredSwapChain : retiredSwapChains_ )
+      destroyRetiredSwapChain( pendingRetiredSwapChain );
+
+    retiredSwapChains_.clear();
+
+    // headless only, swap chain images belong to the swap chain
+    for( std::size_t i = 0; i < offscreenImageAllocations_.size(); ++i )
+    {
+      vkDestroyImage( logicalDevice_, swapChainImages_[ i ], nullptr );
+      memoryAllocator_.free( offscreenImageAllocations_[ i ] );
+    }
 
-    vkFreeCommandBuffers( logicalDevice_, graphicCommandPool_, static_cast< std::uint32_t >( commandBuffers_.size() ), commandBuffers_.data() );
+    offscreenImageAllocations_.clear();
+  }
 
+  void cleanupGraphicPipeline()
+  {
     for( auto &&graphicsPipeline : graphicPipelines_ )
       vkDestroyPipeline( logicalDevice_, graphicsPipeline, nullptr );
 
+    graphicPipelines_.clear();
+
     vkDestroyPipelineLayout( logicalDevice_, pipelineLayout_, nullptr );
     vkDestroyRenderPass( logicalDevice_, renderPass_, nullptr );
-
-    for( auto &&imageView : swapChainImageViews_ )
-      vkDestroyImageView( logicalDevice_, imageView, nullptr );
-
-    vkDestroySwapchainKHR( logicalDevice_, swapChain_, nullptr );
-
-    for( auto &&uniformBuffer : uniformBuffers_ )
-      vkDestroyBuffer( logicalDevice_, uniformBuffer, nullptr );
-
-    for( auto &&uniformBufferMemory : uniformBuffersMemory_ )
-      vkFreeMemory( logicalDevice_, uniformBufferMemory, nullptr );
-
-    vkDestroyDescriptorPool( logicalDevice_, descriptorPool_, nullptr );
   }
 
   void cleanupSynchronizationObjects()
@@ -1998,27 +8298,71 @@ private:
       vkDestroySemaphore( logicalDevice_, imageAvailableSemaphore_[ i ], nullptr );
       vkDestroyFence( logicalDevice_, inFlightFences_[ i ], nullptr );
     }
+
+    for( auto &&context : cullingContexts_ )
+      vkDestroySemaphore( logicalDevice_, context.semaphore, nullptr );
+
+    vkDestroySemaphore( logicalDevice_, frameTimelineSemaphore_, nullptr );
   }
 
   void cleanup()
   {
+    cleanupAssetStreaming();
     cleanupSwapChain();
+    cleanupGraphicPipeline();
+    vkDestroyPipeline( logicalDevice_, cullingPipeline_, nullptr );
+    vkDestroyPipelineLayout( logicalDevice_, cullingPipelineLayout_, nullptr );
+    savePipelineCache();
+    vkDestroyPipelineCache( logicalDevice_, pipelineCache_, nullptr );
+    shaderManager_.destroy();
     vkDestroySampler( logicalDevice_, textureSampler_, nullptr );
     vkDestroyImageView( logicalDevice_, textureImageView_, nullptr );
     vkDestroyImage( logicalDevice_, textureImage_, nullptr );
-    vkFreeMemory( logicalDevice_, textureImageMemory_, nullptr );
+    memoryAllocator_.free( textureImageAllocation_ );
+    vkDestroyImageView( logicalDevice_, placeholderTextureImageView_, nullptr );
+    vkDestroyImage( logicalDevice_, placeholderTextureImage_, nullptr );
+    memoryAllocator_.free( placeholderTextureImageAllocation_ );
     vkDestroyDescriptorSetLayout( logicalDevice_, descriptorSetLayout_, nullptr );
+    vkDestroyDescriptorPool( logicalDevice_, bindlessDescriptorPool_, nullptr );
+    vkDestroyDescriptorSetLayout( logicalDevice_, bindlessDescriptorSetLayout_, nullptr );
+    vkDestroyBuffer( logicalDevice_, materialBuffer_, nullptr );
+    memoryAllocator_.free( materialBufferAllocation_ );
     vkDestroyBuffer( logicalDevice_, indexBuffer_, nullptr );
-    vkFreeMemory( logicalDevice_, indexBufferMemory_, nullptr );
+    memoryAllocator_.free( indexBufferAllocation_ );
     vkDestroyBuffer( logicalDevice_, vertexBuffer_, nullptr );
-    vkFreeMemory( logicalDevice_, vertexBufferMemory_, nullptr );
+    memoryAllocator_.free( vertexBufferAllocation_ );
     cleanupSynchronizationObjects();
+    cleanupUploads();
     vkDestroyCommandPool( logicalDevice_, graphicCommandPool_, nullptr );
     vkDestroyCommandPool( logicalDevice_, transfertCommandPool_, nullptr );
+    vkDestroyCommandPool( logicalDevice_, graphicUploadCommandPool_, nullptr );
+
+    for( auto &&context : recordingContexts_ )
+      vkDestroyCommandPool( logicalDevice_, context.commandPool, nullptr );
+
+    for( auto &&context : cullingContexts_ )
+      vkDestroyCommandPool( logicalDevice_, context.commandPool, nullptr );
+
+    // destroying a pool frees its command buffers
+    for( auto &&frame : frameContexts_ )
+    {
+      vkDestroyCommandPool( logicalDevice_, frame.commandPool, nullptr );
+
+      for( auto &&context : frame.recordingContexts )
+        vkDestroyCommandPool( logicalDevice_, context.commandPool, nullptr );
+    }
+    memoryAllocator_.destroy();
     vkDestroyDevice( logicalDevice_, nullptr );
     destroyDebugUtilsMessengerEXT( vulkanInstance_, debugMessenger_, nullptr );
-    vkDestroySurfaceKHR( vulkanInstance_, surface_, nullptr );
+
+    if( !isHeadless() )
+      vkDestroySurfaceKHR( vulkanInstance_, surface_, nullptr );
+
     vkDestroyInstance( vulkanInstance_, nullptr );
+
+    if( isHeadless() )
+      return;
+
     glfwDestroyWindow( window_ );
     glfwTerminate();
   }
@@ -2074,29 +8418,20 @@ private:
       func( instance, debugMessenger, pAllocator );
   }
 
-  static std::vector< char > loadShaderModule( const std::filesystem::path &path )
+  static void framebufferResizeCallback( GLFWwindow *window, int, int )
   {
-    std::ifstream file{ path, std::ios::ate | std::ios::binary };
-
-    if( !file.is_open() )
-      throw std::runtime_error{ "Error while loading shader module" };
-
-    const auto fileSize = static_cast< std::size_t >( file.tellg() );
-    std::vector< char > shaderModuleContent;
-    shaderModuleContent.resize( fileSize );
-
-    file.seekg( 0 );
-    file.read( shaderModuleContent.data(), fileSize );
-
-    file.close();
-
-    return shaderModuleContent;
+    auto app = reinterpret_cast< VulkanApplication * >( glfwGetWindowUserPointer( window ) );
+    app->framebufferResized_ = true;
   }
 
-  static void framebufferResizeCallback( GLFWwindow *window, int, int )
+  static void keyCallback( GLFWwindow *window, int key, int, int action, int )
   {
+    if( key != GLFW_KEY_Z || action != GLFW_PRESS )
+      return;
+
+    // picked up by the next simulated frame
     auto app = reinterpret_cast< VulkanApplication * >( glfwGetWindowUserPointer( window ) );
-    app->framebufferResized_ = true;
+    app->requestedDepthPrePass_ = !app->requestedDepthPrePass_;
   }
 
 private:
@@ -2105,6 +8440,8 @@ private:
     std::optional< std::uint32_t > graphicsQueueFamilyIndex;
     std::optional< std::uint32_t > presentationQueueFamilyIndex;
     std::optional< std::uint32_t > transfertQueueFamilyIndex;
+    // optional, a compute family without graphics support running the culling asynchronously
+    std::optional< std::uint32_t > computeQueueFamilyIndex;
 
     constexpr bool isComplete() const noexcept
     {
@@ -2123,6 +8460,9 @@ private:
         presentationQueueFamilyIndex.value(),
         transfertQueueFamilyIndex.value() } );
 
+      if( isComplete() && computeQueueFamilyIndex.has_value() )
+        set.insert( computeQueueFamilyIndex.value() );
+
       return set;
     }
   };
@@ -2141,9 +8481,37 @@ private:
 
   struct UniformBufferObject
   {
-    alignas( 16 ) glm::mat4 model;
     alignas( 16 ) glm::mat4 view;
     alignas( 16 ) glm::mat4 proj;
+    alignas( 16 ) glm::vec4 positionScale;
+    alignas( 16 ) glm::vec4 positionOffset;
+    // bindless textures from this index on are still streaming in, the placeholder is sampled instead
+    std::uint32_t residentTextureCount;
+  };
+
+  // std430 element of the material storage buffer
+  struct MaterialData
+  {
+    alignas( 16 ) glm::vec4 tint;
+    std::uint32_t textureIndex;
+  };
+
+  // push constants of cull.comp, one vector component per level of detail
+  struct CullingParameters
+  {
+    glm::vec4 boundingSphere;
+    glm::vec4 lodErrors{ 0.0f };
+    glm::uvec4 lodFirstDraws{ 0 };
+    glm::uvec4 lodFirstIndices{ 0 };
+    glm::uvec4 lodIndexCounts{ 0 };
+    float lodPixelScale;
+    std::uint32_t instanceCount;
+    std::uint32_t indicesPerDrawRange;
+    std::uint32_t drawCount;
+    std::uint32_t lodCount;
+    std::uint32_t finestLod;
+    std::uint32_t coarsestLod;
+    std::uint32_t pass;
   };
 
   struct TexturePixelsBuffer
@@ -2156,63 +8524,221 @@ private:
 
 private:
   std::filesystem::path applicationPath_;
+  ApplicationOptions options_;
+  Profiler profiler_;
+  JobSystem jobSystem_;
+  // per instance placement on the grid, spun by composeInstances() every frame
+  InstanceTransforms instanceTransforms_;
+  VkQueryPool timestampQueryPool_{};
+  std::uint64_t timestampMask_{};
+  // frame that last submitted each draw command buffer, until its timestamps are read back
+  std::vector< std::optional< std::uint64_t > > timestampQueryFrames_;
+  Profiler::Clock::time_point lastWindowTitleUpdate_;
   GLFWwindow *window_{};
   VkInstance vulkanInstance_{};
   VkDebugUtilsMessengerEXT debugMessenger_{};
   VkSurfaceKHR surface_{};
   VkPhysicalDeviceFeatures requiredPhysicalDeviceFeatures_{};
+  VkPhysicalDeviceVulkan12Features requiredVulkan12Features_{ .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES } };
   VkPhysicalDevice physicalDevice_{};
+  VkPhysicalDeviceProperties physicalDeviceProperties_{};
+  // descriptor indexing limits among others
+  VkPhysicalDeviceVulkan12Properties physicalDeviceVulkan12Properties_{ .sType{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES } };
   VkDevice logicalDevice_{};
+  DeviceMemoryAllocator memoryAllocator_;
   RequiredQueueFamilyIndices requiredQueueFamilyIndices_{};
   VkQueue graphicsQueue_{};
   VkQueue presentationQueue_{};
   VkQueue transfertQueue_{};
+  VkQueue computeQueue_{};
   SwapChainSupportDetails swapChainSupportDetails_{};
   VkSwapchainKHR swapChain_{};
   VkSurfaceFormatKHR swapChainSurfaceFormat_{};
   VkExtent2D swapChainExtent_{};
   std::vector< VkImage > swapChainImages_;
   std::vector< VkImageView > swapChainImageViews_;
+  // backs swapChainImages_ in headless mode only
+  std::vector< DeviceMemoryAllocation > offscreenImageAllocations_;
   VkRenderPass renderPass_;
   VkDescriptorSetLayout descriptorSetLayout_;
+  VkDescriptorSetLayout bindlessDescriptorSetLayout_;
+  VkPipelineCache pipelineCache_;
+  ShaderManager shaderManager_;
   VkPipelineLayout pipelineLayout_;
   std::vector< VkPipeline > graphicPipelines_;
   std::vector< VkFramebuffer > swapChainFramebuffers_;
   VkCommandPool graphicCommandPool_;
   VkCommandPool transfertCommandPool_;
+  VkCommandPool graphicUploadCommandPool_;
+  VkSemaphore uploadTimelineSemaphore_;
+  // signaled by every frame submission with the count of frames submitted so far
+  VkSemaphore frameTimelineSemaphore_;
+  std::uint64_t frameTimelineValue_{};
+  std::deque< RetiredSwapChain > retiredSwapChains_;
+  std::uint64_t uploadTimelineValue_{ 0 };
+  std::optional< UploadBatch > uploadBatch_;
+  std::deque< UploadBatch > pendingUploadBatches_;
+  StagingRing stagingRing_;
   std::vector< VkCommandBuffer > commandBuffers_;
+  // prebaked mode only, partitions of the draw list, grouped by swap chain image
+  std::vector< VkCommandBuffer > secondaryCommandBuffers_;
+  std::vector< RecordingContext > recordingContexts_;
+  std::vector< FrameContext > frameContexts_;
+  std::vector< CullingContext > cullingContexts_;
+  std::vector< MeshLod > meshLods_;
+  std::vector< DrawRange > drawList_;
+  LodSelection frameLodSelection_{};
   std::vector< VkSemaphore > imageAvailableSemaphore_;
   std::vector< VkSemaphore > renderFinishedSemaphore_;
   std::uint8_t currentFrame_{ 0 };
   std::vector< VkFence > inFlightFences_;
   std::vector< VkFence > inFlightImageFences_;
   std::uint8_t maxFrameInFlight_{ 0 };
-  bool framebufferResized_{ false };
-  std::vector< Vertex > vertices_;
-  std::vector< std::uint32_t > indices_;
+  // present ids start at 1, a frame slot that has not presented anything yet keeps 0
+  std::vector< std::uint64_t > framePresentIds_;
+  std::uint64_t lastPresentId_{};
+  std::uint64_t firstSwapChainPresentId_{ 1 };
+#ifdef VK_KHR_present_wait
+  PFN_vkWaitForPresentKHR waitForPresent_{};
+#endif // VK_KHR_present_wait
+  bool isMemoryBudgetEnabled_{ false };
+  // written by the window callbacks on the simulation thread
+  std::atomic< bool > framebufferResized_{ false };
+  std::atomic< std::uint64_t > framebufferExtent_{};
+  bool requestedDepthPrePass_{ false };
+  std::uint64_t simulatedFrameCount_{};
+  // the simulation runs at most two frames ahead of the submission, that hands over one frame at a time to the recording
+  SpscQueue< SimulatedFrame, 2 > simulatedFrames_;
+  SpscQueue< FrameRecording, 1 > frameRecordings_;
+  SpscQueue< std::uint32_t, 1 > recordedFrames_;
+  // owned by the submission stage from here on
+  bool isSwapChainOutOfDate_{ false };
+  bool depthPrePassEnabled_{ false };
+  // streaming workers, the render thread uploads what they decode then publishes it once its upload is complete
+  std::future< std::unique_ptr< MeshAsset > > meshStreaming_;
+  std::future< std::unique_ptr< DecodedTexture > > textureStreaming_;
+  std::optional< PendingMesh > pendingMesh_;
+  std::optional< std::uint64_t > pendingTextureUploadValue_;
+  PositionQuantization positionQuantization_;
+  VkIndexType meshIndexType_{ VK_INDEX_TYPE_UINT16 };
   VkBuffer vertexBuffer_;
-  VkDeviceMemory vertexBufferMemory_{};
+  DeviceMemoryAllocation vertexBufferAllocation_;
   VkBuffer indexBuffer_;
-  VkDeviceMemory indexBufferMemory_;
-  std::vector< VkBuffer > uniformBuffers_;
-  std::vector< VkDeviceMemory > uniformBuffersMemory_;
+  DeviceMemoryAllocation indexBufferAllocation_;
+  VkBuffer uniformBuffer_;
+  DeviceMemoryAllocation uniformBufferAllocation_;
+  VkDeviceSize uniformBufferSlotSize_{};
+  VkBuffer instanceBuffer_;
+  DeviceMemoryAllocation instanceBufferAllocation_;
+  VkDeviceSize instanceBufferSlotSize_{};
+  VkBuffer visibleInstanceBuffer_;
+  DeviceMemoryAllocation visibleInstanceBufferAllocation_;
+  VkDeviceSize visibleInstanceBufferSlotSize_{};
+  VkBuffer indirectCommandBuffer_;
+  DeviceMemoryAllocation indirectCommandBufferAllocation_;
+  VkDeviceSize indirectCommandBufferSlotSize_{};
+  VkPipelineLayout cullingPipelineLayout_;
+  VkPipeline cullingPipeline_;
+  glm::vec4 meshBoundingSphere_{};
   VkDescriptorPool descriptorPool_;
-  std::vector< VkDescriptorSet > descriptorSets_;
-  VkImage textureImage_;
-  VkDeviceMemory textureImageMemory_;
-  VkImageView textureImageView_;
+  VkDescriptorSet descriptorSet_;
+  VkDescriptorPool bindlessDescriptorPool_;
+  VkDescriptorSet bindlessDescriptorSet_;
+  std::uint32_t bindlessTextureCount_{};
+  VkBuffer materialBuffer_;
+  DeviceMemoryAllocation materialBufferAllocation_;
+  VkImage placeholderTextureImage_{};
+  DeviceMemoryAllocation placeholderTextureImageAllocation_;
+  VkImageView placeholderTextureImageView_{};
+  // reserved from the start, sampled once streamed in
+  std::uint32_t streamedTextureIndex_{};
+  std::uint32_t residentTextureCount_{};
+  VkImage textureImage_{};
+  DeviceMemoryAllocation textureImageAllocation_;
+  VkImageView textureImageView_{};
   VkSampler textureSampler_;
+  std::uint32_t textureMipLevels_{ 1 };
+  VkFormat textureFormat_{ VK_FORMAT_R8G8B8A8_SRGB };
   VkImage depthImage_;
-  VkDeviceMemory depthImageMemory_;
+  DeviceMemoryAllocation depthImageAllocation_;
   VkImageView depthImageView_;
+  // multisampled color, resolved to the swap chain image
+  VkImage colorImage_{};
+  DeviceMemoryAllocation colorImageAllocation_;
+  VkImageView colorImageView_{};
+  VkSampleCountFlagBits msaaSamples_{ VK_SAMPLE_COUNT_1_BIT };
 
 private:
   inline static constexpr int windowWidth_{ 800 };
   inline static constexpr int windowHeight_{ 600 };
+  // as many images as a typical triple buffered swap chain
+  inline static constexpr std::uint8_t offscreenImageCount_{ 3 };
+  inline static constexpr float benchmarkFrameDuration_{ 1.0f / 60.0f };
+  // the chalet model fits in a 2x2 square
+  inline static constexpr float instanceSpacing_{ 2.5f };
+  inline static constexpr float instancePhase_{ 0.7f };
+  inline static constexpr std::uint32_t maxBindlessTextureCount_{ 1024 };
+  inline static const glm::vec3 placeholderMeshCenter_{ 0.0f, 0.0f, 0.5f };
+  inline static const glm::vec3 placeholderMeshHalfExtent_{ 1.0f, 1.0f, 0.5f };
+  inline static const glm::vec4 materialTints_[]
+  {
+    glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f ),
+    glm::vec4( 1.0f, 0.85f, 0.7f, 1.0f ),
+    glm::vec4( 0.75f, 0.9f, 1.0f, 1.0f ),
+    glm::vec4( 0.8f, 1.0f, 0.8f, 1.0f )
+  };
+  inline static constexpr std::uint32_t materialCount_{ sizeof( materialTints_ ) / sizeof( glm::vec4 ) };
+  inline static constexpr std::uint32_t instancesPerUpdateTask_{ 4096 };
+  // averaged over that many frames, the first ones warming the caches up
+  inline static constexpr std::uint32_t transformBenchmarkIterationCount_{ 200 };
+  // local_size_x of cull.comp
+  inline static constexpr std::uint32_t cullingGroupSize_{ 64 };
+
+  // large enough to hold the whole chalet texture, bigger uploads fall back to a dedicated staging buffer
+  inline static constexpr VkDeviceSize stagingRingSize_{ 64 * 1024 * 1024 };
+  // multiple of any texel or compressed block size
+  inline static constexpr VkDeviceSize bufferUploadAlignment_{ 16 };
+  // below that, spawning a thread costs more than deduplicating
+  inline static constexpr std::size_t minimumIndicesPerImportChunk_{ 64 * 1024 };
+  // bumped whenever the imported geometry changes, i.e. a new optimization stage
+  inline static constexpr std::uint32_t meshCacheVersion_{ 4 };
+  // a compositor may never report a present, frames then fall back to their fence
+  inline static constexpr std::uint64_t presentWaitTimeout_{ 100'000'000 };
+  inline static constexpr double simulationRetryTimeout_{ 0.001 };
+  inline static constexpr std::uint64_t closedWindowExtent_{ std::numeric_limits< std::uint64_t >::max() };
+  // left for the swap chain recreation and the per frame allocations when a texture is sized against the budget
+  inline static constexpr VkDeviceSize memoryBudgetMargin_{ 64 * 1024 * 1024 };
+  // a level that does not remove at least a sixth of the triangles of the previous one is not worth a switch
+  inline static constexpr double minimumLodReductionRatio_{ 5.0 / 6.0 };
+  inline static constexpr float lodPixelErrorThreshold_{ 1.0f };
+  // in degrees
+  inline static constexpr float verticalFieldOfView_{ 45.0f };
+  inline static constexpr std::size_t trianglesPerOverdrawCluster_{ 256 };
+  // a conservative estimate of the post transform cache of actual GPUs
+  inline static constexpr std::size_t meshCacheMissRatioCacheSize_{ 16 };
+  inline static constexpr std::uint32_t indicesPerDrawRange_{ 3 * 4096 };
+  // below that, a worker spends more time beginning and ending its secondary command buffer than recording draws
+  inline static constexpr std::size_t minimumDrawsPerPartition_{ 16 };
 
   inline static constexpr std::size_t requiredPhysicalDeviceFeatureOffsets_[]
   {
-    offsetof( VkPhysicalDeviceFeatures, samplerAnisotropy )
+    offsetof( VkPhysicalDeviceFeatures, samplerAnisotropy ),
+    // one indirect call per recording partition
+    offsetof( VkPhysicalDeviceFeatures, multiDrawIndirect ),
+    // each level of detail draws its own slice of the visible instances
+    offsetof( VkPhysicalDeviceFeatures, drawIndirectFirstInstance )
+  };
+
+  inline static constexpr std::size_t requiredVulkan12FeatureOffsets_[]
+  {
+    offsetof( VkPhysicalDeviceVulkan12Features, timelineSemaphore ),
+    // the bindless texture array, sized at allocation, partially written and indexed per material
+    offsetof( VkPhysicalDeviceVulkan12Features, runtimeDescriptorArray ),
+    offsetof( VkPhysicalDeviceVulkan12Features, descriptorBindingPartiallyBound ),
+    offsetof( VkPhysicalDeviceVulkan12Features, descriptorBindingVariableDescriptorCount ),
+    offsetof( VkPhysicalDeviceVulkan12Features, descriptorBindingSampledImageUpdateAfterBind ),
+    offsetof( VkPhysicalDeviceVulkan12Features, descriptorBindingUpdateUnusedWhilePending ),
+    offsetof( VkPhysicalDeviceVulkan12Features, shaderSampledImageArrayNonUniformIndexing )
   };
 
   inline static const std::vector< const char * > vulkanValidationLayers_
@@ -2232,16 +8758,25 @@ private:
   };
 
   inline static const std::filesystem::path textureRelativePath_{ "textures/chalet.jpg" };
+  // precooked, mip mapped versions of the texture, preferred over the jpeg when present
+  inline static const std::filesystem::path compressedTextureRelativePaths_[]
+  {
+    "textures/chalet.bc7.ktx2",
+    "textures/chalet.astc.ktx2",
+    "textures/chalet.etc2.ktx2"
+  };
   inline static const std::filesystem::path objRelativePath_{ "models/chalet.obj" };
+  inline static const std::filesystem::path cacheRelativeDirectory_{ "cache" };
+  inline static const std::filesystem::path pipelineCacheRelativePath_{ cacheRelativeDirectory_ / "pipeline.cache" };
 };
 
 int main( int argc, char *argv[] )
 {
-  // assuming program path is specified in argv[ 0 ], that might not necessary be the case, fragile assumption but working in that context
-  VulkanApplication app{ argv[ 0 ] };
-
   try
   {
+    // assuming program path is specified in argv[ 0 ], that might not necessary be the case, fragile assumption but working in that context
+    VulkanApplication app{ argv[ 0 ], parseApplicationOptions( argc, argv ) };
+
     app.run();
   }
   catch( const std::exception &e )
@@ -1,14 +1,48 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
 
-layout( location = 0 ) in vec3 fragColor;
-layout( location = 1 ) in vec2 fragTexturePosition;
+layout( location = 0 ) in vec2 fragTexturePosition;
+layout( location = 1 ) flat in uint fragMaterialIndex;
 
-layout( binding = 1 ) uniform sampler2D textureSampler;
+layout( set = 0, binding = 0 ) uniform UniformBufferObject
+{
+  mat4 view;
+  mat4 proj;
+  vec4 positionScale;
+  vec4 positionOffset;
+  uint residentTextureCount;
+} ubo;
+
+struct MaterialData
+{
+  vec4 tint;
+  uint textureIndex;
+};
+
+layout( std430, set = 1, binding = 0 ) readonly buffer MaterialBuffer
+{
+  MaterialData records[];
+} materials;
+
+layout( set = 1, binding = 1 ) uniform sampler textureSampler;
+
+// bindless, only the registered textures are written and only the resident ones are indexed
+layout( set = 1, binding = 2 ) uniform texture2D textures[];
+
+// sampled in place of the textures still streaming in
+const uint placeholderTextureIndex = 0;
 
 layout( location = 0 ) out vec4 outColor;
 
 void main()
 {
-  outColor = vec4( texture( textureSampler, fragTexturePosition ).rgb * fragColor, 1.0 );
+  MaterialData material = materials.records[ fragMaterialIndex ];
+
+  uint textureIndex = material.textureIndex < ubo.residentTextureCount ? material.textureIndex : placeholderTextureIndex;
+
+  // instances of a single draw may use different materials
+  vec4 color = texture( sampler2D( textures[ nonuniformEXT( textureIndex ) ], textureSampler ), fragTexturePosition );
+
+  outColor = vec4( color.rgb * material.tint.rgb, 1.0 );
 }
\ No newline at end of file
@@ -4,21 +4,50 @@
 
 layout( set = 0, binding = 0 ) uniform UniformBufferObject
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
+    vec4 positionScale;
+    vec4 positionOffset;
 } ubo;
 
+struct InstanceData
+{
+    mat4 model;
+    uint materialIndex;
+};
+
+layout( std430, set = 0, binding = 2 ) readonly buffer InstanceBuffer
+{
+    InstanceData records[];
+} instances;
+
+// filled by the culling pass, the instances that survived it grouped by level of detail, the draws of each level start at its group
+layout( std430, set = 0, binding = 3 ) readonly buffer VisibleInstanceBuffer
+{
+    uint counts[ 4 ];
+    uint indices[];
+} visibleInstances;
+
+// set per pipeline variant, only the compact vertex layout is quantized
+layout( constant_id = 0 ) const bool dequantizePositions = true;
+
+// either full precision or quantized over the mesh bounds, dequantized with the uniform buffer scale and offset
 layout( location = 0 ) in vec3 inPosition;
-layout( location = 1 ) in vec3 inColor;
-layout( location = 2 ) in vec2 inTexturePosition;
+layout( location = 1 ) in vec2 inTexturePosition;
    
-layout( location = 0 ) out vec3 fragColor;
-layout( location = 1 ) out vec2 fragTexturePosition;
+layout( location = 0 ) out vec2 fragTexturePosition;
+layout( location = 1 ) flat out uint fragMaterialIndex;
+
+// bit exact with depth.vert, the color pass only shades the fragments the depth pre-pass left
+invariant gl_Position;
 
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4( inPosition, 1.0 );
-    fragColor = inColor;
+    vec3 position = dequantizePositions ? inPosition * ubo.positionScale.xyz + ubo.positionOffset.xyz : inPosition;
+
+    InstanceData instance = instances.records[ visibleInstances.indices[ gl_InstanceIndex ] ];
+
+    gl_Position = ubo.proj * ubo.view * instance.model * vec4( position, 1.0 );
     fragTexturePosition = inTexturePosition;
+    fragMaterialIndex = instance.materialIndex;
 }